@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+
+/**
+ * @brief Hidden window with a 4.3 core context (OceanFFT creates its
+ *        textures on initialize, the GPU paths need compute shaders)
+ * @return nullptr after printing the error
+ */
+inline GLFWwindow* createBenchContext(const char* title) {
+    if (!glfwInit()) {
+        std::cerr << "ERROR: Failed to initialize GLFW\n";
+        return nullptr;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, title, nullptr, nullptr);
+    if (!window) {
+        std::cerr << "ERROR: Failed to create GLFW window\n";
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "ERROR: Failed to initialize GLAD\n";
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+    std::cout << "GL " << glGetString(GL_VERSION) << " / " << glGetString(GL_RENDERER) << "\n";
+    return window;
+}
+
+inline void destroyBenchContext(GLFWwindow* window) {
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
@@ -0,0 +1,71 @@
+// Buoyancy benchmark: 10k floating bodies of 8 sample points each on a
+// three-cascade ocean. Reports the time per BuoyancySolver::step().
+//
+// Usage: BuoyancyBench [bodies] [steps]
+
+#include "BenchContext.h"
+#include "BuoyancySolver.h"
+#include "OceanFFT.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+int main(int argc, char** argv) {
+    int bodyCount = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int steps = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    GLFWwindow* window = createBenchContext("BuoyancyBench");
+    if (!window) return 1;
+
+    int result = 0;
+    {
+        const float L = 1000.0f;
+        OceanFFT ocean(256, L);
+        ocean.setCascades(OceanFFT::makeCascades(L, 3, true));
+        ocean.setVelocityEnabled(true);
+        if (!ocean.initialize()) return 1;
+
+        // Boxes of 2 x 1 x 4 m sampled at their corners, spread over the patch
+        std::vector<BuoyancySolver::SamplePoint> hull;
+        for (int i = 0; i < 8; ++i) {
+            glm::vec3 corner((i & 1) ? 1.0f : -1.0f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 2.0f : -2.0f);
+            hull.push_back({ 0.8f * corner, 0.5f });
+        }
+        BuoyancySolver solver;
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> spread(0.0f, L);
+        for (int b = 0; b < bodyCount; ++b) {
+            BuoyancySolver::BodyDesc body;
+            body.position = glm::vec3(spread(rng), 0.0f, spread(rng));
+            body.mass = 2500.0f;
+            body.inertia = glm::vec3(3500.0f, 4200.0f, 1100.0f);
+            solver.addBody(body, hull);
+        }
+
+        std::cout << bodyCount << " bodies, " << solver.getSamplePointCount() << " sample points, "
+                  << ocean.getThreadPool().getThreadCount() << " threads\n";
+
+        const float dt = 1.0f / 60.0f;
+        double total = 0.0;
+        double best = 1e30;
+        for (int s = 0; s < steps; ++s) {
+            ocean.update(s * dt);
+            auto start = std::chrono::steady_clock::now();
+            solver.step(ocean, dt);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            total += ms;
+            best = std::min(best, ms);
+        }
+
+        float submerged = 0.0f;
+        for (int b = 0; b < bodyCount; ++b) submerged += solver.getSubmergedVolume(b);
+        std::cout << "step: " << total / steps << " ms average, " << best << " ms best ("
+                  << total / steps * 1e6 / bodyCount << " ns per body)\n";
+        std::cout << "mean submerged volume: " << submerged / bodyCount << " m^3\n";
+    }
+
+    destroyBenchContext(window);
+    return result;
+}
@@ -0,0 +1,134 @@
+// Depth region check: an ocean simulated for three water depths over a
+// shelf that rises along -x. Compares sampleSurface with probe where the
+// regions blend (CPU fields and GPU readback), checks the height bounds
+// and reports the cost per update against deep water alone.
+//
+// Usage: DepthRegionBench [N] [steps] (from a directory holding shaders/,
+// such as the build directory)
+
+#include "BenchContext.h"
+#include "OceanFFT.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+double millisecondsPerUpdate(OceanFFT& ocean, double& time, int steps) {
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s) {
+        time += 1.0 / 30.0;
+        ocean.update(time);
+    }
+    glFinish();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / steps;
+}
+
+/**
+ * @brief Largest |sampleSurface - probe| height over the points, at the surface time
+ */
+float largestProbeGap(const OceanFFT& ocean, const std::vector<float>& x, const std::vector<float>& z) {
+    int count = static_cast<int>(x.size());
+    std::vector<float> height(count);
+    OceanFFT::SurfaceSamples samples;
+    samples.height = height.data();
+    ocean.sampleSurface(count, x.data(), z.data(), samples, OceanFFT::SampleFilter::Bilinear, 0);
+    std::vector<glm::vec3> displacement(count);
+    ocean.probe(count, x.data(), z.data(), ocean.getSurfaceTime(), displacement.data());
+
+    float gap = 0.0f;
+    for (int i = 0; i < count; ++i) gap = std::max(gap, std::abs(height[i] - displacement[i].y));
+    return gap;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int N = argc > 1 ? std::atoi(argv[1]) : 128;
+    int steps = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    GLFWwindow* window = createBenchContext("DepthRegionBench");
+    if (!window) return 1;
+
+    int result = 0;
+    {
+        const float L = 1000.0f;
+        OceanFFT ocean(N, L);
+        ocean.setCascades(OceanFFT::makeCascades(L, 2, false));
+        ocean.setHeightBoundsEnabled(true);
+        if (!ocean.initialize()) return 1;
+
+        double time = 1.0;
+        double deep = millisecondsPerUpdate(ocean, time, steps);
+
+        // Depth from 1 m at x = -L/2 to 200 m at x = L/2, exponential in x
+        if (!ocean.setDepthRegions({ 3.0f, 12.0f, 60.0f })) return 1;
+        const int size = 64;
+        std::vector<float> depths(static_cast<size_t>(size) * size);
+        for (int j = 0; j < size; ++j) {
+            for (int i = 0; i < size; ++i) {
+                depths[static_cast<size_t>(j) * size + i] = std::pow(200.0f, (i + 0.5f) / size);
+            }
+        }
+        ocean.setBathymetry(depths, size, glm::vec2(-0.5f * L), L);
+        double regions = millisecondsPerUpdate(ocean, time, steps);
+        std::cout << ocean.getDepthRegionCount() << " regions x " << ocean.getCascadesPerRegion()
+                  << " cascades: " << regions << " ms per update, deep water alone " << deep << " ms\n";
+
+        // Region weights along the shelf
+        for (float x : { -450.0f, -100.0f, 100.0f, 450.0f }) {
+            float weights[OceanFFT::MAX_DEPTH_REGIONS] = {};
+            ocean.getRegionWeights(x, 0.0f, weights);
+            std::cout << "x=" << x << " m: weights";
+            for (int r = 0; r < ocean.getDepthRegionCount(); ++r) std::cout << " " << weights[r];
+            std::cout << "\n";
+        }
+
+        // Texels of the larger patch across the shelf, where the smaller
+        // patch has texels too
+        std::vector<float> x;
+        std::vector<float> z;
+        for (int j = 0; j < N; j += 7) {
+            for (int i = 0; i < N; i += 3) {
+                x.push_back(i * L / N - 0.5f * L);
+                z.push_back(j * L / N);
+            }
+        }
+        float cpuGap = largestProbeGap(ocean, x, z);
+        std::cout << "CPU fields: sampleSurface within " << cpuGap << " m of probe\n";
+
+        // Bounds over the whole shelf contain every sample
+        std::vector<float> height(x.size());
+        OceanFFT::SurfaceSamples samples;
+        samples.height = height.data();
+        ocean.sampleSurface(static_cast<int>(x.size()), x.data(), z.data(), samples,
+                            OceanFFT::SampleFilter::Bilinear, 0);
+        glm::vec2 bounds = ocean.getHeightBounds(-0.5f * L, 0.0f, 0.5f * L, L);
+        auto range = std::minmax_element(height.begin(), height.end());
+        std::cout << "heights " << *range.first << " to " << *range.second << " m, bounds " << bounds.x << " to "
+                  << bounds.y << " m\n";
+        if (*range.first < bounds.x || *range.second > bounds.y) result = 1;
+
+        // The same on the GPU path, through the readback
+        if (ocean.setGPUSimulation(true)) {
+            ocean.setGPUReadback(true, 0);
+            for (int s = 0; s < 4; ++s) {
+                time += 1.0 / 30.0;
+                ocean.update(time);
+            }
+            glFinish();
+            float gpuGap = largestProbeGap(ocean, x, z);
+            std::cout << "GPU readback: sampleSurface within " << gpuGap << " m of probe\n";
+            if (gpuGap > 1e-3f) result = 1;
+        } else {
+            std::cout << "GPU simulation not available\n";
+        }
+        if (cpuGap > 1e-3f) result = 1;
+    }
+
+    destroyBenchContext(window);
+    return result;
+}
@@ -0,0 +1,73 @@
+// FFT backend benchmark: batched 2D inverse c2r transforms of the sizes the
+// simulator uses, on every backend of this build. Reports the time per
+// plane and the largest difference to the first backend.
+//
+// Usage: FFTBench [batch] [repeats]
+
+#include "FFTBackend.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main(int argc, char** argv) {
+    int batch = argc > 1 ? std::atoi(argv[1]) : 5;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    std::vector<FFTBackend::Type> types;
+    for (FFTBackend::Type type : { FFTBackend::Type::FFTW, FFTBackend::Type::Builtin }) {
+        if (FFTBackend::isAvailable(type)) types.push_back(type);
+    }
+
+    for (int N = 64; N <= 1024; N *= 2) {
+        size_t spectrumSize = static_cast<size_t>(N) * (N / 2 + 1);
+        size_t planeSize = static_cast<size_t>(N) * N;
+
+        std::mt19937 rng(N);
+        std::normal_distribution<float> gauss(0.0f, 1.0f);
+        std::vector<std::complex<float>> input(spectrumSize * batch);
+        for (std::complex<float>& c : input) c = std::complex<float>(gauss(rng), gauss(rng));
+
+        std::vector<float> reference;
+        for (FFTBackend::Type type : types) {
+            std::unique_ptr<FFTBackend> backend = FFTBackend::create(type);
+            std::vector<std::complex<float>> spectra(input.size());
+            std::vector<float> planes(planeSize * batch);
+            std::unique_ptr<FFTPlan> plan = backend->planInverse2D(N, batch, spectra.data(), planes.data(), false);
+            if (!plan) {
+                std::cerr << "ERROR: " << backend->getName() << " cannot plan N=" << N << "\n";
+                return 1;
+            }
+
+            // Transforms overwrite their input: restore it before each run
+            double seconds = 0.0;
+            for (int r = 0; r < repeats + 1; ++r) {
+                std::copy(input.begin(), input.end(), spectra.begin());
+                auto start = std::chrono::steady_clock::now();
+                plan->execute(spectra.data(), planes.data());
+                auto end = std::chrono::steady_clock::now();
+                if (r > 0) seconds += std::chrono::duration<double>(end - start).count();
+            }
+
+            float maxError = 0.0f;
+            float maxValue = 0.0f;
+            if (reference.empty()) {
+                reference = planes;
+            } else {
+                for (size_t i = 0; i < planes.size(); ++i) {
+                    maxError = std::max(maxError, std::abs(planes[i] - reference[i]));
+                    maxValue = std::max(maxValue, std::abs(reference[i]));
+                }
+            }
+
+            std::cout << "N=" << N << " " << backend->getName() << ": "
+                      << 1000.0 * seconds / (repeats * batch) << " ms per plane";
+            if (maxValue > 0.0f) std::cout << ", max relative difference " << maxError / maxValue;
+            std::cout << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+// GPU simulation check: the same ocean simulated on the CPU and in compute
+// shaders (setGPUSimulation), with normals derived on the GPU
+// (setGPUNormals) and sampled from the GPU readback (setGPUReadback).
+// Reports the largest differences to the CPU path and the time per update.
+//
+// Usage: GPUSimulationBench [N] [steps] (from a directory holding shaders/,
+// such as the build directory)
+
+#include "BenchContext.h"
+#include "OceanFFT.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief One mip level of every layer of an RGB array texture
+ */
+std::vector<float> readLayers(GLuint texture, int level, int size, int layers) {
+    std::vector<float> texels(static_cast<size_t>(size) * size * 3 * layers);
+    GLint alignment = 4;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glGetTexImage(GL_TEXTURE_2D_ARRAY, level, GL_RGB, GL_FLOAT, texels.data());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+    return texels;
+}
+
+/**
+ * @brief Newest displacement and normal layers of every cascade at one level
+ */
+struct Snapshot {
+    std::vector<float> displacement;
+    std::vector<float> normal;
+};
+
+Snapshot capture(const OceanFFT& ocean, int level) {
+    const int size = ocean.getResolution() >> level;
+    const int layers = 2 * ocean.getCascadeCount();
+    const size_t layerSize = static_cast<size_t>(size) * size * 3;
+    std::vector<float> displacement = readLayers(ocean.getDisplacementTexture(), level, size, layers);
+    std::vector<float> normal = readLayers(ocean.getNormalTexture(), level, size, layers);
+
+    Snapshot snapshot;
+    for (int c = 0; c < ocean.getCascadeCount(); ++c) {
+        size_t offset = ocean.getCascadeLayer(c) * layerSize;
+        snapshot.displacement.insert(snapshot.displacement.end(), displacement.begin() + offset,
+                                     displacement.begin() + offset + layerSize);
+        snapshot.normal.insert(snapshot.normal.end(), normal.begin() + offset, normal.begin() + offset + layerSize);
+    }
+    return snapshot;
+}
+
+/**
+ * @brief Largest |a - b| relative to the largest |a|
+ */
+double relativeDifference(const std::vector<float>& a, const std::vector<float>& b) {
+    double error = 0.0;
+    double scale = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        error = std::max(error, static_cast<double>(std::abs(a[i] - b[i])));
+        scale = std::max(scale, static_cast<double>(std::abs(a[i])));
+    }
+    return scale > 0.0 ? error / scale : error;
+}
+
+/**
+ * @brief Largest angle between corresponding normals, in degrees
+ */
+double largestAngle(const std::vector<float>& a, const std::vector<float>& b) {
+    double angle = 0.0;
+    for (size_t i = 0; i + 2 < a.size(); i += 3) {
+        glm::vec3 p = glm::normalize(glm::vec3(a[i], a[i + 1], a[i + 2]));
+        glm::vec3 q = glm::normalize(glm::vec3(b[i], b[i + 1], b[i + 2]));
+        angle = std::max(angle, static_cast<double>(std::acos(std::min(glm::dot(p, q), 1.0f))));
+    }
+    return angle * 57.29577951308232;
+}
+
+double millisecondsPerUpdate(OceanFFT& ocean, double& time, int steps) {
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s) {
+        time += 1.0 / 30.0;
+        ocean.update(time);
+    }
+    glFinish();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / steps;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int N = argc > 1 ? std::atoi(argv[1]) : 256;
+    int steps = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    GLFWwindow* window = createBenchContext("GPUSimulationBench");
+    if (!window) return 1;
+
+    int result = 0;
+    {
+        // Float evolution on both paths, every cascade refreshed every step
+        const float L = 1000.0f;
+        std::vector<OceanFFT::CascadeDesc> cascades = OceanFFT::makeCascades(L, 2, false);
+        for (OceanFFT::CascadeDesc& desc : cascades) desc.precision = OceanFFT::Precision::Single;
+        OceanFFT ocean(N, L);
+        ocean.setCascades(cascades);
+        ocean.setAmplitude(0.002f);
+        ocean.setChoppy(1.3f);
+        if (!ocean.initialize()) return 1;
+
+        // Displacement and normals, CPU vs compute shaders (same h0)
+        for (double t : { 1.7, 250.3 }) {
+            for (int level : { 0, 2 }) {
+                ocean.setGPUSimulation(false);
+                ocean.update(t);
+                Snapshot cpu = capture(ocean, level);
+                if (!ocean.setGPUSimulation(true)) {
+                    std::cerr << "ERROR: GPU simulation is not available\n";
+                    return 1;
+                }
+                ocean.update(t);
+                glFinish();
+                Snapshot gpu = capture(ocean, level);
+                std::cout << "t=" << t << " level " << level << ": displacement "
+                          << relativeDifference(cpu.displacement, gpu.displacement) << ", normal "
+                          << relativeDifference(cpu.normal, gpu.normal) << " (max relative difference)\n";
+            }
+        }
+
+        // Normals derived from the displacement vs spectral normals. The
+        // derivation ignores the horizontal displacement, so compare flat.
+        ocean.setGPUSimulation(false);
+        ocean.setChoppy(0.0f);
+        ocean.update(3.3);
+        Snapshot spectral = capture(ocean, 0);
+        if (!ocean.setGPUNormals(true)) {
+            std::cerr << "ERROR: GPU normals are not available\n";
+            return 1;
+        }
+        ocean.update(3.3);
+        glFinish();
+        Snapshot derived = capture(ocean, 0);
+        std::cout << "GPU normals: displacement " << relativeDifference(spectral.displacement, derived.displacement)
+                  << " (max relative difference), normals within " << largestAngle(spectral.normal, derived.normal)
+                  << " degrees\n";
+        ocean.setGPUNormals(false);
+        ocean.setChoppy(1.3f);
+
+        // Readback: sampleSurface on the GPU path against the CPU fields at the readback's time
+        std::vector<float> x;
+        std::vector<float> z;
+        for (int j = 0; j < 64; ++j) {
+            for (int i = 0; i < 64; ++i) {
+                x.push_back(i * 13.7f);
+                z.push_back(j * 11.3f);
+            }
+        }
+        const int count = static_cast<int>(x.size());
+        std::vector<float> gpuHeight(count);
+        std::vector<float> cpuHeight(count);
+        ocean.setGPUSimulation(true);
+        ocean.setGPUReadback(true, 0);
+        double time = 5.0;
+        for (int s = 0; s < 4; ++s) {
+            time += 1.0 / 30.0;
+            ocean.update(time);
+        }
+        glFinish();
+        double surfaceTime = ocean.getSurfaceTime();
+        OceanFFT::SurfaceSamples samples;
+        samples.height = gpuHeight.data();
+        ocean.sampleSurface(count, x.data(), z.data(), samples);
+        ocean.setGPUReadback(false);
+        ocean.setGPUSimulation(false);
+        ocean.update(surfaceTime);
+        samples.height = cpuHeight.data();
+        ocean.sampleSurface(count, x.data(), z.data(), samples);
+        std::cout << "Readback: " << std::lround((time - surfaceTime) * 30.0) << " step(s) behind, heights "
+                  << relativeDifference(cpuHeight, gpuHeight) << " (max relative difference)\n";
+
+        // Cost per update on each path
+        std::cout << "CPU: " << millisecondsPerUpdate(ocean, time, steps) << " ms per update\n";
+        ocean.setGPUSimulation(true);
+        millisecondsPerUpdate(ocean, time, 1);
+        std::cout << "GPU: " << millisecondsPerUpdate(ocean, time, steps) << " ms per update\n";
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            std::cerr << "ERROR: GL error 0x" << std::hex << error << std::dec << "\n";
+            result = 1;
+        }
+    }
+
+    destroyBenchContext(window);
+    return result;
+}
@@ -0,0 +1,166 @@
+// Surface query check: probe against the FFT grid, the height pyramids
+// against dense samples and intersectRay against a brute-force march, on a
+// three-cascade ocean. Reports the largest errors and the cost per query.
+//
+// Usage: SurfaceQueryBench [N] [queries]
+
+#include "BenchContext.h"
+#include "OceanFFT.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief First crossing of the bilinear surface along a ray, in fixed steps
+ */
+bool marchRay(const OceanFFT& ocean, const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+              float step, float& distance) {
+    OceanFFT::SurfaceSamples samples;
+    float height = 0.0f;
+    samples.height = &height;
+    for (float t = 0.0f; t <= maxDistance; t += step) {
+        glm::vec3 p = origin + t * direction;
+        ocean.sampleSurface(1, &p.x, &p.z, samples);
+        if (p.y <= height) {
+            distance = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int N = argc > 1 ? std::atoi(argv[1]) : 128;
+    int queries = argc > 2 ? std::atoi(argv[2]) : 300;
+
+    GLFWwindow* window = createBenchContext("SurfaceQueryBench");
+    if (!window) return 1;
+
+    int result = 0;
+    {
+        const float L = 1000.0f;
+        OceanFFT ocean(N, L);
+        ocean.setCascades(OceanFFT::makeCascades(L, 3, false));
+        ocean.setAmplitude(0.002f);
+        ocean.setHeightBoundsEnabled(true);
+        if (!ocean.initialize()) return 1;
+        const double time = 12.5;
+        ocean.update(time);
+
+        // Probe at the texels of the largest patch, which are texels of every
+        // cascade (patches shrink by 4), against the FFT heights there
+        std::vector<float> x;
+        std::vector<float> z;
+        for (int j = 0; j < N; j += 3) {
+            for (int i = 0; i < N; i += 5) {
+                x.push_back(i * L / N);
+                z.push_back(j * L / N);
+            }
+        }
+        int count = static_cast<int>(x.size());
+        std::vector<float> height(count);
+        OceanFFT::SurfaceSamples samples;
+        samples.height = height.data();
+        ocean.sampleSurface(count, x.data(), z.data(), samples, OceanFFT::SampleFilter::Bilinear, 0);
+
+        std::vector<glm::vec3> displacement(count);
+        auto start = std::chrono::steady_clock::now();
+        ocean.probe(count, x.data(), z.data(), time, displacement.data());
+        double probeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        float error = 0.0f;
+        float scale = 0.0f;
+        for (int i = 0; i < count; ++i) {
+            error = std::max(error, std::abs(displacement[i].y - height[i]));
+            scale = std::max(scale, std::abs(height[i]));
+        }
+        std::cout << "probe: " << count << " points, max error " << error << " m (heights up to " << scale
+                  << " m), " << 1e6 * probeSeconds / count << " us per point, " << ocean.getActiveBinCount()
+                  << " active bins\n";
+
+        // Height bounds of random regions against the heights of the grid
+        // points starting in them
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> position(-L, 2.0f * L);
+        std::uniform_real_distribution<float> extent(1.0f, 200.0f);
+        const float spacing = L / N / 16.0f;   // Finest texel of the smallest patch
+        int violations = 0;
+        double boundsSeconds = 0.0;
+        for (int q = 0; q < queries; ++q) {
+            float x0 = position(rng);
+            float z0 = position(rng);
+            float x1 = x0 + extent(rng);
+            float z1 = z0 + extent(rng);
+            start = std::chrono::steady_clock::now();
+            glm::vec2 bounds = ocean.getHeightBounds(x0, z0, x1, z1);
+            boundsSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::vector<float> px;
+            std::vector<float> pz;
+            for (float sz = std::ceil(z0 / spacing) * spacing; sz <= z1; sz += spacing) {
+                for (float sx = std::ceil(x0 / spacing) * spacing; sx <= x1; sx += 4.0f * spacing) {
+                    px.push_back(sx);
+                    pz.push_back(sz);
+                }
+            }
+            std::vector<float> dense(px.size());
+            samples.height = dense.data();
+            ocean.sampleSurface(static_cast<int>(px.size()), px.data(), pz.data(), samples,
+                                OceanFFT::SampleFilter::Bilinear, 0);
+            for (float h : dense) {
+                if (h < bounds.x - 1e-5f || h > bounds.y + 1e-5f) {
+                    ++violations;
+                    break;
+                }
+            }
+        }
+        std::cout << "getHeightBounds: " << violations << " of " << queries << " regions violated, "
+                  << 1e6 * boundsSeconds / queries << " us per region\n";
+        if (violations > 0) result = 1;
+
+        // Rays from 5-40 m up, 5-60 degrees below the horizon
+        const float step = 0.05f;
+        std::uniform_real_distribution<float> altitude(5.0f, 40.0f);
+        std::uniform_real_distribution<float> heading(0.0f, 6.2831853f);
+        std::uniform_real_distribution<float> pitch(0.087f, 1.047f);
+        int hits = 0;
+        int mismatches = 0;
+        float largestGap = 0.0f;
+        double raySeconds = 0.0;
+        for (int q = 0; q < queries; ++q) {
+            glm::vec3 origin(position(rng), altitude(rng), position(rng));
+            float a = heading(rng);
+            float b = pitch(rng);
+            glm::vec3 direction(std::cos(a) * std::cos(b), -std::sin(b), std::sin(a) * std::cos(b));
+            float maxDistance = 500.0f;
+
+            float distance = 0.0f;
+            start = std::chrono::steady_clock::now();
+            bool hit = ocean.intersectRay(origin, direction, maxDistance, distance);
+            raySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            float marched = 0.0f;
+            bool marchHit = marchRay(ocean, origin, direction, maxDistance, step, marched);
+            if (hit != marchHit) {
+                ++mismatches;
+            } else if (hit) {
+                ++hits;
+                largestGap = std::max(largestGap, std::abs(distance - marched));
+            }
+        }
+        std::cout << "intersectRay: " << hits << " hits, " << mismatches << " disagreements with a "
+                  << step << " m march, largest distance gap " << largestGap << " m, "
+                  << 1e6 * raySeconds / queries << " us per ray\n";
+        if (mismatches > 0 || largestGap > step) result = 1;
+    }
+
+    destroyBenchContext(window);
+    return result;
+}
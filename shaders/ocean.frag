@@ -6,39 +6,59 @@ in vec3 vNormal;
 in vec2 vTexCoord;
 in float vFresnelFactor;
 in float vHeight;
+in vec4 vRegionWeights;
 
 // Uniforms
+uniform sampler2DArray uNormals; // RGB = (nx, ny, nz) normal per cascade, mip-mapped
+uniform sampler2DArray uFoam;    // R = foam coverage from the Jacobian per cascade
+const int MAX_CASCADES = 16;     // OceanFFT::MAX_SIMULATED_CASCADES
+uniform int uCascadeCount;
+uniform float uCascadeUVScale[MAX_CASCADES];    // Tiling of each cascade over the mesh patch
+uniform float uCascadeLayer[MAX_CASCADES];      // Layer of the newest normals (pair 2c, 2c+1)
+uniform float uCascadeBlend[MAX_CASCADES];      // Weight of the newest frame vs the previous one
+uniform int uCascadesPerRegion;  // Cascade c belongs to depth region c / uCascadesPerRegion
+uniform bool uUseFoamMap;        // Foam map available (else height threshold)
+uniform bool uLoopPlayback;      // GPU-resident loop (layer frame * uCascadeCount + c)
+uniform int uLoopFrames;
+uniform float uLoopPeriod;
+uniform float uLoopTime;         // Time within the period
 uniform vec3 uCameraPos;
 uniform vec3 uWaterColor;        // Deep water color
 uniform vec3 uSkyColor;          // Simplified skybox (single color)
 uniform vec3 uSunDirection;      // Normalized sun direction
-uniform float uFoamThreshold;    // Height threshold for foam
+uniform float uFoamThreshold;    // Height threshold for foam (fallback)
 uniform float uTime;             // Animation time
 
 // Output
 out vec4 FragColor;
 
-// Noise function for foam texture
-float hash(vec2 p) {
-    return fract(sin(dot(p, vec2(127.1, 311.7))) * 43758.5453);
-}
-
-float noise(vec2 p) {
-    vec2 i = floor(p);
-    vec2 f = fract(p);
-    f = f * f * (3.0 - 2.0 * f); // Smoothstep
-    
-    float a = hash(i);
-    float b = hash(i + vec2(1.0, 0.0));
-    float c = hash(i + vec2(0.0, 1.0));
-    float d = hash(i + vec2(1.0, 1.0));
-    
-    return mix(mix(a, b, f.x), mix(c, d, f.x), f.y);
+// Layers of the earlier and later frame of cascade c, and the later one's weight
+vec3 cascadeFrames(int c) {
+    if (uLoopPlayback) {
+        float position = uLoopTime / uLoopPeriod * float(uLoopFrames);
+        float frame = min(floor(position), float(uLoopFrames - 1));
+        float next = mod(frame + 1.0, float(uLoopFrames));
+        return vec3(frame * float(uCascadeCount) + float(c), next * float(uCascadeCount) + float(c),
+                    clamp(position - frame, 0.0, 1.0));
+    }
+    float newest = uCascadeLayer[c];
+    return vec3(float(4 * c + 1) - newest, newest, uCascadeBlend[c]);
 }
 
 void main() {
-    // Normalize interpolated normal
-    vec3 N = normalize(vNormal);
+    // Per-fragment normal from the mip chain (filtered with distance instead
+    // of aliasing like the per-vertex normal does); cascades add slopes
+    vec2 slope = vec2(0.0);
+    for (int c = 0; c < uCascadeCount; ++c) {
+        // No early out: implicit derivatives need uniform control flow
+        float weight = vRegionWeights[c / uCascadesPerRegion];
+        vec2 uv = vTexCoord * uCascadeUVScale[c];
+        vec3 frames = cascadeFrames(c);
+        vec3 n = mix(texture(uNormals, vec3(uv, frames.x)).rgb,
+                     texture(uNormals, vec3(uv, frames.y)).rgb, frames.z);
+        slope += weight * n.xz / n.y;
+    }
+    vec3 N = normalize(vec3(slope.x, 1.0, slope.y));
     vec3 V = normalize(uCameraPos - vWorldPos);
     vec3 L = normalize(uSunDirection);
     
@@ -67,22 +87,30 @@ void main() {
     vec3 specularColor = vec3(1.0, 1.0, 0.9) * specular;
     waterColor += specularColor * 0.8;
     
-    // Foam on wave crests
-    float foamAmount = 0.0;
-    if (vHeight > uFoamThreshold) {
-        // Generate foam texture using noise
-        vec2 foamUV = vTexCoord * 50.0 + uTime * 0.1;
-        float foamNoise = noise(foamUV);
-        foamNoise = foamNoise * noise(foamUV * 2.0) * noise(foamUV * 4.0);
-        
-        // Fade foam based on height
-        float heightFactor = smoothstep(uFoamThreshold, uFoamThreshold + 0.3, vHeight);
-        foamAmount = foamNoise * heightFactor;
-        
-        // Mix in foam color
-        vec3 foamColor = vec3(1.0, 1.0, 1.0);
-        waterColor = mix(waterColor, foamColor, foamAmount * 0.8);
+    // Foam where the surface folds (simulated on the CPU), or a plain
+    // height threshold when the foam map is not available
+    float foamAmount;
+    if (uUseFoamMap) {
+        foamAmount = 0.0;
+        for (int c = 0; c < uCascadeCount; ++c) {
+            // Live foam has one layer per cascade; resident loops blend frames
+            vec2 uv = vTexCoord * uCascadeUVScale[c];
+            float coverage;
+            if (uLoopPlayback) {
+                vec3 frames = cascadeFrames(c);
+                coverage = mix(texture(uFoam, vec3(uv, frames.x)).r, texture(uFoam, vec3(uv, frames.y)).r, frames.z);
+            } else {
+                coverage = texture(uFoam, vec3(uv, float(c))).r;
+            }
+            foamAmount = max(foamAmount, vRegionWeights[c / uCascadesPerRegion] * coverage);
+        }
+    } else {
+        foamAmount = smoothstep(uFoamThreshold, uFoamThreshold + 0.3, vHeight);
     }
+
+    // Mix in foam color
+    vec3 foamColor = vec3(1.0, 1.0, 1.0);
+    waterColor = mix(waterColor, foamColor, foamAmount * 0.8);
     
     // Depth-based darkening (simulate deeper water)
     // In a real scenario, you'd raymarch or use a depth map
@@ -8,9 +8,32 @@ uniform mat4 uModel;
 uniform mat4 uView;
 uniform mat4 uProj;
 
-// Uniforms - Textures
-uniform sampler2D uDisplacement;  // RGB = (dx, dy, dz) displacement
-uniform sampler2D uNormals;       // RGB = (nx, ny, nz) normal
+// Uniforms - Textures (one layer per cascade)
+uniform sampler2DArray uDisplacement;  // RGB = (dx, dy, dz) displacement
+uniform sampler2DArray uNormals;       // RGB = (nx, ny, nz) normal
+
+// Uniforms - Cascades (OceanFFT::MAX_SIMULATED_CASCADES)
+const int MAX_CASCADES = 16;
+uniform int uCascadeCount;
+uniform float uCascadeUVScale[MAX_CASCADES];    // Tiling of each cascade over the mesh patch
+uniform float uCascadeVertexLod[MAX_CASCADES];  // Mip level matching the vertex spacing
+uniform float uCascadeLayer[MAX_CASCADES];      // Layer of the newest frame (pair 2c, 2c+1)
+uniform float uCascadeBlend[MAX_CASCADES];      // Weight of the newest frame vs the previous one
+
+// Uniforms - Depth regions (cascade c belongs to region c / uCascadesPerRegion)
+uniform int uCascadesPerRegion;
+uniform int uRegionCount;
+uniform float uRegionLogDepth[4];   // ln of each region's depth, increasing
+uniform sampler2D uBathymetry;      // R = water depth in metres
+uniform bool uUseBathymetry;
+uniform vec2 uBathymetryOrigin;     // World (x, z) of the map's corner
+uniform float uBathymetryExtent;
+
+// Uniforms - GPU-resident loop (layer frame * uCascadeCount + c)
+uniform bool uLoopPlayback;
+uniform int uLoopFrames;
+uniform float uLoopPeriod;
+uniform float uLoopTime;         // Time within the period
 
 // Uniforms - Camera
 uniform vec3 uCameraPos;
@@ -21,10 +44,70 @@ out vec3 vNormal;
 out vec2 vTexCoord;
 out float vFresnelFactor;
 out float vHeight;
+out vec4 vRegionWeights;    // Weight of each depth region
+
+// Layers of the earlier and later frame of cascade c, and the later one's weight
+vec3 cascadeFrames(int c) {
+    if (uLoopPlayback) {
+        float position = uLoopTime / uLoopPeriod * float(uLoopFrames);
+        float frame = min(floor(position), float(uLoopFrames - 1));
+        float next = mod(frame + 1.0, float(uLoopFrames));
+        return vec3(frame * float(uCascadeCount) + float(c), next * float(uCascadeCount) + float(c),
+                    clamp(position - frame, 0.0, 1.0));
+    }
+    float newest = uCascadeLayer[c];
+    return vec3(float(4 * c + 1) - newest, newest, uCascadeBlend[c]);
+}
+
+// Weight of each depth region at a world position (as OceanFFT::getRegionWeights)
+vec4 regionWeights(vec2 position) {
+    vec4 weights = vec4(0.0);
+    vec2 uv = (position - uBathymetryOrigin) / uBathymetryExtent;
+    if (uRegionCount == 1 || !uUseBathymetry || any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0)))) {
+        weights[uRegionCount - 1] = 1.0;
+        return weights;
+    }
+
+    // Linear in log depth between the regions around it
+    float d = log(max(textureLod(uBathymetry, uv, 0.0).r, 0.001));
+    if (d <= uRegionLogDepth[0]) {
+        weights[0] = 1.0;
+        return weights;
+    }
+    for (int r = 0; r + 1 < uRegionCount; ++r) {
+        if (d < uRegionLogDepth[r + 1]) {
+            float t = (d - uRegionLogDepth[r]) / (uRegionLogDepth[r + 1] - uRegionLogDepth[r]);
+            weights[r] = 1.0 - t;
+            weights[r + 1] = t;
+            return weights;
+        }
+    }
+    weights[uRegionCount - 1] = 1.0;
+    return weights;
+}
+
+// Cascade c interpolated between its earlier and later frame
+vec3 sampleCascade(sampler2DArray tex, int c, float lod) {
+    vec2 uv = aTexCoord * uCascadeUVScale[c];
+    vec3 frames = cascadeFrames(c);
+    vec3 a = textureLod(tex, vec3(uv, frames.x), lod).rgb;
+    vec3 b = textureLod(tex, vec3(uv, frames.y), lod).rgb;
+    return mix(a, b, frames.z);
+}
 
 void main() {
-    // Sample displacement map
-    vec3 displacement = texture(uDisplacement, aTexCoord).rgb;
+    // Sum displacement and slopes of all cascades (explicit LOD: vertex
+    // shaders have no derivatives), each weighted by its depth region
+    vRegionWeights = regionWeights((uModel * vec4(aPos, 1.0)).xz);
+    vec3 displacement = vec3(0.0);
+    vec2 slope = vec2(0.0);
+    for (int c = 0; c < uCascadeCount; ++c) {
+        float weight = vRegionWeights[c / uCascadesPerRegion];
+        if (weight <= 0.0) continue;
+        displacement += weight * sampleCascade(uDisplacement, c, uCascadeVertexLod[c]);
+        vec3 n = sampleCascade(uNormals, c, uCascadeVertexLod[c]);
+        slope += weight * n.xz / n.y;
+    }
     
     // Apply displacement to base grid position
     vec3 displacedPos = aPos + displacement;
@@ -32,8 +115,8 @@ void main() {
     // Transform to world space
     vWorldPos = (uModel * vec4(displacedPos, 1.0)).xyz;
     
-    // Sample and transform normal
-    vec3 sampledNormal = texture(uNormals, aTexCoord).rgb;
+    // Transform normal
+    vec3 sampledNormal = normalize(vec3(slope.x, 1.0, slope.y));
     vNormal = normalize((uModel * vec4(sampledNormal, 0.0)).xyz);
     
     // Pass through texture coordinates
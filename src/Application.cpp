@@ -1,9 +1,14 @@
 #include "Application.h"
+#include "ComputeSimulation.h"
+#include "NormalDerivation.h"
 #include <glad/glad.h>
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <thread>
 
 Application::Application()
     : m_window(nullptr)
@@ -11,7 +16,7 @@ Application::Application()
     , m_windowHeight(1080)
     , m_deltaTime(0.0f)
     , m_lastFrame(0.0f)
-    , m_simTime(0.0f)
+    , m_simTime(0.0)
     , m_timeScale(1.0f)
     , m_frameCount(0)
     , m_firstMouse(true)
@@ -151,6 +156,7 @@ bool Application::initOcean() {
     // Create ocean FFT simulation (128x128 resolution, 1000m patch)
     // Résolution réduite pour améliorer les performances (256->128 = 4x plus rapide)
     m_oceanFFT = std::make_unique<OceanFFT>(128, 1000.0f);
+    m_oceanFFT->setCascades(makeCascades());
     
     if (!m_oceanFFT->initialize()) {
         std::cerr << "ERROR: Failed to initialize OceanFFT\n";
@@ -161,7 +167,39 @@ bool Application::initOcean() {
     m_oceanFFT->setWindSpeed(m_params.windSpeed);
     m_oceanFFT->setWindDirection(glm::vec2(m_params.windDirection[0], m_params.windDirection[1]));
     m_oceanFFT->setAmplitude(m_params.amplitude);
+    m_oceanFFT->setSpectrum(makeSpectrum());
+    applySwell();
     m_oceanFFT->setChoppy(m_params.choppy);
+    m_oceanFFT->setMipMode(static_cast<OceanFFT::MipMode>(m_params.mipMode));
+    m_oceanFFT->setVelocityEnabled(m_params.velocity, m_params.velocityTexture);
+    m_oceanFFT->setJacobianEnabled(m_params.jacobianFoam);
+    m_oceanFFT->setFoamParameters(m_params.foamBias, m_params.foamDecay);
+    m_oceanFFT->setSparseFraction(m_params.sparseFraction);
+    m_oceanFFT->setPrunedEnabled(m_params.prunedOutput);
+    m_oceanFFT->setLoopPeriod(m_params.loopPeriod);
+    m_oceanFFT->setLoopTexturesEnabled(m_params.loopTextures, m_params.loopCompact);
+    m_oceanFFT->setHeightBoundsEnabled(m_params.tileCulling);
+    m_oceanFFT->setFFTBackend(static_cast<FFTBackend::Type>(m_params.fftBackend));
+    m_oceanFFT->setFusedEvaluation(m_params.fusedEvaluation);
+    m_oceanFFT->setGPUSimulation(m_params.gpuSimulation);
+    m_oceanFFT->setGPUNormals(m_params.gpuNormals);
+    m_oceanFFT->setGPUReadback(m_params.gpuReadback, m_params.readbackLevel);
+    m_oceanFFT->setDepthRegions(makeDepthRegions());
+
+    // Shelf rising towards -x, from 200 m down to 1 m at a wavy shoreline
+    const int bathymetrySize = 256;
+    const float extent = m_oceanFFT->getPatchSize();
+    std::vector<float> bathymetry(static_cast<size_t>(bathymetrySize) * bathymetrySize);
+    for (int j = 0; j < bathymetrySize; ++j) {
+        for (int i = 0; i < bathymetrySize; ++i) {
+            float u = (i + 0.5f) / bathymetrySize;
+            float v = (j + 0.5f) / bathymetrySize;
+            float shore = 0.1f + 0.05f * std::sin(6.2831853f * 2.0f * v);
+            float t = std::clamp((u - shore) / (1.0f - shore), 0.0f, 1.0f);
+            bathymetry[static_cast<size_t>(j) * bathymetrySize + i] = std::pow(200.0f, t);
+        }
+    }
+    m_oceanFFT->setBathymetry(bathymetry, bathymetrySize, glm::vec2(-0.5f * extent), extent);
 
     // Create renderer
     m_renderer = std::make_unique<OceanRenderer>();
@@ -173,6 +211,73 @@ bool Application::initOcean() {
     return true;
 }
 
+std::vector<float> Application::makeDepthRegions() const {
+    if (!m_params.depthRegions) return {};
+    std::vector<float> depths(std::begin(m_params.regionDepths), std::end(m_params.regionDepths));
+    std::sort(depths.begin(), depths.end());
+    depths.erase(std::unique(depths.begin(), depths.end()), depths.end());
+    return depths;
+}
+
+SpectrumDesc Application::makeSpectrum() const {
+    SpectrumDesc spectrum;
+    spectrum.model = static_cast<SpectrumModel>(m_params.spectrumModel);
+    spectrum.spreading = static_cast<DirectionalSpreading>(m_params.spreading);
+    spectrum.fetch = m_params.fetch * 1000.0f;
+    spectrum.peakEnhancement = m_params.peakEnhancement;
+    spectrum.depth = m_params.depth;
+    spectrum.spreadExponent = m_params.spreadExponent;
+    return spectrum;
+}
+
+SpectrumComponent Application::makeSwell() const {
+    SpectrumComponent swell;
+    swell.spectrum.model = SpectrumModel::JONSWAP;
+    swell.spectrum.spreading = DirectionalSpreading::Cos2s;
+    swell.spectrum.fetch = 1000000.0f;
+    swell.spectrum.peakEnhancement = 7.0f;
+    swell.spectrum.spreadExponent = m_params.swellSpread;
+    swell.windSpeed = m_params.swellSpeed;
+    swell.windDirection = glm::vec2(m_params.swellDirection[0], m_params.swellDirection[1]);
+    return swell;
+}
+
+void Application::applySwell() {
+    glm::vec2 direction(m_params.swellDirection[0], m_params.swellDirection[1]);
+    bool enabled = m_params.swell && glm::length(direction) > 0.01f;
+    if (!enabled) {
+        if (m_oceanFFT->getSpectrumComponentCount() > 1) {
+            m_oceanFFT->removeSpectrumComponent(1);
+        }
+    } else if (m_oceanFFT->getSpectrumComponentCount() < 2) {
+        m_oceanFFT->addSpectrumComponent(makeSwell());
+    } else {
+        // Regenerates only the swell's contribution, and only on change
+        m_oceanFFT->setSpectrumComponent(1, makeSwell());
+    }
+}
+
+std::vector<OceanFFT::CascadeDesc> Application::makeCascades() const {
+    std::vector<OceanFFT::CascadeDesc> cascades =
+        OceanFFT::makeCascades(m_oceanFFT->getPatchSize(), m_params.cascades, m_params.multiRate);
+    for (size_t c = 0; c < cascades.size(); ++c) {
+        switch (m_params.precision) {
+            case 0:
+                cascades[c].precision = OceanFFT::Precision::Double;
+                break;
+            case 1:
+                cascades[c].precision = OceanFFT::Precision::Single;
+                break;
+            default:
+                // The largest cascade carries the swell, whose phase drifts
+                // the most visibly; the detail cascades tolerate bfloat16
+                cascades[c].precision = c == 0 ? OceanFFT::Precision::Double : OceanFFT::Precision::Compact;
+                break;
+        }
+    }
+    return cascades;
+}
+
 void Application::processInput() {
     if (!m_camera) return;
 
@@ -201,9 +306,26 @@ void Application::update() {
     
     // Update ocean simulation every 2 frames (optimisation)
     if (m_frameCount % 2 == 0) {
-        m_oceanFFT->update(m_simTime);
+        if (m_bakedAnimation) {
+            m_bakedAnimation->play(*m_oceanFFT, m_simTime);
+        } else {
+            m_oceanFFT->update(m_simTime);
+        }
     }
 
+    // Update renderer parameters
+    if (m_renderer) {
+        m_renderer->setWaterColor(glm::vec3(m_params.waterColor[0], 
+                                            m_params.waterColor[1], 
+                                            m_params.waterColor[2]));
+        m_renderer->setFoamThreshold(m_params.foamThreshold);
+        m_renderer->setWireframe(m_params.wireframe);
+        m_renderer->setCullingEnabled(m_params.tileCulling);
+    }
+
+    // The baked file fixes the ocean configuration while it plays
+    if (m_bakedAnimation) return;
+
     // Apply parameter changes from UI
     if (std::abs(m_oceanFFT->getWindSpeed() - m_params.windSpeed) > 0.1f) {
         m_oceanFFT->setWindSpeed(m_params.windSpeed);
@@ -218,18 +340,47 @@ void Application::update() {
         m_oceanFFT->setAmplitude(m_params.amplitude);
     }
 
+    // Regenerates only on change
+    m_oceanFFT->setSpectrum(makeSpectrum());
+    applySwell();
+
     if (std::abs(m_oceanFFT->getChoppy() - m_params.choppy) > 0.01f) {
         m_oceanFFT->setChoppy(m_params.choppy);
     }
 
-    // Update renderer parameters
-    if (m_renderer) {
-        m_renderer->setWaterColor(glm::vec3(m_params.waterColor[0], 
-                                            m_params.waterColor[1], 
-                                            m_params.waterColor[2]));
-        m_renderer->setFoamThreshold(m_params.foamThreshold);
-        m_renderer->setWireframe(m_params.wireframe);
+    // Rebuild the cascade set when its count or refresh periods change
+    std::vector<OceanFFT::CascadeDesc> cascades = makeCascades();
+    bool cascadesChanged = m_oceanFFT->getCascadesPerRegion() != static_cast<int>(cascades.size());
+    for (size_t c = 0; !cascadesChanged && c < cascades.size(); ++c) {
+        const OceanFFT::CascadeDesc& current = m_oceanFFT->getCascade(static_cast<int>(c));
+        cascadesChanged = current.updatePeriod != cascades[c].updatePeriod
+                       || current.precision != cascades[c].precision;
+    }
+    if (cascadesChanged) {
+        m_oceanFFT->setCascades(cascades);
     }
+    m_oceanFFT->setDepthRegions(makeDepthRegions());
+
+    m_oceanFFT->setMipMode(static_cast<OceanFFT::MipMode>(m_params.mipMode));
+    m_oceanFFT->setVelocityEnabled(m_params.velocity, m_params.velocityTexture);
+    m_oceanFFT->setJacobianEnabled(m_params.jacobianFoam);
+    m_oceanFFT->setFoamParameters(m_params.foamBias, m_params.foamDecay);
+    m_oceanFFT->setSparseFraction(m_params.sparseFraction);
+    m_oceanFFT->setPrunedEnabled(m_params.prunedOutput);
+    m_oceanFFT->setLoopPeriod(m_params.loopPeriod);
+    m_oceanFFT->setLoopTexturesEnabled(m_params.loopTextures, m_params.loopCompact);
+    m_oceanFFT->setHeightBoundsEnabled(m_params.tileCulling);
+    if (!m_oceanFFT->setFFTBackend(static_cast<FFTBackend::Type>(m_params.fftBackend))) {
+        m_params.fftBackend = static_cast<int>(m_oceanFFT->getFFTBackend());
+    }
+    m_oceanFFT->setFusedEvaluation(m_params.fusedEvaluation);
+    if (!m_oceanFFT->setGPUSimulation(m_params.gpuSimulation)) {
+        m_params.gpuSimulation = false;
+    }
+    if (!m_oceanFFT->setGPUNormals(m_params.gpuNormals)) {
+        m_params.gpuNormals = false;
+    }
+    m_oceanFFT->setGPUReadback(m_params.gpuReadback, m_params.readbackLevel);
 }
 
 void Application::render() {
@@ -265,8 +416,66 @@ void Application::renderUI() {
     if (ImGui::CollapsingHeader("Ocean Parameters", ImGuiTreeNodeFlags_DefaultOpen)) {
         ImGui::SliderFloat("Wind Speed", &m_params.windSpeed, 5.0f, 60.0f, "%.1f m/s");
         ImGui::SliderFloat2("Wind Direction", m_params.windDirection, -1.0f, 1.0f);
-        ImGui::SliderFloat("Amplitude", &m_params.amplitude, 0.00001f, 0.001f, "%.5f");
+        const char* spectrumModels[] = { "Phillips", "Pierson-Moskowitz", "JONSWAP", "TMA" };
+        ImGui::Combo("Spectrum", &m_params.spectrumModel, spectrumModels, IM_ARRAYSIZE(spectrumModels));
+        if (m_params.spectrumModel == static_cast<int>(SpectrumModel::Phillips)) {
+            ImGui::SliderFloat("Amplitude", &m_params.amplitude, 0.00001f, 0.001f, "%.5f");
+        }
+        if (m_params.spectrumModel >= static_cast<int>(SpectrumModel::JONSWAP)) {
+            ImGui::SliderFloat("Fetch", &m_params.fetch, 1.0f, 1000.0f, "%.0f km", ImGuiSliderFlags_Logarithmic);
+            ImGui::SliderFloat("Peak Enhancement", &m_params.peakEnhancement, 1.0f, 7.0f, "%.1f");
+        }
+        if (m_params.spectrumModel == static_cast<int>(SpectrumModel::TMA)) {
+            ImGui::SliderFloat("Depth", &m_params.depth, 1.0f, 200.0f, "%.0f m", ImGuiSliderFlags_Logarithmic);
+        }
+        const char* spreadings[] = { "cos^2", "cos^2s", "Donelan-Banner" };
+        ImGui::Combo("Spreading", &m_params.spreading, spreadings, IM_ARRAYSIZE(spreadings));
+        if (m_params.spreading == static_cast<int>(DirectionalSpreading::Cos2s)) {
+            ImGui::SliderFloat("Spread Exponent", &m_params.spreadExponent, 1.0f, 32.0f, "%.1f");
+        }
+        ImGui::Checkbox("Swell", &m_params.swell);
+        if (m_params.swell) {
+            ImGui::SliderFloat("Swell Wind Speed", &m_params.swellSpeed, 5.0f, 30.0f, "%.1f m/s");
+            ImGui::SliderFloat2("Swell Direction", m_params.swellDirection, -1.0f, 1.0f);
+            ImGui::SliderFloat("Swell Spread", &m_params.swellSpread, 8.0f, 128.0f, "%.0f",
+                               ImGuiSliderFlags_Logarithmic);
+        }
         ImGui::SliderFloat("Choppiness", &m_params.choppy, 0.0f, 5.0f, "%.2f");
+        ImGui::SliderInt("Cascades", &m_params.cascades, 1, OceanFFT::MAX_CASCADES);
+        ImGui::SameLine();
+        ImGui::Checkbox("Multi-Rate", &m_params.multiRate);
+        ImGui::Checkbox("Depth Regions", &m_params.depthRegions);
+        if (m_params.depthRegions) {
+            ImGui::SliderFloat3("Region Depths", m_params.regionDepths, 1.0f, 200.0f, "%.0f m",
+                                ImGuiSliderFlags_Logarithmic);
+        }
+        const char* precisions[] = { "Double", "Single", "Mixed" };
+        ImGui::Combo("Precision", &m_params.precision, precisions, IM_ARRAYSIZE(precisions));
+        ImGui::SliderFloat("Sparse Cutoff", &m_params.sparseFraction, 0.0f, 0.01f, "%.5f",
+                           ImGuiSliderFlags_Logarithmic);
+        ImGui::Checkbox("Pruned Output", &m_params.prunedOutput);
+        ImGui::SliderFloat("Loop Period", &m_params.loopPeriod, 0.0f, 120.0f, "%.0f s");
+        if (m_params.loopPeriod > 0.0f && m_oceanFFT) {
+            ImGui::SliderInt("Loop Frames", &m_params.loopFrames, 16, 512);
+            ImGui::Checkbox("GPU Resident", &m_params.loopTextures);
+            ImGui::SameLine();
+            ImGui::Checkbox("Half Precision", &m_params.loopCompact);
+            if (ImGui::Button("Build Loop Cache")) {
+                m_oceanFFT->setLoopPeriod(m_params.loopPeriod);
+                m_oceanFFT->buildLoopCache(m_params.loopFrames);
+            }
+            ImGui::SameLine();
+            if (m_oceanFFT->isLoopResident()) {
+                ImGui::Text("Playing resident loop");
+            } else if (m_oceanFFT->isPlayingLoop()) {
+                ImGui::Text("Playing cached loop");
+            } else if (m_oceanFFT->getLoopCacheProgress() > 0.0f) {
+                ImGui::ProgressBar(m_oceanFFT->getLoopCacheProgress());
+            }
+        }
+        ImGui::Checkbox("Surface Velocity", &m_params.velocity);
+        ImGui::SameLine();
+        ImGui::Checkbox("Upload Velocity Texture", &m_params.velocityTexture);
         
         if (ImGui::Button("Calm Sea")) {
             m_params.windSpeed = 15.0f;
@@ -281,11 +490,82 @@ void Application::renderUI() {
         }
     }
 
+    // Baked animation (offline simulation written to / played from a file)
+    if (ImGui::CollapsingHeader("Baked Animation") && m_oceanFFT) {
+        ImGui::InputText("File", m_params.bakePath, sizeof(m_params.bakePath));
+        ImGui::SliderInt("Bake Frames", &m_params.bakeFrames, 30, 1800);
+        const char* encodings[] = { "Float32", "16-bit", "12-bit" };
+        ImGui::Combo("Encoding", &m_params.bakeEncoding, encodings, IM_ARRAYSIZE(encodings));
+        if (m_bakeJob && m_bakeJob->isFinished()) {
+            if (!m_bakeJob->succeeded()) std::cerr << "ERROR: Bake failed\n";
+            m_bakeJob.reset();
+        }
+        if (m_bakeJob) {
+            ImGui::ProgressBar(m_bakeJob->getProgress());
+            if (ImGui::Button("Cancel Bake")) {
+                m_bakeJob.reset();
+            }
+        } else if (!m_bakedAnimation) {
+            if (ImGui::Button("Bake")) {
+                // Simulated on half of the cores, the live ocean keeps the rest
+                int workers = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) / 2 - 1);
+                m_bakeJob = std::make_unique<BakeJob>();
+                if (!m_bakeJob->start(m_params.bakePath, *m_oceanFFT, m_params.bakeFrames, 1.0f / 30.0f,
+                                      static_cast<BakeEncoding>(m_params.bakeEncoding), workers)) {
+                    m_bakeJob.reset();
+                }
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Play Baked")) {
+                m_bakedAnimation = std::make_unique<BakedAnimation>();
+                if (!m_bakedAnimation->open(m_params.bakePath) || !m_bakedAnimation->configure(*m_oceanFFT)) {
+                    m_bakedAnimation.reset();
+                }
+            }
+        } else {
+            ImGui::Text("Playing %d frames (%.1f s)", m_bakedAnimation->getFrameCount(),
+                        m_bakedAnimation->getDuration());
+            if (m_bakedAnimation->getEncoding() != BakeEncoding::Float32) {
+                ImGui::Text("Decode: %.2f ms/frame", m_bakedAnimation->getAverageDecodeMilliseconds());
+            }
+            if (ImGui::Button("Stop Playback")) {
+                m_bakedAnimation.reset();
+                m_oceanFFT->stopPlayback();
+            }
+        }
+    }
+
     // Rendering parameters
     if (ImGui::CollapsingHeader("Rendering", ImGuiTreeNodeFlags_DefaultOpen)) {
         ImGui::ColorEdit3("Water Color", m_params.waterColor);
-        ImGui::SliderFloat("Foam Threshold", &m_params.foamThreshold, 0.0f, 2.0f);
+        ImGui::Checkbox("Jacobian Foam", &m_params.jacobianFoam);
+        if (m_params.jacobianFoam) {
+            ImGui::SliderFloat("Foam Bias", &m_params.foamBias, 0.0f, 1.5f, "%.2f");
+            ImGui::SliderFloat("Foam Decay", &m_params.foamDecay, 0.1f, 10.0f, "%.1f s");
+        } else {
+            ImGui::SliderFloat("Foam Threshold", &m_params.foamThreshold, 0.0f, 2.0f);
+        }
         ImGui::Checkbox("Wireframe", &m_params.wireframe);
+        ImGui::Checkbox("Tile Culling", &m_params.tileCulling);
+        const char* mipModes[] = { "None", "Box Filter", "Spectral" };
+        ImGui::Combo("Mip Generation", &m_params.mipMode, mipModes, IM_ARRAYSIZE(mipModes));
+        if (FFTBackend::isAvailable(FFTBackend::Type::FFTW)) {
+            const char* fftBackends[] = { "FFTW", "Built-in" };
+            ImGui::Combo("FFT Backend", &m_params.fftBackend, fftBackends, IM_ARRAYSIZE(fftBackends));
+        }
+        if (m_params.fftBackend == static_cast<int>(FFTBackend::Type::Builtin)) {
+            ImGui::Checkbox("Fused Evaluation", &m_params.fusedEvaluation);
+        }
+        if (ComputeSimulation::isSupported()) {
+            ImGui::Checkbox("GPU Simulation", &m_params.gpuSimulation);
+        }
+        if (m_params.gpuSimulation) {
+            ImGui::Checkbox("GPU Readback", &m_params.gpuReadback);
+            if (m_params.gpuReadback) ImGui::SliderInt("Readback Level", &m_params.readbackLevel, 0, 4);
+        }
+        if (NormalDerivation::isSupported() && !m_params.gpuSimulation) {
+            ImGui::Checkbox("GPU Normals", &m_params.gpuNormals);
+        }
         ImGui::SliderFloat("Time Scale", &m_timeScale, 0.0f, 3.0f);
     }
 
@@ -296,6 +576,33 @@ void Application::renderUI() {
         if (m_oceanFFT) {
             ImGui::Text("Resolution: %dx%d", m_oceanFFT->getResolution(), m_oceanFFT->getResolution());
             ImGui::Text("Patch Size: %.0f m", m_oceanFFT->getPatchSize());
+            ImGui::Text("Mip Levels: %d", m_oceanFFT->getMipLevelCount());
+            ImGui::Text("Cascades: %d x %d depth regions (smallest %.1f m)", m_oceanFFT->getCascadesPerRegion(),
+                        m_oceanFFT->getDepthRegionCount(),
+                        m_oceanFFT->getCascade(m_oceanFFT->getCascadesPerRegion() - 1).patchSize);
+            ImGui::Text("Cascade Updates: %d / %d per step", m_oceanFFT->getUpdatedCascadeCount(),
+                        m_oceanFFT->getCascadeCount());
+            ImGui::Text("Active Bins: %d / %d (%.3f%% energy)", m_oceanFFT->getActiveBinCount(),
+                        m_oceanFFT->getTotalBinCount(), m_oceanFFT->getRetainedEnergy() * 100.0f);
+            if (m_oceanFFT->isPrunedEnabled()) {
+                ImGui::Text("Pruned Grid:");
+                for (int c = 0; c < m_oceanFFT->getCascadeCount(); ++c) {
+                    ImGui::SameLine();
+                    ImGui::Text("%d", m_oceanFFT->getPrunedResolution(c));
+                }
+            }
+            ImGui::Text("Worker Threads: %d", m_oceanFFT->getThreadPool().getThreadCount());
+            if (m_oceanFFT->usesGPUSimulation() && m_oceanFFT->isGPUReadbackEnabled()) {
+                double surfaceTime = m_oceanFFT->getSurfaceTime();
+                if (surfaceTime >= 0.0) {
+                    ImGui::Text("Readback Lag: %.1f ms", (m_simTime - surfaceTime) * 1000.0);
+                } else {
+                    ImGui::Text("Readback Lag: pending");
+                }
+            }
+            if (m_renderer) {
+                ImGui::Text("Tiles Drawn: %d / %d", m_renderer->getVisibleTileCount(), m_renderer->getTileCount());
+            }
         }
         if (m_camera) {
             glm::vec3 pos = m_camera->getPosition();
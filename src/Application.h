@@ -1,5 +1,6 @@
 #pragma once
 
+#include "BakedAnimation.h"
 #include "Camera.h"
 #include "OceanFFT.h"
 #include "OceanRenderer.h"
@@ -49,11 +50,13 @@ private:
     std::unique_ptr<Camera> m_camera;
     std::unique_ptr<OceanFFT> m_oceanFFT;
     std::unique_ptr<OceanRenderer> m_renderer;
+    std::unique_ptr<BakedAnimation> m_bakedAnimation;  // Played instead of simulating while set
+    std::unique_ptr<BakeJob> m_bakeJob;                // Bake in progress (or just finished)
 
     // Timing
     float m_deltaTime;
     float m_lastFrame;
-    float m_simTime;
+    double m_simTime;   // Double: float seconds lose milliseconds after a few hours
     float m_timeScale;
     int m_frameCount;  // Pour optimisation FFT
 
@@ -72,10 +75,47 @@ private:
         float windSpeed = 30.0f;
         float windDirection[2] = {1.0f, 0.0f};
         float amplitude = 0.0002f;
+        int spectrumModel = 0;      // SpectrumModel
+        int spreading = 0;          // DirectionalSpreading
+        float fetch = 100.0f;       // km
+        float peakEnhancement = 3.3f;
+        float depth = 20.0f;
+        float spreadExponent = 8.0f;
+        bool swell = false;         // Distant swell on top of the wind sea
+        float swellSpeed = 12.0f;   // m/s, of the distant storm
+        float swellDirection[2] = {0.6f, 0.8f};
+        float swellSpread = 32.0f;  // cos^2s exponent
+        bool depthRegions = false;  // Shallow-water regions over a sloping shelf
+        float regionDepths[3] = {3.0f, 12.0f, 60.0f};
         float choppy = 2.0f;
+        int cascades = 3;
+        bool multiRate = true;
+        float sparseFraction = 0.0001f;
+        bool prunedOutput = false;
+        float loopPeriod = 0.0f;    // 0 = continuous (non-repeating) sea
+        int loopFrames = 64;
+        bool loopTextures = false;  // Keep the built loop on the GPU
+        bool loopCompact = false;   // ... at half precision
+        char bakePath[256] = "ocean.bake";
+        int bakeFrames = 300;   // At 30 frames per second
+        int bakeEncoding = static_cast<int>(BakeEncoding::Quantized16);
+        int mipMode = static_cast<int>(OceanFFT::MipMode::BoxFilter);
+        int fftBackend = static_cast<int>(FFTBackend::getDefaultType());
+        bool fusedEvaluation = true;    // Spectrum evolved inside the FFT (built-in backend)
+        bool gpuSimulation = false;     // Displacement and normals by compute shaders
+        bool gpuNormals = false;        // Normals derived from the uploaded displacement
+        bool gpuReadback = true;        // GPU-simulated displacement copied back for CPU queries
+        int readbackLevel = 1;          // ... at this mip level
+        int precision = 2;      // 0 = Double, 1 = Single, 2 = Mixed (double largest cascade, compact others)
+        bool velocity = false;
+        bool velocityTexture = false;
+        bool jacobianFoam = true;
+        float foamBias = 0.6f;
+        float foamDecay = 2.0f;
         float waterColor[3] = {0.0f, 0.3f, 0.5f};
         float foamThreshold = 0.5f;
         bool wireframe = false;
+        bool tileCulling = true;    // Frustum culling from the height bounds
     } m_params;
 
     // Methods
@@ -100,6 +140,31 @@ private:
      */
     bool initOcean();
 
+    /**
+     * @brief Cascade set from the UI parameters (count, refresh rates, precision)
+     */
+    std::vector<OceanFFT::CascadeDesc> makeCascades() const;
+
+    /**
+     * @brief Spectrum model and spreading from the UI parameters
+     */
+    SpectrumDesc makeSpectrum() const;
+
+    /**
+     * @brief Swell component from the UI parameters (fully developed, narrow)
+     */
+    SpectrumComponent makeSwell() const;
+
+    /**
+     * @brief Add, update or remove the swell component to match the UI
+     */
+    void applySwell();
+
+    /**
+     * @brief Depth regions from the UI parameters (sorted, empty when disabled)
+     */
+    std::vector<float> makeDepthRegions() const;
+
     /**
      * @brief Process input events
      */
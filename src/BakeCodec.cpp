@@ -0,0 +1,512 @@
+#include "BakeCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Two interleaved rANS states with 12-bit probabilities and 16-bit
+// renormalization (at most one read per value)
+constexpr int PROB_BITS = 12;
+constexpr uint32_t PROB_SCALE = 1u << PROB_BITS;
+constexpr uint32_t RANS_L = 1u << 16;
+
+// Residuals are coded as their bit length (rANS) plus the bits below the
+// leading one (raw)
+constexpr int ALPHABET = 17;
+
+template <typename T>
+void put(std::vector<unsigned char>& out, const T& value) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+/**
+ * @brief Bounds-checked reader over an encoded frame
+ */
+struct Cursor {
+    const unsigned char* ptr;
+    const unsigned char* end;
+    bool ok = true;
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (static_cast<size_t>(end - ptr) < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, ptr, sizeof(T));
+        ptr += sizeof(T);
+        return value;
+    }
+};
+
+int bitLength(uint32_t value) {
+    int length = 0;
+    while (value) {
+        ++length;
+        value >>= 1;
+    }
+    return length;
+}
+
+uint32_t zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+int32_t unzigzag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+/**
+ * @brief q - p wrapped into the signed range of the quantizer, zigzagged
+ */
+uint32_t wrapResidual(uint32_t q, uint32_t p, uint32_t mask) {
+    int32_t r = static_cast<int32_t>((q - p) & mask);
+    if (r > static_cast<int32_t>(mask >> 1)) r -= static_cast<int32_t>(mask) + 1;
+    return zigzag(r);
+}
+
+/**
+ * @brief Scale symbol counts to frequencies summing to PROB_SCALE (used symbols >= 1)
+ */
+void normalizeFrequencies(const uint32_t* counts, uint16_t* freq) {
+    uint64_t total = 0;
+    for (int s = 0; s < ALPHABET; ++s) total += counts[s];
+
+    uint32_t sum = 0;
+    for (int s = 0; s < ALPHABET; ++s) {
+        // In 64 bits: the product wraps once a count reaches 2^20 (N >= 1024)
+        uint64_t scaled = static_cast<uint64_t>(counts[s]) * PROB_SCALE / total;
+        freq[s] = counts[s] ? static_cast<uint16_t>(std::max<uint64_t>(1, scaled)) : 0;
+        sum += freq[s];
+    }
+
+    // Rounding leaves a small surplus or deficit; settle it on the largest
+    while (sum != PROB_SCALE) {
+        int largest = static_cast<int>(std::max_element(freq, freq + ALPHABET) - freq);
+        if (sum > PROB_SCALE) {
+            if (freq[largest] <= 1) break;
+            --freq[largest];
+            --sum;
+        } else {
+            ++freq[largest];
+            ++sum;
+        }
+    }
+}
+
+/**
+ * @brief Entropy code values below 2^16: counts, frequencies, rANS bytes, raw bits
+ */
+void encodeStream(const std::vector<uint32_t>& values, std::vector<unsigned char>& out) {
+    uint32_t counts[ALPHABET] = {};
+    for (uint32_t value : values) ++counts[bitLength(value)];
+    uint16_t freq[ALPHABET];
+    normalizeFrequencies(counts, freq);
+    uint32_t cumulative[ALPHABET];
+    uint32_t running = 0;
+    for (int s = 0; s < ALPHABET; ++s) {
+        cumulative[s] = running;
+        running += freq[s];
+    }
+
+    // Raw bits below the leading one, in value order
+    std::vector<unsigned char> raw;
+    uint64_t bitBuffer = 0;
+    int bitCount = 0;
+    for (uint32_t value : values) {
+        int length = bitLength(value);
+        if (length < 2) continue;
+        bitBuffer |= static_cast<uint64_t>(value & ((1u << (length - 1)) - 1)) << bitCount;
+        bitCount += length - 1;
+        while (bitCount >= 8) {
+            raw.push_back(static_cast<unsigned char>(bitBuffer));
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    }
+    if (bitCount > 0) raw.push_back(static_cast<unsigned char>(bitBuffer));
+
+    // rANS runs backwards; the words are reversed so decoding reads forwards.
+    // Even values use state 0, odd values state 1.
+    std::vector<uint16_t> rans;
+    uint32_t x[2] = { RANS_L, RANS_L };
+    for (size_t i = values.size(); i-- > 0;) {
+        int s = bitLength(values[i]);
+        uint32_t& state = x[i & 1];
+        uint64_t xMax = static_cast<uint64_t>((RANS_L >> PROB_BITS) << 16) * freq[s];
+        if (state >= xMax) {
+            rans.push_back(static_cast<uint16_t>(state));
+            state >>= 16;
+        }
+        state = ((state / freq[s]) << PROB_BITS) + (state % freq[s]) + cumulative[s];
+    }
+    for (int lane = 1; lane >= 0; --lane) {
+        rans.push_back(static_cast<uint16_t>(x[lane]));
+        rans.push_back(static_cast<uint16_t>(x[lane] >> 16));
+    }
+    std::reverse(rans.begin(), rans.end());
+
+    put(out, static_cast<uint32_t>(rans.size() * sizeof(uint16_t)));
+    put(out, static_cast<uint32_t>(raw.size()));
+    for (int s = 0; s < ALPHABET; ++s) put(out, freq[s]);
+    for (uint16_t word : rans) put(out, word);
+    out.insert(out.end(), raw.begin(), raw.end());
+}
+
+/**
+ * @brief Decoder of one encodeStream block
+ */
+class StreamDecoder {
+public:
+    bool open(Cursor& cursor) {
+        uint32_t ransBytes = cursor.get<uint32_t>();
+        uint32_t rawBytes = cursor.get<uint32_t>();
+        uint16_t freq[ALPHABET];
+        uint32_t sum = 0;
+        for (int s = 0; s < ALPHABET; ++s) {
+            freq[s] = cursor.get<uint16_t>();
+            sum += freq[s];
+        }
+        if (!cursor.ok || sum != PROB_SCALE || ransBytes < 8 || ransBytes % 2
+            || static_cast<uint64_t>(cursor.end - cursor.ptr) < static_cast<uint64_t>(ransBytes) + rawBytes) {
+            return false;
+        }
+
+        uint32_t start = 0;
+        for (int s = 0; s < ALPHABET; ++s) {
+            for (uint32_t slot = start; slot < start + freq[s]; ++slot) {
+                m_slots[slot] = { static_cast<uint16_t>(freq[s]), static_cast<uint16_t>(slot - start),
+                                  static_cast<uint8_t>(s) };
+            }
+            start += freq[s];
+        }
+
+        Reader& r = m_reader;
+        r.rans = cursor.ptr;
+        r.ransEnd = cursor.ptr + ransBytes;
+        r.raw = r.ransEnd;
+        r.rawEnd = r.raw + rawBytes;
+        cursor.ptr = r.rawEnd;
+
+        for (int lane = 0; lane < 2; ++lane) {
+            r.state[lane] = readWord(r) << 16;
+            r.state[lane] |= readWord(r);
+        }
+        r.bitBuffer = 0;
+        r.bitCount = 0;
+        return true;
+    }
+
+    /**
+     * @brief Decode the next count values, calling f(index, value) for each in order
+     *
+     * The reader state lives in locals for the duration of the loop, and
+     * consecutive values alternate between the two rANS states.
+     */
+    template <typename F>
+    void decodeEach(size_t count, F&& f) {
+        Reader r = m_reader;
+        size_t i = 0;
+        for (; i + 1 < count; i += 2) {
+            f(i, next<0>(r));
+            f(i + 1, next<1>(r));
+        }
+        if (i < count) f(i, next<0>(r));
+        m_reader = r;
+    }
+
+private:
+    /**
+     * @brief Decoding entry of one probability slot
+     */
+    struct Slot {
+        uint16_t freq;
+        uint16_t bias;          // Slot offset within its symbol
+        uint8_t symbol;
+    };
+
+    /**
+     * @brief Position in the rANS words and the raw bits
+     */
+    struct Reader {
+        uint32_t state[2];
+        uint64_t bitBuffer;
+        int bitCount;
+        const unsigned char* rans;
+        const unsigned char* ransEnd;
+        const unsigned char* raw;
+        const unsigned char* rawEnd;
+    };
+
+    template <int Lane>
+    uint32_t next(Reader& r) const {
+        uint32_t& state = r.state[Lane];
+        const Slot& slot = m_slots[state & (PROB_SCALE - 1)];
+        state = slot.freq * (state >> PROB_BITS) + slot.bias;
+        if (state < RANS_L) state = (state << 16) | readWord(r);
+
+        // Bit length s: 0 and 1 are the value itself, otherwise s - 1 raw bits follow
+        int s = slot.symbol;
+        int extra = s > 1 ? s - 1 : 0;
+        if (r.bitCount < extra) refill(r);
+        uint32_t low = static_cast<uint32_t>(r.bitBuffer & ((1u << extra) - 1));
+        r.bitBuffer >>= extra;
+        r.bitCount -= extra;
+        return s > 1 ? (1u << extra) | low : static_cast<uint32_t>(s);
+    }
+
+    static uint32_t readWord(Reader& r) {
+        if (r.ransEnd - r.rans < 2) return 0;
+        uint16_t word;
+        std::memcpy(&word, r.rans, sizeof(word));
+        r.rans += sizeof(word);
+        return word;
+    }
+
+    /**
+     * @brief Top the bit buffer up to at least 56 bits (whole words while possible)
+     */
+    static void refill(Reader& r) {
+        if (r.rawEnd - r.raw >= 8) {
+            uint64_t word;
+            std::memcpy(&word, r.raw, sizeof(word));
+            r.bitBuffer |= word << r.bitCount;
+            r.raw += (63 - r.bitCount) >> 3;
+            r.bitCount |= 56;
+            return;
+        }
+        while (r.bitCount <= 56) {
+            uint64_t byte = r.raw < r.rawEnd ? *r.raw++ : 0;
+            r.bitBuffer |= byte << r.bitCount;
+            r.bitCount += 8;
+        }
+    }
+
+    Slot m_slots[PROB_SCALE];
+    Reader m_reader;
+};
+
+} // namespace
+
+BakeCodec::BakeCodec(int bits, int blockCount, size_t blockFloats, size_t foamCount)
+    : m_bits(std::clamp(bits, 1, 16))
+    , m_mask((1u << m_bits) - 1)
+    , m_blockCount(blockCount)
+    , m_blockFloats(blockFloats)
+    , m_foamCount(foamCount)
+    , m_historyFrames(0) {
+
+    size_t valueCount = static_cast<size_t>(blockCount) * blockFloats;
+    m_quantized.resize(valueCount);
+    m_residuals.reserve(groupLength());
+    for (int h = 0; h < 2; ++h) {
+        m_history[h].resize(valueCount);
+        m_historyMin[h].resize(groupCount());
+        m_historyStep[h].resize(groupCount());
+    }
+    m_foamHistory.resize(foamCount);
+}
+
+void BakeCodec::reset() {
+    m_historyFrames = 0;
+}
+
+uint32_t BakeCodec::predict(const Group& group, const uint16_t* current, const uint16_t* previous,
+                            const uint16_t* older, size_t i) const {
+    int64_t p;
+    if (group.predictor == PREDICT_SPATIAL) {
+        p = i > 0 ? current[3 * (i - 1)] : 0;
+    } else {
+        const int64_t round = int64_t(1) << (REMAP_BITS - 1);
+        p = (previous[3 * i] * group.scale[0] + group.offset[0] + round) >> REMAP_BITS;
+        if (group.predictor == PREDICT_LINEAR) {
+            p = 2 * p - ((older[3 * i] * group.scale[1] + group.offset[1] + round) >> REMAP_BITS);
+        }
+    }
+    return static_cast<uint32_t>(std::clamp<int64_t>(p, 0, m_mask));
+}
+
+void BakeCodec::encode(const float* texels, const unsigned char* foam, bool keyframe,
+                       std::vector<unsigned char>& out, float* reconstructed) {
+    if (keyframe) reset();
+    out.clear();
+    put(out, static_cast<uint8_t>(keyframe));
+    put(out, static_cast<uint8_t>(m_bits));
+    put(out, static_cast<uint16_t>(groupCount()));
+
+    const size_t length = groupLength();
+    std::vector<Group> groups(groupCount());
+    for (int g = 0; g < groupCount(); ++g) {
+        size_t base = (g / 3) * m_blockFloats + g % 3;
+        const float* values = texels + base;
+        uint16_t* q = m_quantized.data() + base;
+        Group& group = groups[g];
+
+        // Per-frame range of this component
+        float lo = values[0];
+        float hi = values[0];
+        for (size_t i = 1; i < length; ++i) {
+            lo = std::min(lo, values[3 * i]);
+            hi = std::max(hi, values[3 * i]);
+        }
+        group.min = lo;
+        group.step = (hi - lo) / static_cast<float>(m_mask);
+        float invStep = group.step > 0.0f ? 1.0f / group.step : 0.0f;
+        for (size_t i = 0; i < length; ++i) {
+            float scaled = (values[3 * i] - lo) * invStep + 0.5f;
+            q[3 * i] = static_cast<uint16_t>(std::min(static_cast<uint32_t>(scaled), m_mask));
+        }
+
+        // Fixed-point maps of the history into this range
+        int usable = group.step > 0.0f ? m_historyFrames : 0;
+        for (int h = 0; h < 2; ++h) {
+            group.scale[h] = 0;
+            group.offset[h] = 0;
+            if (h >= usable) continue;
+            double scale = m_historyStep[h][g] / static_cast<double>(group.step);
+            double offset = (m_historyMin[h][g] - static_cast<double>(lo)) / group.step;
+            if (std::abs(scale) > (1 << 20) || std::abs(offset) > double(int64_t(1) << 40)) {
+                usable = h;
+                continue;
+            }
+            group.scale[h] = std::llround(scale * (1 << REMAP_BITS));
+            group.offset[h] = std::llround(offset * (1 << REMAP_BITS));
+        }
+
+        // Cheapest predictor by total residual bit length
+        const uint16_t* previous = m_history[0].data() + base;
+        const uint16_t* older = m_history[1].data() + base;
+        uint64_t bestCost = UINT64_MAX;
+        uint32_t best = PREDICT_SPATIAL;
+        for (uint32_t predictor = PREDICT_SPATIAL; predictor <= static_cast<uint32_t>(usable); ++predictor) {
+            group.predictor = predictor;
+            uint64_t cost = 0;
+            for (size_t i = 0; i < length; ++i) {
+                cost += bitLength(wrapResidual(q[3 * i], predict(group, q, previous, older, i), m_mask));
+            }
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = predictor;
+            }
+        }
+        group.predictor = best;
+
+        put(out, group.min);
+        put(out, group.step);
+        put(out, group.predictor);
+        for (int h = 0; h < 2; ++h) {
+            put(out, group.scale[h]);
+            put(out, group.offset[h]);
+        }
+
+        m_residuals.clear();
+        for (size_t i = 0; i < length; ++i) {
+            m_residuals.push_back(wrapResidual(q[3 * i], predict(group, q, previous, older, i), m_mask));
+        }
+        encodeStream(m_residuals, out);
+
+        if (reconstructed) {
+            for (size_t i = 0; i < length; ++i) reconstructed[base + 3 * i] = lo + q[3 * i] * group.step;
+        }
+    }
+
+    // Foam is already 8-bit: predict from the previous frame or texel
+    if (m_foamCount) {
+        uint32_t predictor = m_historyFrames > 0 ? PREDICT_PREVIOUS : PREDICT_SPATIAL;
+        put(out, predictor);
+        m_residuals.clear();
+        for (size_t i = 0; i < m_foamCount; ++i) {
+            uint32_t p = predictor == PREDICT_PREVIOUS ? m_foamHistory[i] : (i > 0 ? foam[i - 1] : 0);
+            m_residuals.push_back(wrapResidual(foam[i], p, 0xff));
+        }
+        encodeStream(m_residuals, out);
+    }
+
+    pushHistory(groups, foam);
+}
+
+bool BakeCodec::decode(const unsigned char* data, size_t size, float* texels, unsigned char* foam) {
+    Cursor cursor{ data, data + size };
+    bool keyframe = cursor.get<uint8_t>() != 0;
+    int bits = cursor.get<uint8_t>();
+    int count = cursor.get<uint16_t>();
+    if (!cursor.ok || bits != m_bits || count != groupCount()) return false;
+    if (keyframe) reset();
+
+    const size_t length = groupLength();
+    std::vector<Group> groups(groupCount());
+    StreamDecoder stream;
+    for (int g = 0; g < groupCount(); ++g) {
+        Group& group = groups[g];
+        group.min = cursor.get<float>();
+        group.step = cursor.get<float>();
+        group.predictor = cursor.get<uint32_t>();
+        for (int h = 0; h < 2; ++h) {
+            group.scale[h] = cursor.get<int64_t>();
+            group.offset[h] = cursor.get<int64_t>();
+        }
+        if (!cursor.ok || group.predictor > static_cast<uint32_t>(m_historyFrames)) return false;
+        if (!stream.open(cursor)) return false;
+
+        size_t base = (g / 3) * m_blockFloats + g % 3;
+        uint16_t* q = m_quantized.data() + base;
+        const uint16_t* previous = m_history[0].data() + base;
+        const uint16_t* older = m_history[1].data() + base;
+        float* values = texels + base;
+
+        // One loop per predictor keeps the per-value work branch-free
+        const int64_t round = int64_t(1) << (REMAP_BITS - 1);
+        const int64_t mask = m_mask;
+        const uint32_t valueMask = m_mask;
+        if (group.predictor == PREDICT_SPATIAL) {
+            uint32_t p = 0;
+            stream.decodeEach(length, [&](size_t i, uint32_t r) {
+                p = (p + static_cast<uint32_t>(unzigzag(r))) & valueMask;
+                q[3 * i] = static_cast<uint16_t>(p);
+            });
+        } else if (group.predictor == PREDICT_PREVIOUS) {
+            stream.decodeEach(length, [&](size_t i, uint32_t r) {
+                int64_t p = (previous[3 * i] * group.scale[0] + group.offset[0] + round) >> REMAP_BITS;
+                p = std::min(std::max(p, int64_t(0)), mask);
+                q[3 * i] = static_cast<uint16_t>((static_cast<uint32_t>(p) + static_cast<uint32_t>(unzigzag(r))) & valueMask);
+            });
+        } else {
+            stream.decodeEach(length, [&](size_t i, uint32_t r) {
+                int64_t p = 2 * ((previous[3 * i] * group.scale[0] + group.offset[0] + round) >> REMAP_BITS)
+                          - ((older[3 * i] * group.scale[1] + group.offset[1] + round) >> REMAP_BITS);
+                p = std::min(std::max(p, int64_t(0)), mask);
+                q[3 * i] = static_cast<uint16_t>((static_cast<uint32_t>(p) + static_cast<uint32_t>(unzigzag(r))) & valueMask);
+            });
+        }
+        for (size_t i = 0; i < length; ++i) values[3 * i] = group.min + q[3 * i] * group.step;
+    }
+
+    if (m_foamCount) {
+        uint32_t predictor = cursor.get<uint32_t>();
+        if (!cursor.ok || predictor > (m_historyFrames > 0 ? PREDICT_PREVIOUS : PREDICT_SPATIAL)) return false;
+        if (!stream.open(cursor)) return false;
+        stream.decodeEach(m_foamCount, [&](size_t i, uint32_t r) {
+            uint32_t p = predictor == PREDICT_PREVIOUS ? m_foamHistory[i] : (i > 0 ? foam[i - 1] : 0);
+            foam[i] = static_cast<unsigned char>((p + static_cast<uint32_t>(unzigzag(r))) & 0xff);
+        });
+    }
+
+    pushHistory(groups, foam);
+    return true;
+}
+
+void BakeCodec::pushHistory(const std::vector<Group>& groups, const unsigned char* foam) {
+    std::swap(m_history[0], m_history[1]);
+    std::swap(m_historyMin[0], m_historyMin[1]);
+    std::swap(m_historyStep[0], m_historyStep[1]);
+    m_history[0].swap(m_quantized);     // The current frame is rewritten in full
+    for (int g = 0; g < groupCount(); ++g) {
+        m_historyMin[0][g] = groups[g].min;
+        m_historyStep[0][g] = groups[g].step;
+    }
+    if (m_foamCount) std::copy(foam, foam + m_foamCount, m_foamHistory.begin());
+    m_historyFrames = std::min(m_historyFrames + 1, 2);
+}
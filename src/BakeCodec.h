@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Lossy coder for baked ocean frames
+ *
+ * A frame is a sequence of blocks of RGB-interleaved floats (a displacement
+ * and a normal block per cascade) plus optional R8 foam. Every block
+ * component is quantized over its own per-frame range, predicted from the
+ * previous value, the previous frame or a linear extrapolation of the two
+ * previous frames (whichever is cheapest), and the residuals are entropy
+ * coded with rANS. Earlier frames are remapped into the current range with
+ * integer arithmetic stored in the frame, so encoder and decoder never drift.
+ * Keyframes use no temporal prediction and allow random access.
+ */
+class BakeCodec {
+public:
+    /**
+     * @param bits Quantization bits (1 to 16)
+     * @param blockCount Number of blocks per frame
+     * @param blockFloats Floats per block (a multiple of 3)
+     * @param foamCount Foam bytes per frame (0 without foam)
+     */
+    BakeCodec(int bits, int blockCount, size_t blockFloats, size_t foamCount);
+
+    /**
+     * @brief Forget the previous frames (the next frame must be a keyframe)
+     */
+    void reset();
+
+    /**
+     * @brief Encode the frame following the previously encoded one
+     * @param reconstructed If not null, receives the texels the decoder will produce
+     */
+    void encode(const float* texels, const unsigned char* foam, bool keyframe,
+                std::vector<unsigned char>& out, float* reconstructed = nullptr);
+
+    /**
+     * @brief Decode the frame following the previously decoded one
+     * @return false if the data is malformed or needs missing history
+     */
+    bool decode(const unsigned char* data, size_t size, float* texels, unsigned char* foam);
+
+private:
+    enum Predictor : uint32_t {
+        PREDICT_SPATIAL = 0,    // Previous value of the same component
+        PREDICT_PREVIOUS,       // Same value in the previous frame
+        PREDICT_LINEAR          // 2 * previous - the one before
+    };
+
+    /**
+     * @brief Quantization and prediction of one block component
+     */
+    struct Group {
+        float min;
+        float step;
+        uint32_t predictor;
+        int64_t scale[2];       // History frame h remapped into this range:
+        int64_t offset[2];      // (q * scale + offset) >> REMAP_BITS
+    };
+
+    static constexpr int REMAP_BITS = 16;
+
+    int m_bits;
+    uint32_t m_mask;
+    int m_blockCount;
+    size_t m_blockFloats;
+    size_t m_foamCount;
+
+    // Quantized history: [0] the previous frame, [1] the one before
+    std::vector<uint16_t> m_history[2];
+    std::vector<float> m_historyMin[2];     // Per group
+    std::vector<float> m_historyStep[2];
+    std::vector<unsigned char> m_foamHistory;
+    int m_historyFrames;                    // Valid history frames (0 to 2)
+
+    std::vector<uint16_t> m_quantized;      // Current frame
+    std::vector<uint32_t> m_residuals;      // Scratch, one group
+
+    size_t groupLength() const { return m_blockFloats / 3; }
+    int groupCount() const { return m_blockCount * 3; }
+
+    /**
+     * @brief Predicted quantized value of element i (stride 3) of a group
+     */
+    uint32_t predict(const Group& group, const uint16_t* current, const uint16_t* previous,
+                     const uint16_t* older, size_t i) const;
+
+    /**
+     * @brief Shift the current frame into the history
+     */
+    void pushHistory(const std::vector<Group>& groups, const unsigned char* foam);
+};
@@ -0,0 +1,537 @@
+#include "BakedAnimation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::is_trivially_copyable<BakeHeader>::value, "BakeHeader is written as raw bytes");
+static_assert(sizeof(BakeHeader) == 112, "BakeHeader layout must not depend on the compiler");
+static_assert(sizeof(BakeFrameEntry) == 16, "BakeFrameEntry layout must not depend on the compiler");
+
+namespace {
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+int quantizationBits(BakeEncoding encoding) {
+    return encoding == BakeEncoding::Quantized12 ? 12 : 16;
+}
+
+void reportStats(const BakeStats& stats, BakeEncoding encoding) {
+    if (encoding == BakeEncoding::Float32 || stats.encodedBytes == 0) return;
+    std::cout << "Encoded " << (stats.rawBytes >> 20) << " MB into " << (stats.encodedBytes >> 20) << " MB ("
+              << static_cast<double>(stats.rawBytes) / stats.encodedBytes << "x), error: displacement max "
+              << stats.maxDisplacementError << " m / rms " << stats.rmsDisplacementError
+              << ", normal max " << stats.maxNormalError << " / rms " << stats.rmsNormalError << "\n";
+}
+
+} // namespace
+
+// ============================================================================
+// BakeWriter
+// ============================================================================
+
+BakeWriter::BakeWriter()
+    : m_header{}
+    , m_offset(0)
+    , m_displacementSquares(0.0)
+    , m_normalSquares(0.0)
+    , m_displacementValues(0)
+    , m_normalValues(0) {}
+
+BakeWriter::~BakeWriter() {
+    if (m_file.is_open()) close();
+}
+
+bool BakeWriter::open(const std::string& path, const OceanFFT& ocean, float frameInterval,
+                      BakeEncoding encoding, int keyframeInterval) {
+    if (m_file.is_open()) close();
+
+    // The header describes one cascade set
+    if (ocean.getDepthRegionCount() > 1) {
+        std::cerr << "ERROR: Cannot bake an ocean with depth regions\n";
+        return false;
+    }
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        std::cerr << "ERROR: Cannot create baked animation: " << path << "\n";
+        return false;
+    }
+
+    m_header = BakeHeader{};
+    std::memcpy(m_header.magic, BAKE_MAGIC, sizeof(BAKE_MAGIC));
+    m_header.version = BAKE_VERSION;
+    m_header.resolution = static_cast<uint32_t>(ocean.getResolution());
+    m_header.cascadeCount = static_cast<uint32_t>(ocean.getCascadeCount());
+    m_header.mipLevels = ocean.getMipMode() == OceanFFT::MipMode::None ? 1 : ocean.getMipLevelCount();
+    m_header.encoding = static_cast<uint32_t>(encoding);
+    m_header.flags = ocean.isJacobianEnabled() ? BAKE_FLAG_FOAM : 0;
+    m_header.frameInterval = frameInterval;
+    m_header.keyframeInterval = encoding == BakeEncoding::Float32 ? 1 : static_cast<uint32_t>(std::max(keyframeInterval, 1));
+    for (int c = 0; c < ocean.getCascadeCount(); ++c) {
+        const OceanFFT::CascadeDesc& desc = ocean.getCascade(c);
+        m_header.patchSize[c] = desc.patchSize;
+        m_header.kMin[c] = desc.kMin;
+        m_header.kMax[c] = desc.kMax;
+    }
+    m_header.texelCount = ocean.getPackedTexelCount();
+    m_header.foamCount = ocean.getPackedFoamCount();
+
+    // A displacement and a normal block per cascade
+    m_codec.reset();
+    if (encoding != BakeEncoding::Float32) {
+        int blockCount = 2 * ocean.getCascadeCount();
+        m_codec = std::make_unique<BakeCodec>(quantizationBits(encoding), blockCount,
+                                              m_header.texelCount / blockCount, m_header.foamCount);
+        m_reconstructed.resize(m_header.texelCount);
+    }
+    m_stats = BakeStats{};
+    m_displacementSquares = m_normalSquares = 0.0;
+    m_displacementValues = m_normalValues = 0;
+
+    // Placeholder, rewritten with the frame count and table by close()
+    m_frames.clear();
+    m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_offset = sizeof(m_header);
+    return static_cast<bool>(m_file);
+}
+
+bool BakeWriter::appendFrame(const float* texels, const unsigned char* foam) {
+    if (!m_file.is_open()) return false;
+
+    uint64_t texelBytes = m_header.texelCount * sizeof(float);
+    m_stats.rawBytes += texelBytes + m_header.foamCount;
+
+    if (m_codec) {
+        bool keyframe = m_frames.size() % m_header.keyframeInterval == 0;
+        m_codec->encode(texels, foam, keyframe, m_encoded, m_reconstructed.data());
+        m_file.write(reinterpret_cast<const char*>(m_encoded.data()), static_cast<std::streamsize>(m_encoded.size()));
+        m_frames.push_back({ m_offset, m_encoded.size() });
+        m_offset += m_encoded.size();
+
+        // Error of what the reader will decode, displacement and normal blocks alternating
+        uint64_t blockFloats = m_header.texelCount / (2 * m_header.cascadeCount);
+        for (uint64_t i = 0; i < m_header.texelCount; ++i) {
+            double error = std::abs(static_cast<double>(m_reconstructed[i]) - texels[i]);
+            if ((i / blockFloats) % 2 == 0) {
+                m_stats.maxDisplacementError = std::max(m_stats.maxDisplacementError, error);
+                m_displacementSquares += error * error;
+                ++m_displacementValues;
+            } else {
+                m_stats.maxNormalError = std::max(m_stats.maxNormalError, error);
+                m_normalSquares += error * error;
+                ++m_normalValues;
+            }
+        }
+    } else {
+        // Page-aligned frames keep the mapped floats aligned and prefetch exact
+        uint64_t start = alignUp(m_offset, BAKE_FRAME_ALIGNMENT);
+        std::vector<char> padding(static_cast<size_t>(start - m_offset), 0);
+        m_file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+        m_file.write(reinterpret_cast<const char*>(texels), static_cast<std::streamsize>(texelBytes));
+        m_file.write(reinterpret_cast<const char*>(foam), static_cast<std::streamsize>(m_header.foamCount));
+
+        m_frames.push_back({ start, texelBytes + m_header.foamCount });
+        m_offset = start + m_frames.back().size;
+    }
+    m_stats.encodedBytes += m_frames.back().size;
+
+    if (!m_file) {
+        std::cerr << "ERROR: Failed to write baked frame " << m_frames.size() - 1 << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool BakeWriter::close() {
+    if (!m_file.is_open()) return false;
+
+    uint64_t tableOffset = alignUp(m_offset, alignof(BakeFrameEntry));
+    std::vector<char> padding(static_cast<size_t>(tableOffset - m_offset), 0);
+    m_file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+    m_file.write(reinterpret_cast<const char*>(m_frames.data()),
+                 static_cast<std::streamsize>(m_frames.size() * sizeof(BakeFrameEntry)));
+
+    m_header.frameCount = static_cast<uint32_t>(m_frames.size());
+    m_header.frameTableOffset = tableOffset;
+    m_file.seekp(0);
+    m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+
+    bool ok = static_cast<bool>(m_file);
+    m_file.close();
+    if (!ok) std::cerr << "ERROR: Failed to finish baked animation\n";
+    return ok;
+}
+
+BakeStats BakeWriter::getStats() const {
+    BakeStats stats = m_stats;
+    if (m_displacementValues) stats.rmsDisplacementError = std::sqrt(m_displacementSquares / m_displacementValues);
+    if (m_normalValues) stats.rmsNormalError = std::sqrt(m_normalSquares / m_normalValues);
+    return stats;
+}
+
+bool BakeWriter::bake(const std::string& path, const OceanFFT& ocean, int frameCount, float frameInterval,
+                      BakeEncoding encoding) {
+    std::cout << "Baking " << frameCount << " frames (" << frameInterval * frameCount << "s) to " << path << "...\n";
+
+    BakeWriter writer;
+    if (!writer.open(path, ocean, frameInterval, encoding)) return false;
+
+    bool ok = ocean.simulateOffline(frameCount, frameInterval,
+                                    [&writer](int, const float* texels, const unsigned char* foam) {
+        return writer.appendFrame(texels, foam);
+    });
+
+    reportStats(writer.getStats(), encoding);
+    return writer.close() && ok;
+}
+
+// ============================================================================
+// BakeJob
+// ============================================================================
+
+BakeJob::~BakeJob() {
+    cancel();
+}
+
+bool BakeJob::start(const std::string& path, const OceanFFT& ocean, int frameCount, float frameInterval,
+                    BakeEncoding encoding, int workerThreads) {
+    cancel();
+    if (frameCount < 1) {
+        std::cerr << "ERROR: Nothing to bake\n";
+        return false;
+    }
+
+    if (!m_writer.open(path, ocean, frameInterval, encoding)) return false;
+
+    // FFT planners are not thread-safe, so plan here rather than on the worker
+    m_simulator = ocean.createOfflineCopy(workerThreads);
+    if (!m_simulator) {
+        m_writer.close();
+        return false;
+    }
+    std::cout << "Baking " << frameCount << " frames (" << frameInterval * frameCount << "s) to " << path
+              << " in the background...\n";
+
+    m_frameCount = frameCount;
+    m_frameInterval = frameInterval;
+    m_encoding = encoding;
+    m_succeeded = false;
+    m_framesDone.store(0);
+    m_cancel.store(false);
+    m_finished.store(false);
+    m_worker = std::thread([this] {
+        bool ok = OceanFFT::runOffline(*m_simulator, 0, m_frameCount, m_frameInterval,
+                                       [this](int, const float* texels, const unsigned char* foam) {
+            if (m_cancel.load(std::memory_order_relaxed)) return false;
+            if (!m_writer.appendFrame(texels, foam)) return false;
+            m_framesDone.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        });
+        reportStats(m_writer.getStats(), m_encoding);
+        m_succeeded = m_writer.close() && ok;
+        m_finished.store(true, std::memory_order_release);
+    });
+    return true;
+}
+
+void BakeJob::cancel() {
+    m_cancel.store(true);
+    if (m_worker.joinable()) m_worker.join();
+    m_simulator.reset();
+}
+
+float BakeJob::getProgress() const {
+    if (m_frameCount == 0) return 0.0f;
+    return static_cast<float>(m_framesDone.load(std::memory_order_relaxed)) / m_frameCount;
+}
+
+// ============================================================================
+// BakedAnimation
+// ============================================================================
+
+BakedAnimation::BakedAnimation()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_header(nullptr)
+    , m_frames(nullptr)
+    , m_prefetchedFrame(-1)
+    , m_lastUsed(0)
+    , m_codecFrame(-1)
+    , m_decodeSeconds(0.0)
+    , m_decodeCount(0)
+#ifdef _WIN32
+    , m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(nullptr)
+#else
+    , m_file(-1)
+#endif
+{}
+
+BakedAnimation::~BakedAnimation() {
+    close();
+}
+
+bool BakedAnimation::open(const std::string& path) {
+    close();
+
+    // Map the whole file read-only; pages are faulted in on demand
+#ifdef _WIN32
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize{};
+    if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0) {
+        std::cerr << "ERROR: Cannot open baked animation: " << path << "\n";
+        close();
+        return false;
+    }
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        std::cerr << "ERROR: Cannot map baked animation: " << path << "\n";
+        close();
+        return false;
+    }
+    m_data = static_cast<const unsigned char*>(view);
+#else
+    m_file = ::open(path.c_str(), O_RDONLY);
+    struct stat info {};
+    if (m_file < 0 || fstat(m_file, &info) != 0 || info.st_size == 0) {
+        std::cerr << "ERROR: Cannot open baked animation: " << path << "\n";
+        close();
+        return false;
+    }
+    m_size = static_cast<size_t>(info.st_size);
+    void* view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+    if (view == MAP_FAILED) {
+        std::cerr << "ERROR: Cannot map baked animation: " << path << "\n";
+        close();
+        return false;
+    }
+    m_data = static_cast<const unsigned char*>(view);
+#endif
+
+    // Header, then the frame table, then every frame must lie inside the file
+    m_header = reinterpret_cast<const BakeHeader*>(m_data);
+    bool valid = m_size >= sizeof(BakeHeader)
+              && std::memcmp(m_header->magic, BAKE_MAGIC, sizeof(BAKE_MAGIC)) == 0
+              && m_header->version == BAKE_VERSION
+              && m_header->encoding <= static_cast<uint32_t>(BakeEncoding::Quantized12)
+              && m_header->keyframeInterval >= 1
+              && m_header->cascadeCount >= 1
+              && m_header->cascadeCount <= static_cast<uint32_t>(OceanFFT::MAX_CASCADES)
+              && m_header->frameCount >= 1
+              && m_header->frameInterval > 0.0f
+              && m_header->frameTableOffset % alignof(BakeFrameEntry) == 0
+              && m_header->frameTableOffset <= m_size
+              && (m_size - m_header->frameTableOffset) / sizeof(BakeFrameEntry) >= m_header->frameCount;
+    if (!valid) {
+        std::cerr << "ERROR: Not a valid baked animation: " << path << "\n";
+        close();
+        return false;
+    }
+
+    m_frames = reinterpret_cast<const BakeFrameEntry*>(m_data + m_header->frameTableOffset);
+    bool raw = getEncoding() == BakeEncoding::Float32;
+    uint64_t frameSize = m_header->texelCount * sizeof(float) + m_header->foamCount;
+    for (uint32_t i = 0; i < m_header->frameCount; ++i) {
+        const BakeFrameEntry& entry = m_frames[i];
+        bool sized = raw ? entry.size == frameSize && entry.offset % sizeof(float) == 0 : entry.size > 0;
+        if (!sized || entry.offset > m_size || m_size - entry.offset < entry.size) {
+            std::cerr << "ERROR: Baked animation frame " << i << " is out of bounds: " << path << "\n";
+            close();
+            return false;
+        }
+    }
+
+    // Compressed frames decode into two buffers (the pair being shown)
+    if (!raw) {
+        uint64_t blockCount = 2 * m_header->cascadeCount;
+        if (m_header->texelCount == 0 || m_header->texelCount % (3 * blockCount) != 0) {
+            std::cerr << "ERROR: Baked animation frame layout is invalid: " << path << "\n";
+            close();
+            return false;
+        }
+        m_codec = std::make_unique<BakeCodec>(quantizationBits(getEncoding()), static_cast<int>(blockCount),
+                                              m_header->texelCount / blockCount, m_header->foamCount);
+        for (DecodedFrame& decoded : m_decoded) {
+            decoded.texels.resize(m_header->texelCount);
+            decoded.foam.resize(m_header->foamCount);
+        }
+    }
+
+    std::cout << "Opened baked animation " << path << " (" << getFrameCount() << " frames, "
+              << getDuration() << "s, N=" << getResolution() << ", cascades=" << getCascadeCount() << ")\n";
+    return true;
+}
+
+void BakedAnimation::close() {
+#ifdef _WIN32
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if (m_data) munmap(const_cast<unsigned char*>(m_data), m_size);
+    if (m_file >= 0) ::close(m_file);
+    m_file = -1;
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_frames = nullptr;
+    m_prefetchedFrame = -1;
+
+    m_codec.reset();
+    for (DecodedFrame& decoded : m_decoded) decoded = DecodedFrame{};
+    m_lastUsed = 0;
+    m_codecFrame = -1;
+    m_decodeSeconds = 0.0;
+    m_decodeCount = 0;
+}
+
+const float* BakedAnimation::getFrameTexels(int frame) {
+    if (getEncoding() == BakeEncoding::Float32) {
+        return reinterpret_cast<const float*>(m_data + m_frames[frame].offset);
+    }
+    const DecodedFrame* decoded = decodeFrame(frame);
+    return decoded ? decoded->texels.data() : nullptr;
+}
+
+const unsigned char* BakedAnimation::getFrameFoam(int frame) {
+    if (!hasFoam()) return nullptr;
+    if (getEncoding() == BakeEncoding::Float32) {
+        return m_data + m_frames[frame].offset + m_header->texelCount * sizeof(float);
+    }
+    const DecodedFrame* decoded = decodeFrame(frame);
+    return decoded ? decoded->foam.data() : nullptr;
+}
+
+double BakedAnimation::getAverageDecodeMilliseconds() const {
+    return m_decodeCount ? m_decodeSeconds * 1000.0 / m_decodeCount : 0.0;
+}
+
+const BakedAnimation::DecodedFrame* BakedAnimation::decodeFrame(int frame) {
+    for (int slot = 0; slot < 2; ++slot) {
+        if (m_decoded[slot].frame == frame) {
+            m_lastUsed = slot;
+            return &m_decoded[slot];
+        }
+    }
+
+    // Continue from the codec's last frame when it leads up to this one,
+    // otherwise restart at the keyframe
+    auto start = std::chrono::steady_clock::now();
+    int keyframe = frame - frame % static_cast<int>(m_header->keyframeInterval);
+    int first = m_codecFrame >= keyframe && m_codecFrame < frame ? m_codecFrame + 1 : keyframe;
+
+    // Replace the less recently used buffer
+    int slot = m_lastUsed ^ 1;
+    DecodedFrame& target = m_decoded[slot];
+    target.frame = -1;
+    for (int i = first; i <= frame; ++i) {
+        const BakeFrameEntry& entry = m_frames[i];
+        if (!m_codec->decode(m_data + entry.offset, static_cast<size_t>(entry.size),
+                             target.texels.data(), target.foam.data())) {
+            std::cerr << "ERROR: Failed to decode baked frame " << i << "\n";
+            m_codecFrame = -1;
+            return nullptr;
+        }
+        m_codecFrame = i;
+    }
+    target.frame = frame;
+    m_lastUsed = slot;
+
+    m_decodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    m_decodeCount += frame - first + 1;
+    return &target;
+}
+
+void BakedAnimation::prefetch(int frame, int count) const {
+    for (int i = 0; i < count; ++i) {
+        const BakeFrameEntry& entry = m_frames[(frame + i) % getFrameCount()];
+
+        // Frames start on page boundaries; the OS reads ahead asynchronously
+#ifdef _WIN32
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = const_cast<unsigned char*>(m_data + entry.offset);
+        range.NumberOfBytes = static_cast<SIZE_T>(entry.size);
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+        madvise(const_cast<unsigned char*>(m_data + entry.offset), entry.size, MADV_WILLNEED);
+#endif
+    }
+}
+
+bool BakedAnimation::configure(OceanFFT& ocean) const {
+    if (!isOpen()) return false;
+    if (ocean.getResolution() != getResolution()) {
+        std::cerr << "ERROR: Baked animation resolution " << getResolution()
+                  << " does not match the ocean (" << ocean.getResolution() << ")\n";
+        return false;
+    }
+
+    // Same patches as the bake (the renderer tiles and scales by them), in deep water
+    if (!ocean.setDepthRegions({})) return false;
+    std::vector<OceanFFT::CascadeDesc> cascades(getCascadeCount());
+    bool changed = ocean.getCascadeCount() != getCascadeCount();
+    for (int c = 0; c < getCascadeCount(); ++c) {
+        cascades[c] = { m_header->patchSize[c], m_header->kMin[c], m_header->kMax[c] };
+        changed = changed || ocean.getCascade(c).patchSize != cascades[c].patchSize;
+    }
+    if (changed && !ocean.setCascades(cascades)) return false;
+
+    if (m_header->mipLevels == 1) {
+        ocean.setMipMode(OceanFFT::MipMode::None);
+    } else if (ocean.getMipMode() == OceanFFT::MipMode::None) {
+        ocean.setMipMode(OceanFFT::MipMode::BoxFilter);
+    }
+    ocean.setJacobianEnabled(hasFoam());
+
+    if (ocean.getPackedTexelCount() != m_header->texelCount || ocean.getPackedFoamCount() != m_header->foamCount) {
+        std::cerr << "ERROR: Baked animation frame layout does not match the ocean\n";
+        return false;
+    }
+
+    // Frame ids restart with this source, which also replaces any loop cache
+    ocean.clearLoopCache();
+    if (ocean.isPlayingBack()) ocean.stopPlayback();
+    return true;
+}
+
+void BakedAnimation::play(OceanFFT& ocean, double time) {
+    // O(1) access: frame index from time, offset from the frame table
+    const int frameCount = getFrameCount();
+    float position = static_cast<float>(std::fmod(time / getFrameInterval(), static_cast<double>(frameCount)));
+    if (position < 0.0f) position += frameCount;
+    int frame = std::min(static_cast<int>(position), frameCount - 1);
+    int next = (frame + 1) % frameCount;
+
+    if (frame != m_prefetchedFrame) {
+        prefetch(next, PREFETCH_FRAMES);
+        m_prefetchedFrame = frame;
+    }
+
+    OceanFFT::PackedFrame previous{ frame, getFrameTexels(frame), getFrameFoam(frame) };
+    OceanFFT::PackedFrame upcoming{ next, getFrameTexels(next), getFrameFoam(next) };
+    if (!previous.texels || !upcoming.texels) return;
+    ocean.playFrames(previous, upcoming, position - frame);
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+#include "BakeCodec.h"
+#include "OceanFFT.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief How the frames of a baked animation are stored
+ */
+enum class BakeEncoding : uint32_t {
+    Float32 = 0,    // OceanFFT::PackedFrame layout, uploaded as is
+    Quantized16,    // BakeCodec with 16-bit quantization
+    Quantized12     // BakeCodec with 12-bit quantization
+};
+
+/**
+ * @brief Fixed-size header at the start of a baked animation file
+ *
+ * Followed by the frames (Float32 frames start on BAKE_FRAME_ALIGNMENT
+ * boundaries) and the frame table at frameTableOffset. Values are in host
+ * byte order.
+ */
+struct BakeHeader {
+    char magic[4];                  // BAKE_MAGIC
+    uint32_t version;               // BAKE_VERSION
+    uint32_t resolution;            // N
+    uint32_t cascadeCount;
+    uint32_t mipLevels;             // Levels stored per cascade
+    uint32_t encoding;              // BakeEncoding
+    uint32_t flags;                 // BAKE_FLAG_*
+    uint32_t frameCount;
+    float frameInterval;            // Seconds between frames (dt)
+    uint32_t keyframeInterval;      // Frames between keyframes (compressed encodings)
+    float patchSize[OceanFFT::MAX_CASCADES];
+    float kMin[OceanFFT::MAX_CASCADES];
+    float kMax[OceanFFT::MAX_CASCADES];
+    uint64_t frameTableOffset;
+    uint64_t texelCount;            // Decoded floats per frame
+    uint64_t foamCount;             // Decoded foam bytes per frame
+};
+
+/**
+ * @brief Frame table entry: where one encoded frame lives in the file
+ */
+struct BakeFrameEntry {
+    uint64_t offset;
+    uint64_t size;
+};
+
+constexpr char BAKE_MAGIC[4] = { 'O', 'B', 'A', 'K' };
+constexpr uint32_t BAKE_VERSION = 1;
+constexpr uint32_t BAKE_FLAG_FOAM = 1;
+constexpr uint64_t BAKE_FRAME_ALIGNMENT = 4096;
+
+/**
+ * @brief Size and accuracy of an encoded bake, measured against the float source
+ */
+struct BakeStats {
+    uint64_t rawBytes = 0;              // Frames as Float32
+    uint64_t encodedBytes = 0;          // Frames as stored
+    double maxDisplacementError = 0.0;  // Meters
+    double rmsDisplacementError = 0.0;
+    double maxNormalError = 0.0;        // Per normal component
+    double rmsNormalError = 0.0;
+};
+
+/**
+ * @brief Writes OceanFFT frames into a baked animation file
+ */
+class BakeWriter {
+public:
+    BakeWriter();
+    ~BakeWriter();
+
+    // Non-copyable
+    BakeWriter(const BakeWriter&) = delete;
+    BakeWriter& operator=(const BakeWriter&) = delete;
+
+    /**
+     * @brief Start a file for frames of the ocean's current configuration
+     * @param frameInterval Seconds between consecutive frames
+     * @param keyframeInterval Frames between random access points (compressed encodings)
+     */
+    bool open(const std::string& path, const OceanFFT& ocean, float frameInterval,
+              BakeEncoding encoding = BakeEncoding::Float32, int keyframeInterval = 30);
+
+    /**
+     * @brief Append one frame (OceanFFT::PackedFrame layout)
+     * @param foam Ignored unless the ocean had foam enabled at open()
+     */
+    bool appendFrame(const float* texels, const unsigned char* foam);
+
+    /**
+     * @brief Write the frame table and the final header
+     */
+    bool close();
+
+    int getFrameCount() const { return static_cast<int>(m_frames.size()); }
+
+    /**
+     * @brief Compression ratio and decoded error of the frames written so far
+     */
+    BakeStats getStats() const;
+
+    /**
+     * @brief Simulate frameCount frames offline and write them to a file
+     */
+    static bool bake(const std::string& path, const OceanFFT& ocean, int frameCount, float frameInterval,
+                     BakeEncoding encoding = BakeEncoding::Float32);
+
+private:
+    std::ofstream m_file;
+    BakeHeader m_header;
+    std::vector<BakeFrameEntry> m_frames;
+    uint64_t m_offset;      // Next write position
+
+    // Compressed encodings
+    std::unique_ptr<BakeCodec> m_codec;
+    std::vector<unsigned char> m_encoded;
+    std::vector<float> m_reconstructed;
+    BakeStats m_stats;
+    double m_displacementSquares;   // Error sums for the RMS values
+    double m_normalSquares;
+    uint64_t m_displacementValues;
+    uint64_t m_normalValues;
+};
+
+/**
+ * @brief Bakes a file on a background thread
+ *
+ * Like OceanFFT::buildLoopCache: the file header and the offline copy of
+ * the ocean (with its FFT plans) are set up on the calling thread, the
+ * worker only simulates, encodes and writes.
+ */
+class BakeJob {
+public:
+    BakeJob() = default;
+    ~BakeJob();
+
+    // Non-copyable
+    BakeJob(const BakeJob&) = delete;
+    BakeJob& operator=(const BakeJob&) = delete;
+
+    /**
+     * @brief Start baking frameCount frames of the ocean's current configuration
+     * @param workerThreads Extra simulation threads of the offline copy
+     * @return false if the file could not be opened or planning failed
+     */
+    bool start(const std::string& path, const OceanFFT& ocean, int frameCount, float frameInterval,
+               BakeEncoding encoding = BakeEncoding::Float32, int workerThreads = 0);
+
+    /**
+     * @brief Stop the worker; the partial file is still closed and valid
+     */
+    void cancel();
+
+    bool isFinished() const { return m_finished.load(std::memory_order_acquire); }
+    bool succeeded() const { return isFinished() && m_succeeded; }
+    float getProgress() const;      // Share of the frames written
+
+private:
+    BakeWriter m_writer;
+    std::unique_ptr<OceanFFT> m_simulator;      // GL-free copy of the ocean
+    int m_frameCount = 0;
+    float m_frameInterval = 0.0f;
+    BakeEncoding m_encoding = BakeEncoding::Float32;
+    bool m_succeeded = false;                   // Written by the worker before m_finished
+    std::atomic<int> m_framesDone{0};
+    std::atomic<bool> m_cancel{false};
+    std::atomic<bool> m_finished{false};
+    std::thread m_worker;
+};
+
+/**
+ * @brief Memory-mapped baked animation with O(1) frame access
+ *
+ * Float32 frames are read straight out of the mapping and handed to
+ * OceanFFT::playFrames without copies; upcoming frames are prefetched
+ * so that page faults do not stall the upload. Compressed frames are
+ * decoded on demand, from the nearest keyframe when seeking.
+ */
+class BakedAnimation {
+public:
+    BakedAnimation();
+    ~BakedAnimation();
+
+    // Non-copyable
+    BakedAnimation(const BakedAnimation&) = delete;
+    BakedAnimation& operator=(const BakedAnimation&) = delete;
+
+    /**
+     * @brief Map a baked animation file and validate its header and frame table
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmap the file
+     */
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    int getFrameCount() const { return static_cast<int>(m_header->frameCount); }
+    float getFrameInterval() const { return m_header->frameInterval; }
+    float getDuration() const { return m_header->frameInterval * m_header->frameCount; }
+    int getResolution() const { return static_cast<int>(m_header->resolution); }
+    int getCascadeCount() const { return static_cast<int>(m_header->cascadeCount); }
+    bool hasFoam() const { return (m_header->flags & BAKE_FLAG_FOAM) != 0; }
+
+    BakeEncoding getEncoding() const { return static_cast<BakeEncoding>(m_header->encoding); }
+
+    /**
+     * @brief Frame data in PackedFrame layout (inside the mapping for Float32)
+     *
+     * Compressed frames are decoded into one of two buffers, so at most the
+     * two most recently requested frames stay valid; sequential access only
+     * decodes one frame per call.
+     * @return nullptr for the foam of files baked without foam, or on a decoding error
+     */
+    const float* getFrameTexels(int frame);
+    const unsigned char* getFrameFoam(int frame);
+
+    /**
+     * @brief Average time spent decoding a compressed frame
+     */
+    double getAverageDecodeMilliseconds() const;
+
+    /**
+     * @brief Ask the OS to read frames [frame, frame + count) ahead (wrapping)
+     */
+    void prefetch(int frame, int count) const;
+
+    /**
+     * @brief Match the ocean's cascades, mip chain and foam to the file
+     */
+    bool configure(OceanFFT& ocean) const;
+
+    /**
+     * @brief Show the (looped) animation at a time on a configured ocean
+     */
+    void play(OceanFFT& ocean, double time);
+
+private:
+    static constexpr int PREFETCH_FRAMES = 4;
+
+    /**
+     * @brief One decoded compressed frame
+     */
+    struct DecodedFrame {
+        int frame = -1;
+        std::vector<float> texels;
+        std::vector<unsigned char> foam;
+    };
+
+    /**
+     * @brief Decode a compressed frame (seeking back to its keyframe if needed)
+     */
+    const DecodedFrame* decodeFrame(int frame);
+
+    const unsigned char* m_data;        // Start of the mapping
+    size_t m_size;
+    const BakeHeader* m_header;
+    const BakeFrameEntry* m_frames;
+    int m_prefetchedFrame;              // Frame whose successors were last prefetched
+
+    // Compressed encodings
+    std::unique_ptr<BakeCodec> m_codec;
+    DecodedFrame m_decoded[2];
+    int m_lastUsed;                     // Slot of the most recently requested frame
+    int m_codecFrame;                   // Last frame the codec decoded, -1 if none
+    double m_decodeSeconds;
+    int m_decodeCount;
+
+#ifdef _WIN32
+    void* m_file;                       // HANDLE
+    void* m_mapping;                    // HANDLE
+#else
+    int m_file;                         // File descriptor
+#endif
+};
@@ -0,0 +1,402 @@
+#include "BuiltinFFT.h"
+#include <algorithm>
+#include <array>
+#include <vector>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OCEANFFT_HAS_SSE 1
+#endif
+
+namespace {
+
+constexpr int LANES = BuiltinFFTBackend::LANES;
+
+/**
+ * @brief Taylor series of sin and cos, accurate to double rounding on [-π/4, π/4]
+ */
+double sinSeries(double x) {
+    double term = x;
+    double sum = x;
+    for (int i = 1; i < 12; ++i) {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+double cosSeries(double x) {
+    double term = 1.0;
+    double sum = 1.0;
+    for (int i = 1; i < 12; ++i) {
+        term *= -x * x / ((2 * i - 1) * (2 * i));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * @brief exp(2πi q / n) as (re, im)
+ *
+ * Reduced to the first octant with exact integer arithmetic, so that
+ * twiddles related by symmetry are exactly negated or swapped.
+ */
+std::array<double, 2> unitRoot(long long q, long long n) {
+    const double HALF_PI = 1.57079632679489661923;
+    q %= n;
+    if (q < 0) q += n;
+    long long quadrant = 4 * q / n;
+    long long r = 4 * q - quadrant * n;      // Angle within the quadrant: (π/2) r / n
+    double c = 0.0;
+    double s = 0.0;
+    if (2 * r <= n) {
+        c = cosSeries(HALF_PI * static_cast<double>(r) / static_cast<double>(n));
+        s = sinSeries(HALF_PI * static_cast<double>(r) / static_cast<double>(n));
+    } else {
+        c = sinSeries(HALF_PI * static_cast<double>(n - r) / static_cast<double>(n));
+        s = cosSeries(HALF_PI * static_cast<double>(n - r) / static_cast<double>(n));
+    }
+    switch (quadrant) {
+        case 0: return { c, s };
+        case 1: return { -s, c };
+        case 2: return { -c, -s };
+        default: return { s, -c };
+    }
+}
+
+/**
+ * @brief One Stockham pass: sub-sequences of `length` elements, `stride` apart
+ *
+ * twiddle holds, per p < length / radix, the powers w^p ... w^((radix-1)p)
+ * of w = exp(2πi / length) as (re, im) pairs.
+ */
+struct Stage {
+    int radix;
+    int length;
+    int stride;
+    std::vector<float> twiddle;
+};
+
+/**
+ * @brief Inverse (exp(+2πi/n)) complex FFT of LANES interleaved sequences
+ *
+ * Element i of lane l lives at i * LANES + l of split real/imaginary arrays.
+ */
+class LaneFFT {
+public:
+    explicit LaneFFT(int n) : m_n(n) {
+        int length = n;
+        int stride = 1;
+        while (length > 1) {
+            Stage stage;
+            stage.radix = length % 4 == 0 ? 4 : 2;
+            stage.length = length;
+            stage.stride = stride;
+            int m = length / stage.radix;
+            for (int p = 0; p < m; ++p) {
+                for (int j = 1; j < stage.radix; ++j) {
+                    std::array<double, 2> w = unitRoot(static_cast<long long>(j) * p, length);
+                    stage.twiddle.push_back(static_cast<float>(w[0]));
+                    stage.twiddle.push_back(static_cast<float>(w[1]));
+                }
+            }
+            m_stages.push_back(std::move(stage));
+            length /= m_stages.back().radix;
+            stride *= m_stages.back().radix;
+        }
+    }
+
+    /**
+     * @brief Transform re/im in place (work arrays hold n * LANES floats each)
+     */
+    void inverse(float* re, float* im, float* workRe, float* workIm) const {
+        float* xr = re;
+        float* xi = im;
+        float* yr = workRe;
+        float* yi = workIm;
+        for (const Stage& stage : m_stages) {
+            if (stage.radix == 4) {
+                radix4(stage, xr, xi, yr, yi);
+            } else {
+                radix2(stage, xr, xi, yr, yi);
+            }
+            std::swap(xr, yr);
+            std::swap(xi, yi);
+        }
+        if (xr != re) {
+            std::copy(xr, xr + static_cast<size_t>(m_n) * LANES, re);
+            std::copy(xi, xi + static_cast<size_t>(m_n) * LANES, im);
+        }
+    }
+
+private:
+    int m_n;
+    std::vector<Stage> m_stages;
+
+    static void radix4(const Stage& stage, const float* xr, const float* xi, float* yr, float* yi) {
+        const int m = stage.length / 4;
+        const int run = stage.stride * LANES;     // Contiguous floats per butterfly input
+        for (int p = 0; p < m; ++p) {
+            const float* w = stage.twiddle.data() + 6 * p;
+            const size_t a = static_cast<size_t>(p) * run;
+            const size_t b = a + static_cast<size_t>(m) * run;
+            const size_t c = b + static_cast<size_t>(m) * run;
+            const size_t d = c + static_cast<size_t>(m) * run;
+            const size_t y0 = static_cast<size_t>(4 * p) * run;
+            const size_t y1 = y0 + run;
+            const size_t y2 = y1 + run;
+            const size_t y3 = y2 + run;
+            int t = 0;
+#ifdef OCEANFFT_HAS_SSE
+            const __m128 w1r = _mm_set1_ps(w[0]), w1i = _mm_set1_ps(w[1]);
+            const __m128 w2r = _mm_set1_ps(w[2]), w2i = _mm_set1_ps(w[3]);
+            const __m128 w3r = _mm_set1_ps(w[4]), w3i = _mm_set1_ps(w[5]);
+            for (; t + 4 <= run; t += 4) {
+                __m128 ar = _mm_loadu_ps(xr + a + t), ai = _mm_loadu_ps(xi + a + t);
+                __m128 br = _mm_loadu_ps(xr + b + t), bi = _mm_loadu_ps(xi + b + t);
+                __m128 cr = _mm_loadu_ps(xr + c + t), ci = _mm_loadu_ps(xi + c + t);
+                __m128 dr = _mm_loadu_ps(xr + d + t), di = _mm_loadu_ps(xi + d + t);
+                __m128 apcR = _mm_add_ps(ar, cr), apcI = _mm_add_ps(ai, ci);
+                __m128 amcR = _mm_sub_ps(ar, cr), amcI = _mm_sub_ps(ai, ci);
+                __m128 bpdR = _mm_add_ps(br, dr), bpdI = _mm_add_ps(bi, di);
+                __m128 bmdR = _mm_sub_ps(br, dr), bmdI = _mm_sub_ps(bi, di);
+
+                _mm_storeu_ps(yr + y0 + t, _mm_add_ps(apcR, bpdR));
+                _mm_storeu_ps(yi + y0 + t, _mm_add_ps(apcI, bpdI));
+
+                // (a - c) + i(b - d), (a + c) - (b + d), (a - c) - i(b - d), then twiddled
+                __m128 t1r = _mm_sub_ps(amcR, bmdI), t1i = _mm_add_ps(amcI, bmdR);
+                __m128 t2r = _mm_sub_ps(apcR, bpdR), t2i = _mm_sub_ps(apcI, bpdI);
+                __m128 t3r = _mm_add_ps(amcR, bmdI), t3i = _mm_sub_ps(amcI, bmdR);
+                _mm_storeu_ps(yr + y1 + t, _mm_sub_ps(_mm_mul_ps(w1r, t1r), _mm_mul_ps(w1i, t1i)));
+                _mm_storeu_ps(yi + y1 + t, _mm_add_ps(_mm_mul_ps(w1r, t1i), _mm_mul_ps(w1i, t1r)));
+                _mm_storeu_ps(yr + y2 + t, _mm_sub_ps(_mm_mul_ps(w2r, t2r), _mm_mul_ps(w2i, t2i)));
+                _mm_storeu_ps(yi + y2 + t, _mm_add_ps(_mm_mul_ps(w2r, t2i), _mm_mul_ps(w2i, t2r)));
+                _mm_storeu_ps(yr + y3 + t, _mm_sub_ps(_mm_mul_ps(w3r, t3r), _mm_mul_ps(w3i, t3i)));
+                _mm_storeu_ps(yi + y3 + t, _mm_add_ps(_mm_mul_ps(w3r, t3i), _mm_mul_ps(w3i, t3r)));
+            }
+#endif
+            for (; t < run; ++t) {
+                float apcR = xr[a + t] + xr[c + t], apcI = xi[a + t] + xi[c + t];
+                float amcR = xr[a + t] - xr[c + t], amcI = xi[a + t] - xi[c + t];
+                float bpdR = xr[b + t] + xr[d + t], bpdI = xi[b + t] + xi[d + t];
+                float bmdR = xr[b + t] - xr[d + t], bmdI = xi[b + t] - xi[d + t];
+
+                yr[y0 + t] = apcR + bpdR;
+                yi[y0 + t] = apcI + bpdI;
+
+                float t1r = amcR - bmdI, t1i = amcI + bmdR;
+                float t2r = apcR - bpdR, t2i = apcI - bpdI;
+                float t3r = amcR + bmdI, t3i = amcI - bmdR;
+                yr[y1 + t] = w[0] * t1r - w[1] * t1i;
+                yi[y1 + t] = w[0] * t1i + w[1] * t1r;
+                yr[y2 + t] = w[2] * t2r - w[3] * t2i;
+                yi[y2 + t] = w[2] * t2i + w[3] * t2r;
+                yr[y3 + t] = w[4] * t3r - w[5] * t3i;
+                yi[y3 + t] = w[4] * t3i + w[5] * t3r;
+            }
+        }
+    }
+
+    static void radix2(const Stage& stage, const float* xr, const float* xi, float* yr, float* yi) {
+        const int m = stage.length / 2;
+        const int run = stage.stride * LANES;
+        for (int p = 0; p < m; ++p) {
+            const float* w = stage.twiddle.data() + 2 * p;
+            const size_t a = static_cast<size_t>(p) * run;
+            const size_t b = a + static_cast<size_t>(m) * run;
+            const size_t y0 = static_cast<size_t>(2 * p) * run;
+            const size_t y1 = y0 + run;
+            int t = 0;
+#ifdef OCEANFFT_HAS_SSE
+            const __m128 wr = _mm_set1_ps(w[0]), wi = _mm_set1_ps(w[1]);
+            for (; t + 4 <= run; t += 4) {
+                __m128 ar = _mm_loadu_ps(xr + a + t), ai = _mm_loadu_ps(xi + a + t);
+                __m128 br = _mm_loadu_ps(xr + b + t), bi = _mm_loadu_ps(xi + b + t);
+                __m128 dr = _mm_sub_ps(ar, br), di = _mm_sub_ps(ai, bi);
+                _mm_storeu_ps(yr + y0 + t, _mm_add_ps(ar, br));
+                _mm_storeu_ps(yi + y0 + t, _mm_add_ps(ai, bi));
+                _mm_storeu_ps(yr + y1 + t, _mm_sub_ps(_mm_mul_ps(wr, dr), _mm_mul_ps(wi, di)));
+                _mm_storeu_ps(yi + y1 + t, _mm_add_ps(_mm_mul_ps(wr, di), _mm_mul_ps(wi, dr)));
+            }
+#endif
+            for (; t < run; ++t) {
+                float dr = xr[a + t] - xr[b + t];
+                float di = xi[a + t] - xi[b + t];
+                yr[y0 + t] = xr[a + t] + xr[b + t];
+                yi[y0 + t] = xi[a + t] + xi[b + t];
+                yr[y1 + t] = w[0] * dr - w[1] * di;
+                yi[y1 + t] = w[0] * di + w[1] * dr;
+            }
+        }
+    }
+};
+
+/**
+ * @brief 2D c2r: complex column transforms, then each row as a half-length
+ *        complex transform of its even/odd samples
+ *
+ * Both passes work on blocks of LANES columns or rows, which is also the
+ * unit of a fused execution.
+ */
+class BuiltinPlan : public FFTPlan {
+public:
+    BuiltinPlan(int size, int howMany)
+        : m_size(size)
+        , m_howMany(howMany)
+        , m_columns(size)
+        , m_rows(std::max(size / 2, 1)) {
+        for (int k = 0; k < size / 2; ++k) {
+            std::array<double, 2> w = unitRoot(k, size);
+            m_rowTwiddle.emplace_back(static_cast<float>(w[0]), static_cast<float>(w[1]));
+        }
+    }
+
+    void execute(std::complex<float>* spectra, float* planes) const override {
+        const int N = m_size;
+        const size_t spectrumSize = static_cast<size_t>(N) * (N / 2 + 1);
+        const size_t planeSize = static_cast<size_t>(N) * N;
+        float* re = scratch(4);
+        float* im = re + static_cast<size_t>(N) * LANES;
+        float* work = im + static_cast<size_t>(N) * LANES;
+
+        for (int batch = 0; batch < m_howMany; ++batch) {
+            std::complex<float>* spectrum = spectra + batch * spectrumSize;
+            float* plane = planes + batch * planeSize;
+            if (N == 1) {
+                plane[0] = spectrum[0].real();
+                continue;
+            }
+            for (int block = 0; block < getColumnBlockCount(); ++block) {
+                gatherColumns(spectrum, block * LANES, re, im);
+                transformColumnBlock(block * LANES, re, im, work, spectrum);
+            }
+            for (int block = 0; block < getRowBlockCount(); ++block) {
+                transformRowBlock(block * LANES, spectrum, plane, re, im, work);
+            }
+        }
+    }
+
+    int getColumnBlockCount() const override { return m_size > 1 ? (m_size / 2 + LANES) / LANES : 0; }
+    int getRowBlockCount() const override { return m_size > 1 ? (m_size + LANES - 1) / LANES : 0; }
+    int getRowsPerBlock() const override { return LANES; }
+
+    void transformColumns(int block, const ColumnSource& source, std::complex<float>* spectra) const override {
+        // Input of every batch entry, then the Stockham work arrays
+        const int N = m_size;
+        const size_t laneSize = static_cast<size_t>(N) * LANES;
+        float* re = scratch(2 * m_howMany + 2);
+        float* im = re + m_howMany * laneSize;
+        float* work = im + m_howMany * laneSize;
+        std::fill(re, work, 0.0f);
+
+        int x0 = block * LANES;
+        source(x0, std::min(LANES, N / 2 + 1 - x0), LANES, re, im);
+        for (int batch = 0; batch < m_howMany; ++batch) {
+            transformColumnBlock(x0, re + batch * laneSize, im + batch * laneSize, work,
+                                 spectra + batch * static_cast<size_t>(N) * (N / 2 + 1));
+        }
+    }
+
+    void transformRows(int block, const std::complex<float>* spectra, float* planes) const override {
+        const int N = m_size;
+        float* re = scratch(4);
+        float* im = re + static_cast<size_t>(N) * LANES;
+        float* work = im + static_cast<size_t>(N) * LANES;
+        for (int batch = 0; batch < m_howMany; ++batch) {
+            transformRowBlock(block * LANES, spectra + batch * static_cast<size_t>(N) * (N / 2 + 1),
+                              planes + batch * static_cast<size_t>(N) * N, re, im, work);
+        }
+    }
+
+private:
+    int m_size;
+    int m_howMany;
+    LaneFFT m_columns;                              // Length N
+    LaneFFT m_rows;                                 // Length N/2
+    std::vector<std::complex<float>> m_rowTwiddle;  // exp(2πik/N), k < N/2
+
+    /**
+     * @brief Per-thread scratch of `arrays` lane arrays (N * LANES floats each)
+     */
+    float* scratch(int arrays) const {
+        thread_local std::vector<float> buffer;
+        size_t required = static_cast<size_t>(arrays) * m_size * LANES;
+        if (buffer.size() < required) buffer.resize(required);
+        return buffer.data();
+    }
+
+    void gatherColumns(const std::complex<float>* spectrum, int x0, float* re, float* im) const {
+        const int N = m_size;
+        const int width = N / 2 + 1;
+        const int lanes = std::min(LANES, width - x0);
+        for (int z = 0; z < N; ++z) {
+            const std::complex<float>* src = spectrum + static_cast<size_t>(z) * width + x0;
+            float* dstRe = re + static_cast<size_t>(z) * LANES;
+            float* dstIm = im + static_cast<size_t>(z) * LANES;
+            for (int l = 0; l < LANES; ++l) {
+                dstRe[l] = l < lanes ? src[l].real() : 0.0f;
+                dstIm[l] = l < lanes ? src[l].imag() : 0.0f;
+            }
+        }
+    }
+
+    /**
+     * @brief Transform gathered columns x0.. and scatter them into spectrum
+     * @param work 2 * N * LANES floats
+     */
+    void transformColumnBlock(int x0, float* re, float* im, float* work, std::complex<float>* spectrum) const {
+        const int N = m_size;
+        const int width = N / 2 + 1;
+        const int lanes = std::min(LANES, width - x0);
+        m_columns.inverse(re, im, work, work + static_cast<size_t>(N) * LANES);
+        for (int z = 0; z < N; ++z) {
+            std::complex<float>* dst = spectrum + static_cast<size_t>(z) * width + x0;
+            const float* srcRe = re + static_cast<size_t>(z) * LANES;
+            const float* srcIm = im + static_cast<size_t>(z) * LANES;
+            for (int l = 0; l < lanes; ++l) dst[l] = std::complex<float>(srcRe[l], srcIm[l]);
+        }
+    }
+
+    void transformRowBlock(int z0, const std::complex<float>* spectrum, float* plane,
+                           float* re, float* im, float* work) const {
+        const int N = m_size;
+        const int half = N / 2;
+        const int width = half + 1;
+        const int lanes = std::min(LANES, N - z0);
+        for (int l = 0; l < LANES; ++l) {
+            const std::complex<float>* row = spectrum + static_cast<size_t>(z0 + std::min(l, lanes - 1)) * width;
+
+            // Z[k] = E[k] + i O[k] with E = X[k] + X*[N/2-k] (even samples) and
+            // O = (X[k] - X*[N/2-k]) exp(2πik/N) (odd samples). The imaginary
+            // parts of X[0] and X[N/2] are ignored, as in FFTW's c2r.
+            for (int k = 0; k < half; ++k) {
+                float ar = row[k].real();
+                float ai = k == 0 ? 0.0f : row[k].imag();
+                float br = row[half - k].real();
+                float bi = k == 0 ? 0.0f : -row[half - k].imag();
+                float dr = ar - br;
+                float di = ai - bi;
+                float oddR = dr * m_rowTwiddle[k].real() - di * m_rowTwiddle[k].imag();
+                float oddI = dr * m_rowTwiddle[k].imag() + di * m_rowTwiddle[k].real();
+                re[static_cast<size_t>(k) * LANES + l] = ar + br - oddI;
+                im[static_cast<size_t>(k) * LANES + l] = ai + bi + oddR;
+            }
+        }
+        m_rows.inverse(re, im, work, work + static_cast<size_t>(half) * LANES);
+        for (int l = 0; l < lanes; ++l) {
+            float* out = plane + static_cast<size_t>(z0 + l) * N;
+            for (int m = 0; m < half; ++m) {
+                out[2 * m] = re[static_cast<size_t>(m) * LANES + l];
+                out[2 * m + 1] = im[static_cast<size_t>(m) * LANES + l];
+            }
+        }
+    }
+};
+
+} // namespace
+
+std::unique_ptr<FFTPlan> BuiltinFFTBackend::planInverse2D(int size, int howMany, std::complex<float>*,
+                                                          float*, bool) {
+    if (size < 1 || size > MAX_SIZE || (size & (size - 1)) != 0 || howMany < 1) return nullptr;
+    return std::make_unique<BuiltinPlan>(size, howMany);
+}
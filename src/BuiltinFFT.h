@@ -0,0 +1,26 @@
+#pragma once
+
+#include "FFTBackend.h"
+
+/**
+ * @brief Dependency-free FFT backend for power-of-two sizes
+ *
+ * 1D transforms are radix-4 Stockham passes (plus one radix-2 pass for odd
+ * powers of two) with precomputed twiddles, run on LANES interleaved
+ * sequences at once so that every butterfly is a contiguous SIMD loop.
+ * A 2D inverse gathers LANES spectrum columns at a time (one cache line
+ * per row), transforms and scatters them back, then does the same for
+ * LANES rows, each computed as a half-length complex transform. Those
+ * blocks are exposed for fused execution (FFTPlan::transformColumns).
+ */
+class BuiltinFFTBackend : public FFTBackend {
+public:
+    static constexpr int LANES = 8;
+    static constexpr int MAX_SIZE = 1 << 14;
+
+    std::unique_ptr<FFTPlan> planInverse2D(int size, int howMany, std::complex<float>* spectra,
+                                           float* planes, bool anyAlignment) override;
+
+    Type getType() const override { return Type::Builtin; }
+    const char* getName() const override { return "Built-in"; }
+};
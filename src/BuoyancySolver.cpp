@@ -0,0 +1,199 @@
+#include "BuoyancySolver.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float PI = 3.14159265358979323846f;
+
+/**
+ * @brief Rotate v by the unit quaternion (x, y, z, w)
+ */
+inline glm::vec3 rotate(float x, float y, float z, float w, const glm::vec3& v) {
+    glm::vec3 axis(x, y, z);
+    glm::vec3 t = 2.0f * glm::cross(axis, v);
+    return v + w * t + glm::cross(axis, t);
+}
+
+/**
+ * @brief Share of a sphere's volume below a water level
+ * @param depth Depth of the sphere's lowest point below the water (may be negative)
+ */
+inline float submergedShare(float depth, float radius) {
+    float cap = std::min(std::max(depth, 0.0f), 2.0f * radius);
+    return cap * cap * (3.0f * radius - cap) / (4.0f * radius * radius * radius);
+}
+
+} // namespace
+
+BuoyancySolver::BuoyancySolver()
+    : m_waterDensity(1025.0f)
+    , m_linearDrag(1.0f)
+    , m_angularDrag(1.0f) {
+    m_pointStart.push_back(0);
+}
+
+int BuoyancySolver::addBody(const BodyDesc& desc, const std::vector<SamplePoint>& points) {
+    int body = getBodyCount();
+    glm::vec4 q = desc.orientation / std::sqrt(glm::dot(desc.orientation, desc.orientation));
+
+    m_posX.push_back(desc.position.x);
+    m_posY.push_back(desc.position.y);
+    m_posZ.push_back(desc.position.z);
+    m_rotX.push_back(q.x);
+    m_rotY.push_back(q.y);
+    m_rotZ.push_back(q.z);
+    m_rotW.push_back(q.w);
+    m_velX.push_back(desc.velocity.x);
+    m_velY.push_back(desc.velocity.y);
+    m_velZ.push_back(desc.velocity.z);
+    m_angX.push_back(desc.angularVelocity.x);
+    m_angY.push_back(desc.angularVelocity.y);
+    m_angZ.push_back(desc.angularVelocity.z);
+    m_mass.push_back(desc.mass);
+    m_invInertiaX.push_back(1.0f / desc.inertia.x);
+    m_invInertiaY.push_back(1.0f / desc.inertia.y);
+    m_invInertiaZ.push_back(1.0f / desc.inertia.z);
+
+    for (const SamplePoint& point : points) {
+        m_localX.push_back(point.position.x);
+        m_localY.push_back(point.position.y);
+        m_localZ.push_back(point.position.z);
+        m_radius.push_back(point.radius);
+        m_volume.push_back(4.0f / 3.0f * PI * point.radius * point.radius * point.radius);
+    }
+    m_pointStart.push_back(getSamplePointCount());
+
+    // Per-step buffers
+    size_t pointCount = m_localX.size();
+    for (std::vector<float>* buffer : { &m_worldX, &m_worldY, &m_worldZ, &m_waterHeight,
+                                        &m_waterVelX, &m_waterVelY, &m_waterVelZ }) {
+        buffer->resize(pointCount, 0.0f);
+    }
+    for (std::vector<float>* buffer : { &m_submerged, &m_forceX, &m_forceY, &m_forceZ,
+                                        &m_torqueX, &m_torqueY, &m_torqueZ }) {
+        buffer->resize(body + 1, 0.0f);
+    }
+    return body;
+}
+
+void BuoyancySolver::clear() {
+    for (std::vector<float>* buffer : { &m_posX, &m_posY, &m_posZ, &m_rotX, &m_rotY, &m_rotZ, &m_rotW,
+                                        &m_velX, &m_velY, &m_velZ, &m_angX, &m_angY, &m_angZ, &m_mass,
+                                        &m_invInertiaX, &m_invInertiaY, &m_invInertiaZ,
+                                        &m_localX, &m_localY, &m_localZ, &m_radius, &m_volume,
+                                        &m_worldX, &m_worldY, &m_worldZ, &m_waterHeight,
+                                        &m_waterVelX, &m_waterVelY, &m_waterVelZ,
+                                        &m_submerged, &m_forceX, &m_forceY, &m_forceZ,
+                                        &m_torqueX, &m_torqueY, &m_torqueZ }) {
+        buffer->clear();
+    }
+    m_pointStart.assign(1, 0);
+}
+
+void BuoyancySolver::step(OceanFFT& ocean, float dt) {
+    int bodyCount = getBodyCount();
+    if (bodyCount == 0 || dt <= 0.0f) return;
+
+    ThreadPool& pool = ocean.getThreadPool();
+    int tasks = (bodyCount + BODIES_PER_TASK - 1) / BODIES_PER_TASK;
+
+    pool.parallelFor(tasks, [&](int task) {
+        int begin = task * BODIES_PER_TASK;
+        placePoints(begin, std::min(begin + BODIES_PER_TASK, bodyCount));
+    });
+
+    // Water under every sample point in one batch (zero velocity unless enabled)
+    OceanFFT::SurfaceSamples water;
+    water.height = m_waterHeight.data();
+    water.velocityX = m_waterVelX.data();
+    water.velocityY = m_waterVelY.data();
+    water.velocityZ = m_waterVelZ.data();
+    ocean.sampleSurface(getSamplePointCount(), m_worldX.data(), m_worldZ.data(), water);
+
+    pool.parallelFor(tasks, [&](int task) {
+        int begin = task * BODIES_PER_TASK;
+        integrate(begin, std::min(begin + BODIES_PER_TASK, bodyCount), dt);
+    });
+}
+
+void BuoyancySolver::placePoints(int begin, int end) {
+    for (int body = begin; body < end; ++body) {
+        float qx = m_rotX[body], qy = m_rotY[body], qz = m_rotZ[body], qw = m_rotW[body];
+        for (int i = m_pointStart[body]; i < m_pointStart[body + 1]; ++i) {
+            glm::vec3 offset = rotate(qx, qy, qz, qw, glm::vec3(m_localX[i], m_localY[i], m_localZ[i]));
+            m_worldX[i] = m_posX[body] + offset.x;
+            m_worldY[i] = m_posY[body] + offset.y;
+            m_worldZ[i] = m_posZ[body] + offset.z;
+        }
+    }
+}
+
+void BuoyancySolver::integrate(int begin, int end, float dt) {
+    const float weight = m_waterDensity * GRAVITY;
+    for (int body = begin; body < end; ++body) {
+        glm::vec3 position(m_posX[body], m_posY[body], m_posZ[body]);
+        glm::vec3 velocity(m_velX[body], m_velY[body], m_velZ[body]);
+        glm::vec3 angular(m_angX[body], m_angY[body], m_angZ[body]);
+
+        // Buoyancy and drag of the submerged share of each sample sphere
+        glm::vec3 force(0.0f);
+        glm::vec3 torque(0.0f);
+        float submerged = 0.0f;
+        float volume = 0.0f;
+        for (int i = m_pointStart[body]; i < m_pointStart[body + 1]; ++i) {
+            volume += m_volume[i];
+            float depth = m_waterHeight[i] - (m_worldY[i] - m_radius[i]);
+            if (depth <= 0.0f) continue;
+
+            float pointVolume = m_volume[i] * submergedShare(depth, m_radius[i]);
+            glm::vec3 arm(m_worldX[i] - position.x, m_worldY[i] - position.y, m_worldZ[i] - position.z);
+            glm::vec3 relative = velocity + glm::cross(angular, arm)
+                               - glm::vec3(m_waterVelX[i], m_waterVelY[i], m_waterVelZ[i]);
+            glm::vec3 pointForce = glm::vec3(0.0f, weight * pointVolume, 0.0f)
+                                 - (m_waterDensity * m_linearDrag * pointVolume) * relative;
+            force += pointForce;
+            torque += glm::cross(arm, pointForce);
+            submerged += pointVolume;
+        }
+        m_submerged[body] = submerged;
+        m_forceX[body] = force.x;
+        m_forceY[body] = force.y;
+        m_forceZ[body] = force.z;
+        m_torqueX[body] = torque.x;
+        m_torqueY[body] = torque.y;
+        m_torqueZ[body] = torque.z;
+
+        // Semi-implicit Euler with gravity
+        velocity += dt * (force / m_mass[body] + glm::vec3(0.0f, -GRAVITY, 0.0f));
+        position += dt * velocity;
+
+        // Angular: I⁻¹ = R diag(1/I) Rᵀ, damped by the submerged share
+        float qx = m_rotX[body], qy = m_rotY[body], qz = m_rotZ[body], qw = m_rotW[body];
+        glm::vec3 local = rotate(-qx, -qy, -qz, qw, torque);
+        local = local * glm::vec3(m_invInertiaX[body], m_invInertiaY[body], m_invInertiaZ[body]);
+        angular += dt * rotate(qx, qy, qz, qw, local);
+        if (volume > 0.0f) angular /= 1.0f + dt * m_angularDrag * submerged / volume;
+
+        // q += dt/2 (ω, 0) q, renormalized
+        glm::vec3 axis(qx, qy, qz);
+        glm::vec3 dAxis = 0.5f * dt * (qw * angular + glm::cross(angular, axis));
+        float dW = -0.5f * dt * glm::dot(angular, axis);
+        glm::vec4 q(qx + dAxis.x, qy + dAxis.y, qz + dAxis.z, qw + dW);
+        q /= std::sqrt(glm::dot(q, q));
+
+        m_posX[body] = position.x;
+        m_posY[body] = position.y;
+        m_posZ[body] = position.z;
+        m_velX[body] = velocity.x;
+        m_velY[body] = velocity.y;
+        m_velZ[body] = velocity.z;
+        m_angX[body] = angular.x;
+        m_angY[body] = angular.y;
+        m_angZ[body] = angular.z;
+        m_rotX[body] = q.x;
+        m_rotY[body] = q.y;
+        m_rotZ[body] = q.z;
+        m_rotW[body] = q.w;
+    }
+}
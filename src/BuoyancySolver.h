@@ -0,0 +1,131 @@
+#pragma once
+
+#include "OceanFFT.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Buoyancy and integration of many floating rigid bodies
+ *
+ * Bodies are stored as structure-of-arrays and carry a few sample points,
+ * each standing for a small sphere of the hull. step() moves every sample
+ * point into the world, queries the ocean under all of them in a single
+ * OceanFFT::sampleSurface batch, turns the submerged share of each point
+ * into buoyancy and drag, and integrates the bodies in parallel on the
+ * ocean's thread pool.
+ *
+ * Positions are in the ocean's simulation frame (see OceanFFT::probe),
+ * y up, in meters.
+ */
+class BuoyancySolver {
+public:
+    /**
+     * @brief One sample point of a body
+     */
+    struct SamplePoint {
+        glm::vec3 position;     // Body space, relative to the centre of mass
+        float radius;           // Of the sphere it stands for (volume 4/3 π r³)
+    };
+
+    /**
+     * @brief Initial state and mass properties of a body
+     */
+    struct BodyDesc {
+        glm::vec3 position{ 0.0f };
+        glm::vec4 orientation{ 0.0f, 0.0f, 0.0f, 1.0f };   // Unit quaternion (x, y, z, w)
+        glm::vec3 velocity{ 0.0f };
+        glm::vec3 angularVelocity{ 0.0f };                  // World space, rad/s
+        float mass = 1.0f;                                  // kg
+        glm::vec3 inertia{ 1.0f };                          // Principal moments, body space (kg m²)
+    };
+
+    BuoyancySolver();
+
+    /**
+     * @brief Add a body
+     * @return Its index (bodies are never reordered)
+     */
+    int addBody(const BodyDesc& desc, const std::vector<SamplePoint>& points);
+
+    /**
+     * @brief Remove every body
+     */
+    void clear();
+
+    /**
+     * @brief Advance every body by dt against the ocean's last update()
+     *
+     * Surface velocity (for the drag) is used when the ocean produces it
+     * (OceanFFT::setVelocityEnabled), otherwise the water is taken as still.
+     */
+    void step(OceanFFT& ocean, float dt);
+
+    // Parameters
+    void setWaterDensity(float density) { m_waterDensity = density; }
+    void setLinearDrag(float drag) { m_linearDrag = drag; }
+    void setAngularDrag(float drag) { m_angularDrag = drag; }
+    float getWaterDensity() const { return m_waterDensity; }
+    float getLinearDrag() const { return m_linearDrag; }
+    float getAngularDrag() const { return m_angularDrag; }
+
+    // Body state (SoA, index = body)
+    int getBodyCount() const { return static_cast<int>(m_mass.size()); }
+    int getSamplePointCount() const { return static_cast<int>(m_localX.size()); }
+    glm::vec3 getPosition(int body) const { return glm::vec3(m_posX[body], m_posY[body], m_posZ[body]); }
+    glm::vec4 getOrientation(int body) const {
+        return glm::vec4(m_rotX[body], m_rotY[body], m_rotZ[body], m_rotW[body]);
+    }
+    glm::vec3 getVelocity(int body) const { return glm::vec3(m_velX[body], m_velY[body], m_velZ[body]); }
+
+    /**
+     * @brief Results of the last step()
+     */
+    float getSubmergedVolume(int body) const { return m_submerged[body]; }     // m³
+    glm::vec3 getForce(int body) const { return glm::vec3(m_forceX[body], m_forceY[body], m_forceZ[body]); }
+    glm::vec3 getTorque(int body) const {
+        return glm::vec3(m_torqueX[body], m_torqueY[body], m_torqueZ[body]);
+    }
+
+private:
+    // Physics constants
+    static constexpr float GRAVITY = 9.81f;     // m/s²
+    static constexpr int BODIES_PER_TASK = 256;
+
+    float m_waterDensity;       // kg/m³
+    float m_linearDrag;         // Drag per submerged volume and relative speed (1/s)
+    float m_angularDrag;        // Angular velocity damping while submerged (1/s)
+
+    // Bodies
+    std::vector<float> m_posX, m_posY, m_posZ;
+    std::vector<float> m_rotX, m_rotY, m_rotZ, m_rotW;
+    std::vector<float> m_velX, m_velY, m_velZ;
+    std::vector<float> m_angX, m_angY, m_angZ;
+    std::vector<float> m_mass;
+    std::vector<float> m_invInertiaX, m_invInertiaY, m_invInertiaZ;
+    std::vector<int> m_pointStart;      // First sample point of each body (body count + 1 entries)
+
+    // Sample points
+    std::vector<float> m_localX, m_localY, m_localZ;
+    std::vector<float> m_radius;
+    std::vector<float> m_volume;
+
+    // Per step: world positions of the sample points and the water there
+    std::vector<float> m_worldX, m_worldY, m_worldZ;
+    std::vector<float> m_waterHeight;
+    std::vector<float> m_waterVelX, m_waterVelY, m_waterVelZ;
+
+    // Per step results
+    std::vector<float> m_submerged;
+    std::vector<float> m_forceX, m_forceY, m_forceZ;
+    std::vector<float> m_torqueX, m_torqueY, m_torqueZ;
+
+    /**
+     * @brief Rotate every sample point of bodies [begin, end) into the world
+     */
+    void placePoints(int begin, int end);
+
+    /**
+     * @brief Accumulate forces and torques of bodies [begin, end) and integrate them
+     */
+    void integrate(int begin, int end, float dt);
+};
@@ -0,0 +1,127 @@
+#include "ComputeSimulation.h"
+#include <iostream>
+#include <string>
+
+namespace {
+
+constexpr int PLANE_COUNT = 3;
+constexpr int GROUP_SIZE = 16;  // Local size of the evolve and pack shaders (per axis)
+
+} // namespace
+
+ComputeSimulation::~ComputeSimulation() {
+    release();
+}
+
+bool ComputeSimulation::isSupported() {
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+bool ComputeSimulation::initialize(int N, int cascadeCount) {
+    release();
+    if (!isSupported()) {
+        std::cerr << "ERROR: GPU simulation needs OpenGL 4.3 compute shaders\n";
+        return false;
+    }
+
+    // One invocation per butterfly and two lines of shared memory per work group
+    GLint maxInvocations = 0;
+    GLint maxSharedMemory = 0;
+    glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &maxInvocations);
+    glGetIntegerv(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE, &maxSharedMemory);
+    if (N < GROUP_SIZE || (N & (N - 1)) != 0 || N / 2 > maxInvocations
+        || static_cast<GLint>(2 * N * 2 * sizeof(float)) > maxSharedMemory) {
+        std::cerr << "ERROR: GPU simulation does not support N=" << N << "\n";
+        return false;
+    }
+
+    std::string defines = "#define FFT_SIZE " + std::to_string(N) + "\n"
+                        + "#define FFT_HALF_SIZE " + std::to_string(N / 2) + "\n";
+    if (!m_evolveProgram.loadComputeFromFile("shaders/ocean_evolve.comp", defines)
+        || !m_fftProgram.loadComputeFromFile("shaders/ocean_fft.comp", defines)
+        || !m_packProgram.loadComputeFromFile("shaders/ocean_pack.comp", defines)) {
+        release();
+        return false;
+    }
+
+    m_N = N;
+    size_t bins = static_cast<size_t>(N) * (N / 2 + 1);
+    m_spectrumBuffers.resize(cascadeCount);
+    m_dispersionBuffers.resize(cascadeCount);
+    glGenBuffers(cascadeCount, m_spectrumBuffers.data());
+    glGenBuffers(cascadeCount, m_dispersionBuffers.data());
+    for (int c = 0; c < cascadeCount; ++c) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_spectrumBuffers[c]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bins * sizeof(glm::vec4), nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_dispersionBuffers[c]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bins * sizeof(double), nullptr, GL_STATIC_DRAW);
+    }
+
+    glGenBuffers(1, &m_planeBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_planeBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, PLANE_COUNT * static_cast<size_t>(N) * N * 2 * sizeof(float),
+                 nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    std::cout << "GPU simulation ready (N=" << N << ", cascades=" << cascadeCount << ")\n";
+    return true;
+}
+
+void ComputeSimulation::setSpectrum(int cascade, const std::vector<glm::vec4>& h0, const std::vector<double>& omega) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_spectrumBuffers[cascade]);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, h0.size() * sizeof(glm::vec4), h0.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_dispersionBuffers[cascade]);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, omega.size() * sizeof(double), omega.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void ComputeSimulation::simulate(int cascade, double time, float patchSize, float choppy,
+                                 GLuint displacement, GLuint normals, int firstLayer, int layerCount) {
+    const GLuint groups = static_cast<GLuint>(m_N / GROUP_SIZE);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_spectrumBuffers[cascade]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_dispersionBuffers[cascade]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_planeBuffer);
+
+    // h(k,t) and the derived fields over the full grid
+    m_evolveProgram.use();
+    m_evolveProgram.setUniform("uTime", time);
+    m_evolveProgram.setUniform("uPatchSize", patchSize);
+    glDispatchCompute(groups, groups, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // Rows, then columns, of every plane
+    m_fftProgram.use();
+    for (bool vertical : { false, true }) {
+        m_fftProgram.setUniform("uVertical", vertical);
+        glDispatchCompute(static_cast<GLuint>(m_N), PLANE_COUNT, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // Level-0 texels of each receiving layer
+    glBindImageTexture(0, displacement, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    glBindImageTexture(1, normals, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    m_packProgram.use();
+    m_packProgram.setUniform("uScale", 1.0f / (static_cast<float>(m_N) * m_N));
+    m_packProgram.setUniform("uChoppy", choppy);
+    for (int layer = firstLayer; layer < firstLayer + layerCount; ++layer) {
+        m_packProgram.setUniform("uLayer", layer);
+        glDispatchCompute(groups, groups, 1);
+    }
+
+    // The next cascade reuses the planes; the renderer and mip generation read the images
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+                    | GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glUseProgram(0);
+}
+
+void ComputeSimulation::release() {
+    if (!m_spectrumBuffers.empty()) {
+        glDeleteBuffers(static_cast<GLsizei>(m_spectrumBuffers.size()), m_spectrumBuffers.data());
+        glDeleteBuffers(static_cast<GLsizei>(m_dispersionBuffers.size()), m_dispersionBuffers.data());
+    }
+    m_spectrumBuffers.clear();
+    m_dispersionBuffers.clear();
+    if (m_planeBuffer) glDeleteBuffers(1, &m_planeBuffer);
+    m_planeBuffer = 0;
+    m_N = 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ShaderProgram.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Spectrum evolution, inverse FFT and texel packing in GL 4.3 compute shaders
+ *
+ * The spectrum of every cascade is uploaded once (setSpectrum). Each
+ * simulate() evolves one cascade over the full N x N grid, transforms it
+ * with shared-memory Stockham passes (one work group per row, then per
+ * column) and writes displacement and normal texels straight into level 0
+ * of RGBA32F array textures; nothing crosses the bus per frame. The five
+ * render fields are real, so they travel as three complex planes
+ * (Dx + i h, Dz + i ∂h/∂x, ∂h/∂z).
+ *
+ * Arithmetic is float throughout, like Precision::Single. The shaders are
+ * compiled for the resolution, read from shaders/ocean_*.comp.
+ */
+class ComputeSimulation {
+public:
+    ComputeSimulation() = default;
+    ~ComputeSimulation();
+
+    ComputeSimulation(const ComputeSimulation&) = delete;
+    ComputeSimulation& operator=(const ComputeSimulation&) = delete;
+
+    /**
+     * @brief Whether the current context has compute shaders (GL 4.3)
+     */
+    static bool isSupported();
+
+    /**
+     * @brief Build the programs and buffers
+     * @param N Resolution (power of two, 16 up to the work group limits)
+     * @return false without support, for an unsupported size or if a shader fails
+     */
+    bool initialize(int N, int cascadeCount);
+
+    /**
+     * @brief Replace the spectrum of a cascade
+     * @param h0 Per half-complex bin: (h0(k), h0*(-k)), zero for bins not evolved
+     * @param omega Per half-complex bin: ω(k), in double so that the phase
+     *        ωt is reduced without losing precision at large t
+     */
+    void setSpectrum(int cascade, const std::vector<glm::vec4>& h0, const std::vector<double>& omega);
+
+    /**
+     * @brief Evolve, transform and pack one cascade into level 0 of texture layers
+     * @param displacement, normals RGBA32F 2D array textures
+     * @param firstLayer, layerCount Layers receiving the frame
+     */
+    void simulate(int cascade, double time, float patchSize, float choppy,
+                  GLuint displacement, GLuint normals, int firstLayer, int layerCount);
+
+private:
+    int m_N = 0;
+    ShaderProgram m_evolveProgram;
+    ShaderProgram m_fftProgram;
+    ShaderProgram m_packProgram;
+    std::vector<GLuint> m_spectrumBuffers;      // vec4 (h0, h0Conj) per bin, per cascade
+    std::vector<GLuint> m_dispersionBuffers;    // double ω per bin, per cascade
+    GLuint m_planeBuffer = 0;                   // Three complex N x N planes
+
+    void release();
+};
@@ -0,0 +1,74 @@
+#include "FFTBackend.h"
+#include "BuiltinFFT.h"
+#ifdef OCEANFFT_HAS_FFTW
+#include <fftw3.h>
+#endif
+
+#ifdef OCEANFFT_HAS_FFTW
+namespace {
+
+/**
+ * @brief Batched fftwf_plan_many_dft_c2r plan, run through the new-array interface
+ */
+class FFTWPlan : public FFTPlan {
+public:
+    explicit FFTWPlan(fftwf_plan plan) : m_plan(plan) {}
+    ~FFTWPlan() override { fftwf_destroy_plan(m_plan); }
+
+    FFTWPlan(const FFTWPlan&) = delete;
+    FFTWPlan& operator=(const FFTWPlan&) = delete;
+
+    void execute(std::complex<float>* spectra, float* planes) const override {
+        fftwf_execute_dft_c2r(m_plan, reinterpret_cast<fftwf_complex*>(spectra), planes);
+    }
+
+private:
+    fftwf_plan m_plan;
+};
+
+class FFTWBackend : public FFTBackend {
+public:
+    std::unique_ptr<FFTPlan> planInverse2D(int size, int howMany, std::complex<float>* spectra,
+                                           float* planes, bool anyAlignment) override {
+        int n[2] = { size, size };
+        fftwf_plan plan = fftwf_plan_many_dft_c2r(
+            2, n, howMany,
+            reinterpret_cast<fftwf_complex*>(spectra), nullptr, 1, size * (size / 2 + 1),
+            planes, nullptr, 1, size * size,
+            FFTW_ESTIMATE | (anyAlignment ? FFTW_UNALIGNED : 0u)
+        );
+        if (!plan) return nullptr;
+        return std::make_unique<FFTWPlan>(plan);
+    }
+
+    Type getType() const override { return Type::FFTW; }
+    const char* getName() const override { return "FFTW"; }
+};
+
+} // namespace
+#endif
+
+std::unique_ptr<FFTBackend> FFTBackend::create(Type type) {
+    switch (type) {
+#ifdef OCEANFFT_HAS_FFTW
+        case Type::FFTW:
+            return std::make_unique<FFTWBackend>();
+#endif
+        case Type::Builtin:
+            return std::make_unique<BuiltinFFTBackend>();
+        default:
+            return nullptr;
+    }
+}
+
+bool FFTBackend::isAvailable(Type type) {
+#ifdef OCEANFFT_HAS_FFTW
+    return type == Type::FFTW || type == Type::Builtin;
+#else
+    return type == Type::Builtin;
+#endif
+}
+
+FFTBackend::Type FFTBackend::getDefaultType() {
+    return isAvailable(Type::FFTW) ? Type::FFTW : Type::Builtin;
+}
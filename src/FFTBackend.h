@@ -0,0 +1,94 @@
+#pragma once
+
+#include <complex>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief A planned batch of 2D inverse complex-to-real transforms
+ *
+ * Input: howMany spectra of size x (size/2 + 1) complex values in FFTW's
+ * half-complex layout (row-major, spectra back to back). Output: howMany
+ * real size x size planes, back to back. Like FFTW, the transform is not
+ * normalized and overwrites its input. execute() may run concurrently
+ * from several threads on distinct arrays.
+ */
+class FFTPlan {
+public:
+    /**
+     * @brief Writes the input of columns [x0, x0 + count) for a fused execution
+     *
+     * Row z of column x0 + l of batch entry b goes to
+     * re/im[(b * size + z) * lanes + l]; both arrays arrive zeroed.
+     */
+    using ColumnSource = std::function<void(int x0, int count, int lanes, float* re, float* im)>;
+
+    virtual ~FFTPlan() = default;
+
+    virtual void execute(std::complex<float>* spectra, float* planes) const = 0;
+
+    /**
+     * @brief Blocks of a fused execution (0 if the plan cannot fuse)
+     *
+     * A fused execution runs transformColumns on every column block, then
+     * transformRows on every row block. The input spectra are produced per
+     * column block right before it is transformed and the output can be
+     * consumed per row block while it is still cached. Blocks of one pass
+     * are independent and may run concurrently.
+     */
+    virtual int getColumnBlockCount() const { return 0; }
+    virtual int getRowBlockCount() const { return 0; }
+    virtual int getRowsPerBlock() const { return 0; }
+
+    /**
+     * @brief First pass of one column block
+     * @param spectra Receives the intermediate columns (half-complex layout)
+     */
+    virtual void transformColumns(int, const ColumnSource&, std::complex<float>*) const {}
+
+    /**
+     * @brief Second pass: rows [block * rowsPerBlock, ...) of every output plane
+     */
+    virtual void transformRows(int, const std::complex<float>*, float*) const {}
+};
+
+/**
+ * @brief Source of FFT plans (FFTW or the built-in power-of-two FFT)
+ *
+ * Planning is not thread-safe; only execute() is.
+ */
+class FFTBackend {
+public:
+    enum class Type {
+        FFTW,       // FFTW3 (if the build has it)
+        Builtin     // Radix-4 Stockham FFT, power-of-two sizes, no dependency
+    };
+
+    virtual ~FFTBackend() = default;
+
+    /**
+     * @brief Plan a batch of size x size inverse transforms
+     * @param spectra, planes Arrays the plan will mostly run on (FFTW
+     *        plans for their alignment; the contents are left alone)
+     * @param anyAlignment Other arrays may be misaligned relative to these
+     * @return nullptr if the size is not supported or planning failed
+     */
+    virtual std::unique_ptr<FFTPlan> planInverse2D(int size, int howMany, std::complex<float>* spectra,
+                                                   float* planes, bool anyAlignment) = 0;
+
+    virtual Type getType() const = 0;
+    virtual const char* getName() const = 0;
+
+    /**
+     * @brief Create a backend
+     * @return nullptr if the type is not part of this build
+     */
+    static std::unique_ptr<FFTBackend> create(Type type);
+
+    static bool isAvailable(Type type);
+
+    /**
+     * @brief FFTW when available, the built-in FFT otherwise
+     */
+    static Type getDefaultType();
+};
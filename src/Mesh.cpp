@@ -1,9 +1,11 @@
 #include "Mesh.h"
+#include <algorithm>
 #include <iostream>
 
-Mesh::Mesh(int resolution, float size)
+Mesh::Mesh(int resolution, float size, int tilesPerSide)
     : m_resolution(resolution)
     , m_size(size)
+    , m_tilesPerSide(std::max(1, std::min(tilesPerSide, resolution - 1)))
     , m_VAO(0)
     , m_VBO(0)
     , m_EBO(0)
@@ -17,10 +19,12 @@ Mesh::~Mesh() {
 Mesh::Mesh(Mesh&& other) noexcept
     : m_resolution(other.m_resolution)
     , m_size(other.m_size)
+    , m_tilesPerSide(other.m_tilesPerSide)
     , m_VAO(other.m_VAO)
     , m_VBO(other.m_VBO)
     , m_EBO(other.m_EBO)
-    , m_indexCount(other.m_indexCount) {
+    , m_indexCount(other.m_indexCount)
+    , m_tileStart(std::move(other.m_tileStart)) {
     other.m_VAO = 0;
     other.m_VBO = 0;
     other.m_EBO = 0;
@@ -31,10 +35,12 @@ Mesh& Mesh::operator=(Mesh&& other) noexcept {
         cleanup();
         m_resolution = other.m_resolution;
         m_size = other.m_size;
+        m_tilesPerSide = other.m_tilesPerSide;
         m_VAO = other.m_VAO;
         m_VBO = other.m_VBO;
         m_EBO = other.m_EBO;
         m_indexCount = other.m_indexCount;
+        m_tileStart = std::move(other.m_tileStart);
         other.m_VAO = 0;
         other.m_VBO = 0;
         other.m_EBO = 0;
@@ -78,24 +84,32 @@ void Mesh::generate() {
     std::vector<unsigned int> indices;
     indices.reserve((m_resolution - 1) * (m_resolution - 1) * 6);
 
-    for (int z = 0; z < m_resolution - 1; ++z) {
-        for (int x = 0; x < m_resolution - 1; ++x) {
-            unsigned int topLeft = z * m_resolution + x;
-            unsigned int topRight = topLeft + 1;
-            unsigned int bottomLeft = (z + 1) * m_resolution + x;
-            unsigned int bottomRight = bottomLeft + 1;
-
-            // First triangle (top-left, bottom-left, top-right)
-            indices.push_back(topLeft);
-            indices.push_back(bottomLeft);
-            indices.push_back(topRight);
-
-            // Second triangle (top-right, bottom-left, bottom-right)
-            indices.push_back(topRight);
-            indices.push_back(bottomLeft);
-            indices.push_back(bottomRight);
+    // Tile by tile, so that each tile is one contiguous range
+    m_tileStart.clear();
+    for (int tileZ = 0; tileZ < m_tilesPerSide; ++tileZ) {
+        for (int tileX = 0; tileX < m_tilesPerSide; ++tileX) {
+            m_tileStart.push_back(static_cast<int>(indices.size()));
+            for (int z = tileQuad(tileZ); z < tileQuad(tileZ + 1); ++z) {
+                for (int x = tileQuad(tileX); x < tileQuad(tileX + 1); ++x) {
+                    unsigned int topLeft = z * m_resolution + x;
+                    unsigned int topRight = topLeft + 1;
+                    unsigned int bottomLeft = (z + 1) * m_resolution + x;
+                    unsigned int bottomRight = bottomLeft + 1;
+
+                    // First triangle (top-left, bottom-left, top-right)
+                    indices.push_back(topLeft);
+                    indices.push_back(bottomLeft);
+                    indices.push_back(topRight);
+
+                    // Second triangle (top-right, bottom-left, bottom-right)
+                    indices.push_back(topRight);
+                    indices.push_back(bottomLeft);
+                    indices.push_back(bottomRight);
+                }
+            }
         }
     }
+    m_tileStart.push_back(static_cast<int>(indices.size()));
 
     m_indexCount = static_cast<int>(indices.size());
 
@@ -140,3 +154,31 @@ void Mesh::render() const {
     glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
 }
+
+void Mesh::renderTiles(const std::vector<int>& tiles) const {
+    if (m_VAO == 0) {
+        std::cerr << "ERROR: Attempting to render mesh before generation\n";
+        return;
+    }
+    if (tiles.empty()) return;
+
+    // One multi-draw over the index ranges of the tiles
+    m_drawCounts.clear();
+    m_drawOffsets.clear();
+    for (int tile : tiles) {
+        m_drawCounts.push_back(m_tileStart[tile + 1] - m_tileStart[tile]);
+        m_drawOffsets.push_back(reinterpret_cast<const void*>(m_tileStart[tile] * sizeof(unsigned int)));
+    }
+
+    glBindVertexArray(m_VAO);
+    glMultiDrawElements(GL_TRIANGLES, m_drawCounts.data(), GL_UNSIGNED_INT, m_drawOffsets.data(),
+                        static_cast<GLsizei>(m_drawCounts.size()));
+    glBindVertexArray(0);
+}
+
+glm::vec4 Mesh::getTileExtent(int tileX, int tileZ) const {
+    float step = m_size / (m_resolution - 1);
+    float halfSize = m_size * 0.5f;
+    return glm::vec4(-halfSize + tileQuad(tileX) * step, -halfSize + tileQuad(tileZ) * step,
+                     -halfSize + tileQuad(tileX + 1) * step, -halfSize + tileQuad(tileZ + 1) * step);
+}
@@ -9,6 +9,8 @@
  * 
  * Creates a NxN vertex grid with indexed triangles.
  * Topology is static, only positions/normals are updated per frame.
+ * Triangles are grouped into square tiles, each a contiguous index range,
+ * so that culled tiles can be left out of the draw.
  */
 class Mesh {
 public:
@@ -16,8 +18,9 @@ public:
      * @brief Create a grid mesh
      * @param resolution Number of vertices per side (e.g., 256)
      * @param size Physical size in world units (e.g., 1000.0f meters)
+     * @param tilesPerSide Tiles along each side (at most resolution - 1)
      */
-    Mesh(int resolution, float size);
+    Mesh(int resolution, float size, int tilesPerSide = 1);
     ~Mesh();
 
     // Non-copyable but movable
@@ -36,6 +39,16 @@ public:
      */
     void render() const;
 
+    /**
+     * @brief Render a subset of the tiles (tileZ * tilesPerSide + tileX)
+     */
+    void renderTiles(const std::vector<int>& tiles) const;
+
+    /**
+     * @brief Undisplaced extent of a tile: (min x, min z, max x, max z)
+     */
+    glm::vec4 getTileExtent(int tileX, int tileZ) const;
+
     /**
      * @brief Get mesh info
      */
@@ -43,16 +56,29 @@ public:
     int getVertexCount() const { return m_resolution * m_resolution; }
     int getTriangleCount() const { return (m_resolution - 1) * (m_resolution - 1) * 2; }
     float getSize() const { return m_size; }
+    int getTilesPerSide() const { return m_tilesPerSide; }
+    int getTileCount() const { return m_tilesPerSide * m_tilesPerSide; }
 
 private:
     int m_resolution;        // Vertices per side (N)
     float m_size;            // Physical size in world units
+    int m_tilesPerSide;      // Tiles along each side
     
     GLuint m_VAO;            // Vertex Array Object
     GLuint m_VBO;            // Vertex Buffer Object
     GLuint m_EBO;            // Element Buffer Object
     
     int m_indexCount;        // Number of indices
+    std::vector<int> m_tileStart;   // First index of each tile (tile count + 1 entries)
+
+    // Scratch for renderTiles
+    mutable std::vector<GLsizei> m_drawCounts;
+    mutable std::vector<const void*> m_drawOffsets;
+
+    /**
+     * @brief First quad of a tile along one side (tile = tilesPerSide gives the end)
+     */
+    int tileQuad(int tile) const { return tile * (m_resolution - 1) / m_tilesPerSide; }
 
     void cleanup();
 };
@@ -0,0 +1,43 @@
+#include "NormalDerivation.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+constexpr int GROUP_SIZE = 8;   // Local size of the shader (per axis)
+
+} // namespace
+
+bool NormalDerivation::isSupported() {
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+bool NormalDerivation::initialize() {
+    if (!isSupported()) {
+        std::cerr << "ERROR: GPU normals need OpenGL 4.3 compute shaders\n";
+        return false;
+    }
+    return m_program.loadComputeFromFile("shaders/ocean_normals.comp");
+}
+
+void NormalDerivation::derive(GLuint displacement, GLuint normals, int layer, int levelCount, int N, float patchSize) {
+    m_program.use();
+    m_program.setUniform("uDisplacement", 0);
+    m_program.setUniform("uLayer", layer);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, displacement);
+
+    for (int level = 0; level < levelCount; ++level) {
+        int size = std::max(N >> level, 1);
+        GLuint groups = static_cast<GLuint>((size + GROUP_SIZE - 1) / GROUP_SIZE);
+        glBindImageTexture(0, normals, level, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+        m_program.setUniform("uLevel", level);
+        m_program.setUniform("uTexelSize", patchSize / size);
+        glDispatchCompute(groups, groups, 1);
+    }
+
+    // The renderer samples the result
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glUseProgram(0);
+}
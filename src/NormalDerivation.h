@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ShaderProgram.h"
+#include <glad/glad.h>
+
+/**
+ * @brief Normal maps derived from displacement maps in a GL 4.3 compute shader
+ *
+ * Replaces the two slope FFTs of the CPU path: each texel's normal is the
+ * cross product of central differences of the displaced grid, taken on
+ * the uploaded displacement of the same layer and mip level. Differences
+ * of choppy displacement are included, unlike the spectral slopes.
+ */
+class NormalDerivation {
+public:
+    /**
+     * @brief Whether the current context has compute shaders (GL 4.3)
+     */
+    static bool isSupported();
+
+    /**
+     * @brief Build the program (shaders/ocean_normals.comp)
+     * @return false without support or if the shader fails
+     */
+    bool initialize();
+
+    /**
+     * @brief Derive levels [0, levelCount) of one layer
+     * @param displacement RGB(A) 2D array texture, N x N at level 0
+     * @param normals RGBA32F 2D array texture of the same shape
+     * @param patchSize Size of the patch the layer covers, in meters
+     */
+    void derive(GLuint displacement, GLuint normals, int layer, int levelCount, int N, float patchSize);
+
+private:
+    ShaderProgram m_program;
+};
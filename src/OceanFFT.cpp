@@ -1,352 +1,2215 @@
 #include "OceanFFT.h"
+#include "ComputeSimulation.h"
+#include "NormalDerivation.h"
+#include "SurfaceReadback.h"
 #include <iostream>
 #include <cmath>
 #include <random>
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <type_traits>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OCEANFFT_HAS_SSE 1
+#endif
 
-OceanFFT::OceanFFT(int N, float L)
+namespace {
+
+/**
+ * @brief Scale one FFT output plane (inverse transforms are not normalized)
+ */
+void scalePlane(float* plane, size_t planeSize, float scale) {
+    for (size_t i = 0; i < planeSize; ++i) plane[i] *= scale;
+}
+
+/**
+ * @brief Round to the nearest bfloat16 (the upper half of a float)
+ */
+inline uint16_t toBfloat16(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits += 0x7FFFu + ((bits >> 16) & 1u);
+    return static_cast<uint16_t>(bits >> 16);
+}
+
+inline float fromBfloat16(uint16_t value) {
+    uint32_t bits = static_cast<uint32_t>(value) << 16;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+/**
+ * @brief Evolution policies, one per OceanFFT::Precision
+ */
+struct DoublePolicy {
+    using Real = double;
+    static constexpr bool COMPACT = false;
+};
+
+struct SinglePolicy {
+    using Real = float;
+    static constexpr bool COMPACT = false;
+};
+
+struct CompactPolicy {
+    using Real = float;
+    static constexpr bool COMPACT = true;
+};
+
+/**
+ * @brief Call visit with the policy object of a precision
+ */
+template <typename Visit>
+void visitPrecision(OceanFFT::Precision precision, const Visit& visit) {
+    switch (precision) {
+        case OceanFFT::Precision::Double:
+            visit(DoublePolicy());
+            break;
+        case OceanFFT::Precision::Compact:
+            visit(CompactPolicy());
+            break;
+        default:
+            visit(SinglePolicy());
+            break;
+    }
+}
+
+/**
+ * @brief 2x2 box filter of a square plane (src is size x size, dst is size/2)
+ */
+void boxFilterPlane(const float* src, int size, float* dst) {
+    const int half = size / 2;
+    for (int y = 0; y < half; ++y) {
+        const float* r0 = src + static_cast<size_t>(2 * y) * size;
+        const float* r1 = r0 + size;
+        float* out = dst + static_cast<size_t>(y) * half;
+        int x = 0;
+#ifdef OCEANFFT_HAS_SSE
+        // 4 output texels per iteration: add the two rows, then the column pairs
+        const __m128 quarter = _mm_set1_ps(0.25f);
+        for (; x + 4 <= half; x += 4) {
+            __m128 s0 = _mm_add_ps(_mm_loadu_ps(r0 + 2 * x), _mm_loadu_ps(r1 + 2 * x));
+            __m128 s1 = _mm_add_ps(_mm_loadu_ps(r0 + 2 * x + 4), _mm_loadu_ps(r1 + 2 * x + 4));
+            __m128 even = _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 odd = _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(out + x, _mm_mul_ps(_mm_add_ps(even, odd), quarter));
+        }
+#endif
+        for (; x < half; ++x) {
+            out[x] = 0.25f * (r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1]);
+        }
+    }
+}
+
+} // namespace
+
+OceanFFT::OceanFFT(int N, float L, int workerThreads)
     : m_N(N)
-    , m_L(L)
-    , m_windSpeed(30.0f)
-    , m_windDirection(1.0f, 0.0f)
-    , m_amplitude(0.0002f)
+    , m_components(1)
+    , m_bathymetrySize(0)
+    , m_bathymetryOrigin(0.0f)
+    , m_bathymetryExtent(0.0f)
     , m_choppy(2.0f)
-    , m_planHeight(nullptr)
-    , m_planChoppyX(nullptr)
-    , m_planChoppyZ(nullptr)
-    , m_planNormalX(nullptr)
-    , m_planNormalZ(nullptr)
+    , m_mipMode(MipMode::BoxFilter)
+    , m_mipLevels(1)
+    , m_velocityEnabled(false)
+    , m_velocityTexture(false)
+    , m_jacobianEnabled(false)
+    , m_foamBias(0.6f)
+    , m_foamDecayTime(2.0f)
+    , m_sparseFraction(0.0f)
+    , m_prunedEnabled(false)
+    , m_prunedLoss(0.01f)
+    , m_loopPeriod(0.0f)
+    , m_loopTextures(false)
+    , m_loopTexturesCompact(false)
+    , m_heightBounds(false)
+    , m_fusedEvaluation(true)
+    , m_gpuSimulation(false)
+    , m_computeSpectrumDirty(true)
+    , m_gpuNormals(false)
+    , m_readbackEnabled(false)
+    , m_readbackLevel(0)
+    , m_playing(false)
+    , m_playBlend(1.0f)
+    , m_playSlotFrame{ -1, -1 }
+    , m_playFoamFrame(-1)
+    , m_step(0)
+    , m_initialized(false)
+    , m_threadPool(std::make_unique<ThreadPool>(workerThreads))
+    , m_fftBackendType(FFTBackend::getDefaultType())
+    , m_fftBackend(FFTBackend::create(m_fftBackendType))
+    , m_fieldSlot{}
+    , m_activeFields(0)
+    , m_spectrumSize(N * (N / 2 + 1))
     , m_texDisplacement(0)
-    , m_texNormal(0) {
-    
-    // Allocate memory
-    int size = m_N * m_N;
-    m_h0.resize(size);
-    m_h0Conj.resize(size);
-    m_htilde.resize(size);
-    m_htildeChoppyX.resize(size);
-    m_htildeChoppyZ.resize(size);
-    m_htildeNormalX.resize(size);
-    m_htildeNormalZ.resize(size);
-    m_heightField.resize(size);
-    m_choppyX.resize(size);
-    m_choppyZ.resize(size);
-    m_normalX.resize(size);
-    m_normalZ.resize(size);
+    , m_texNormal(0)
+    , m_texVelocity(0)
+    , m_texFoam(0)
+    , m_texBathymetry(0) {
+
+    while ((1 << (m_mipLevels - 1)) < m_N) ++m_mipLevels;
+
+    // Render fields only until optional outputs are enabled
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        m_fieldSlot[f] = f < RENDER_FIELD_COUNT ? f : -1;
+    }
+    m_activeFields = RENDER_FIELD_COUNT;
+
+    // |n| and direction of every FFT-ordered bin, shared by all cascades
+    m_gridRadius.resize(static_cast<size_t>(N) * N);
+    m_gridAngle.resize(static_cast<size_t>(N) * N);
+    for (int z = 0; z < N; ++z) {
+        for (int x = 0; x < N; ++x) {
+            float nx = static_cast<float>(x < N / 2 ? x : x - N);
+            float nz = static_cast<float>(z < N / 2 ? z : z - N);
+            m_gridRadius[getIndex(x, z)] = std::sqrt(nx * nx + nz * nz);
+            m_gridAngle[getIndex(x, z)] = std::atan2(nz, nx);
+        }
+    }
+
+    // Single cascade covering the whole spectrum
+    m_baseCascades = { { L, 0.0f, 0.0f } };
+    expandDepthRegions();
 }
 
 OceanFFT::~OceanFFT() {
-    cleanupFFTW();
-    
-    if (m_texDisplacement) glDeleteTextures(1, &m_texDisplacement);
-    if (m_texNormal) glDeleteTextures(1, &m_texNormal);
+    clearLoopCache();
+    cleanupPlans();
+    m_compute.reset();
+    m_normalPass.reset();
+    m_readback.reset();
+    deleteTextures();
+    if (m_texBathymetry) glDeleteTextures(1, &m_texBathymetry);
 }
 
 bool OceanFFT::initialize() {
-    std::cout << "Initializing OceanFFT (N=" << m_N << ", L=" << m_L << "m)...\n";
+    std::cout << "Initializing OceanFFT (N=" << m_N << ", L=" << getPatchSize()
+              << "m, cascades=" << getCascadeCount()
+              << ", threads=" << m_threadPool->getThreadCount() << ")...\n";
 
     // Generate initial spectrum
     generateH0();
 
-    // Create FFTW plans (using FFTW_ESTIMATE for faster planning)
-    // Plans convert frequency domain (complex) to spatial domain (real)
-    m_planHeight = fftwf_plan_dft_c2r_2d(
-        m_N, m_N,
-        reinterpret_cast<fftwf_complex*>(m_htilde.data()),
-        m_heightField.data(),
-        FFTW_ESTIMATE
-    );
-
-    m_planChoppyX = fftwf_plan_dft_c2r_2d(
-        m_N, m_N,
-        reinterpret_cast<fftwf_complex*>(m_htildeChoppyX.data()),
-        m_choppyX.data(),
-        FFTW_ESTIMATE
-    );
-
-    m_planChoppyZ = fftwf_plan_dft_c2r_2d(
-        m_N, m_N,
-        reinterpret_cast<fftwf_complex*>(m_htildeChoppyZ.data()),
-        m_choppyZ.data(),
-        FFTW_ESTIMATE
-    );
-
-    m_planNormalX = fftwf_plan_dft_c2r_2d(
-        m_N, m_N,
-        reinterpret_cast<fftwf_complex*>(m_htildeNormalX.data()),
-        m_normalX.data(),
-        FFTW_ESTIMATE
-    );
-
-    m_planNormalZ = fftwf_plan_dft_c2r_2d(
-        m_N, m_N,
-        reinterpret_cast<fftwf_complex*>(m_htildeNormalZ.data()),
-        m_normalZ.data(),
-        FFTW_ESTIMATE
-    );
-
-    if (!m_planHeight || !m_planChoppyX || !m_planChoppyZ || 
-        !m_planNormalX || !m_planNormalZ) {
-        std::cerr << "ERROR: Failed to create FFTW plans\n";
-        return false;
+    // Before the plans, which then leave out the slope fields
+    if (m_gpuNormals && !createNormalPass()) {
+        std::cerr << "ERROR: GPU normals unavailable, deriving them on the CPU\n";
+        m_gpuNormals = false;
+    }
+
+    if (!createPlans()) return false;
+
+    // Before the textures, whose format depends on it
+    if (m_gpuSimulation && !createComputeSimulation()) {
+        std::cerr << "ERROR: GPU simulation unavailable, simulating on the CPU\n";
+        m_gpuSimulation = false;
     }
 
-    // Create OpenGL textures
+    // Create OpenGL textures (the depth map survives cascade changes)
     createTextures();
+    if (!m_texBathymetry) uploadBathymetry();
 
+    m_initialized = true;
     std::cout << "OceanFFT initialized successfully\n";
     return true;
 }
 
-void OceanFFT::update(float time) {
-    // Evaluate spectrum at current time
-    evaluateWaves(time);
+bool OceanFFT::createPlans() {
+    // One batched plan converts all frequency domain (complex) fields to
+    // spatial domain (real); input is N x (N/2+1), output is N x N
+    if (!updateFieldLayout()) {
+        std::cerr << "ERROR: Failed to create " << m_fftBackend->getName() << " FFT plans\n";
+        return false;
+    }
+
+    // Smaller plans for the spectral mip chain (truncated sub-spectra).
+    // Each cascade owns separate mip buffers, so these must not assume the
+    // alignment of the arrays they were planned on.
+    m_mipPlans.clear();
+    m_mipPlans.resize(m_mipLevels);
+    for (int level = 1; level < m_mipLevels; ++level) {
+        MipLevel& mip = m_cascades[0].mips[level];
+        m_mipPlans[level] = m_fftBackend->planInverse2D(mip.size, getRenderFieldCount(), mip.spectrum.data(),
+                                                        mip.fields.data(), true);
+        if (!m_mipPlans[level]) {
+            std::cerr << "ERROR: Failed to create " << m_fftBackend->getName()
+                      << " FFT plan for mip level " << level << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void OceanFFT::update(double time) {
+    // A complete loop cache replaces the simulation
+    if (m_loopCache && m_loopCache->framesDone.load(std::memory_order_acquire) == m_loopCache->frameCount) {
+        // Resident frames are interpolated by the shaders: nothing to do
+        if (m_loopTextures && !m_loopCache->residentFailed
+            && (m_loopCache->resident || uploadLoopTextures())) {
+            return;
+        }
+        playLoop(time);
+        return;
+    }
+    if (m_playing) stopPlayback();
+
+    if (m_compute) {
+        simulateCompute(time);
+        return;
+    }
 
-    // Execute FFT transforms
-    executeFFT();
+    simulate(time);
 
     // Upload to GPU
     updateTextures();
+    if (m_velocityTexture) updateVelocityTexture();
+    if (m_jacobianEnabled) updateFoamTexture();
+}
+
+void OceanFFT::simulate(double time) {
+    selectDueCascades();
+
+    const bool fused = usesFusedEvaluation();
+    if (fused) {
+        // Evaluation, gathers, transform and level-0 packing in cached blocks
+        transformFused(time);
+    } else {
+        // Evaluate spectrum at current time
+        evaluateWaves(time);
+
+        // Band-limited mip and pruned inputs, while the spectrum is still intact
+        if (m_mipMode == MipMode::Spectral || m_prunedEnabled) {
+            m_threadPool->parallelFor(getUpdatedCascadeCount(), [&](int item) {
+                int cascade = m_dueCascades[item];
+                auto fetch = [&](Field f, int x, int z) { return spectrum(cascade, f)[getSpectrumIndex(x, z)]; };
+                if (m_mipMode == MipMode::Spectral) gatherMipSpectra(cascade, 0, m_N / 2 + 1, fetch);
+
+                // Sample points of the coarse grid coincide with base texels
+                Cascade& state = m_cascades[cascade];
+                if (m_prunedEnabled && state.prunedLevel > 0) {
+                    gatherSubSpectrum(state.prunedLevel, 0.0f, state.pruned, 0, m_N / 2 + 1, fetch);
+                }
+            });
+        }
+
+        // Execute FFT transforms
+        executeFFT();
+    }
+
+    // Build the lower mip levels, folding and foam accumulation
+    m_threadPool->parallelFor(getUpdatedCascadeCount(), [&](int item) {
+        int cascade = m_dueCascades[item];
+        if (!fused) packLevel(field(cascade, FIELD_HEIGHT), m_N, m_cascades[cascade].mips[0]);
+        generateMips(cascade);
+        if (m_heightBounds) {
+            // Same slot as the texture layer the frame goes to; a first frame fills both
+            Cascade& state = m_cascades[cascade];
+            int slot = state.valid ? state.newestSlot ^ 1 : state.newestSlot;
+            buildHeightPyramid(cascade, slot);
+            if (!state.valid) state.heightBounds[slot ^ 1] = state.heightBounds[slot];
+        }
+        if (m_prunedEnabled) generatePruned(cascade);
+        if (m_jacobianEnabled) {
+            updateFoam(cascade, static_cast<float>(std::max(time - m_cascades[cascade].lastTime, 0.0)));
+            packFoam(cascade);
+        }
+    });
+
+    // The refreshed frame replaces the older layer of each pair
+    for (int cascade : m_dueCascades) {
+        Cascade& state = m_cascades[cascade];
+        if (state.valid) state.newestSlot ^= 1;
+        state.stepsSinceUpdate = 0;
+        state.lastTime = time;
+    }
+}
+
+void OceanFFT::simulateCompute(double time) {
+    selectDueCascades();
+    if (m_computeSpectrumDirty) uploadComputeSpectrum();
+
+    // Every ω(k) is a multiple of 2π/period when looping, so wrapping the
+    // time keeps the phases small; the shader reduces ωt in double
+    double t = m_loopPeriod > 0.0f ? std::fmod(time, static_cast<double>(m_loopPeriod)) : time;
+
+    for (int c : m_dueCascades) {
+        // The refreshed frame replaces the older layer of each pair; a
+        // cascade's first frame fills both
+        Cascade& state = m_cascades[c];
+        if (state.valid) state.newestSlot ^= 1;
+        int firstLayer = state.valid ? getCascadeLayer(c) : 2 * c;
+        m_compute->simulate(c, t, state.desc.patchSize, m_choppy, m_texDisplacement, m_texNormal,
+                            firstLayer, state.valid ? 1 : 2);
+        state.valid = true;
+        state.stepsSinceUpdate = 0;
+        state.lastTime = time;
+    }
+
+    if (!m_dueCascades.empty() && m_mipMode != MipMode::None) {
+        for (GLuint tex : { m_texDisplacement, m_texNormal }) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    readBackSurface(time);
+}
+
+void OceanFFT::readBackSurface(double time) {
+    if (!m_readbackEnabled) {
+        m_readback.reset();
+        return;
+    }
+
+    // Mips exist only while they are generated
+    int level = m_mipMode == MipMode::None ? 0 : std::clamp(m_readbackLevel, 0, m_mipLevels - 1);
+    if (!m_readback || m_readback->getLevel() != level || m_readback->getCascadeCount() != getCascadeCount()) {
+        m_readback = std::make_unique<SurfaceReadback>();
+        if (!m_readback->initialize(m_texDisplacement, m_N >> level, level, getCascadeCount())) {
+            // Not retried every frame; setGPUReadback turns it back on
+            m_readback.reset();
+            m_readbackEnabled = false;
+            return;
+        }
+    }
+
+    m_readback->poll();
+    if (m_dueCascades.empty()) return;
+    int layers[MAX_SIMULATED_CASCADES];
+    for (int c = 0; c < getCascadeCount(); ++c) layers[c] = getCascadeLayer(c);
+    m_readback->request(m_texDisplacement, layers, time);
+}
+
+const SurfaceReadback* OceanFFT::getSampledReadback() const {
+    return m_compute && m_readback && m_readback->hasFrame() ? m_readback.get() : nullptr;
+}
+
+void OceanFFT::setGPUReadback(bool enabled, int level) {
+    m_readbackEnabled = enabled;
+    m_readbackLevel = std::max(level, 0);
+    if (!enabled) m_readback.reset();
+}
+
+double OceanFFT::getSurfaceTime() const {
+    if (m_compute) {
+        const SurfaceReadback* readback = getSampledReadback();
+        return readback ? readback->getFrameTime() : -1.0;
+    }
+    double time = 0.0;
+    for (const Cascade& cascade : m_cascades) time = std::max(time, cascade.lastTime);
+    return time;
+}
+
+bool OceanFFT::setGPUSimulation(bool enabled) {
+    if (m_gpuSimulation == enabled) return true;
+    if (!m_initialized) {
+        m_gpuSimulation = enabled;
+        return true;
+    }
+    if (enabled && !createComputeSimulation()) return false;
+    if (!enabled) m_compute.reset();
+    m_readback.reset();
+    m_gpuSimulation = enabled;
+
+    // Storage images need RGBA: recreate the maps and refill both layers of every pair
+    clearLoopCache();
+    if (m_playing) stopPlayback();
+    deleteTextures();
+    createTextures();
+    for (Cascade& cascade : m_cascades) cascade.valid = false;
+    return true;
+}
+
+bool OceanFFT::setGPUNormals(bool enabled) {
+    if (m_gpuNormals == enabled) return true;
+    if (!m_initialized) {
+        m_gpuNormals = enabled;
+        return true;
+    }
+    if (enabled && !createNormalPass()) return false;
+    if (!enabled) m_normalPass.reset();
+    m_gpuNormals = enabled;
+
+    // Re-plan without (or with) the slope fields, recreate the normal map
+    // in its new format and refill both layers of every pair
+    clearLoopCache();
+    if (m_playing) stopPlayback();
+    cleanupPlans();
+    createPlans();
+    deleteTextures();
+    createTextures();
+    for (Cascade& cascade : m_cascades) cascade.valid = false;
+    return true;
+}
+
+bool OceanFFT::createNormalPass() {
+    m_normalPass = std::make_unique<NormalDerivation>();
+    if (!m_normalPass->initialize()) {
+        m_normalPass.reset();
+        return false;
+    }
+    return true;
+}
+
+bool OceanFFT::createComputeSimulation() {
+    m_compute = std::make_unique<ComputeSimulation>();
+    if (!m_compute->initialize(m_N, getCascadeCount())) {
+        m_compute.reset();
+        return false;
+    }
+    m_computeSpectrumDirty = true;
+    return true;
+}
+
+void OceanFFT::uploadComputeSpectrum() {
+    std::vector<glm::vec4> h0(m_spectrumSize);
+    std::vector<double> omega;
+    for (int c = 0; c < getCascadeCount(); ++c) {
+        const Cascade& cascade = m_cascades[c];
+        std::fill(h0.begin(), h0.end(), glm::vec4(0.0f));
+        for (int idx : cascade.activeBins) {
+            h0[idx] = glm::vec4(cascade.h0[idx].real(), cascade.h0[idx].imag(),
+                                cascade.h0Conj[idx].real(), cascade.h0Conj[idx].imag());
+        }
+
+        // Double cascades keep their exact ω; the others widen the float table
+        if (!cascade.omegaDouble.empty()) {
+            omega = cascade.omegaDouble;
+        } else {
+            omega.assign(cascade.omega.begin(), cascade.omega.end());
+        }
+        m_compute->setSpectrum(c, h0, omega);
+    }
+    m_computeSpectrumDirty = false;
+}
+
+void OceanFFT::selectDueCascades() {
+    // Cascades due this step (every cascade until both of its layers hold a frame)
+    m_dueCascades.clear();
+    for (int c = 0; c < getCascadeCount(); ++c) {
+        Cascade& cascade = m_cascades[c];
+        int period = cascade.desc.updatePeriod;
+        if (!cascade.valid || m_step % period == cascade.phase) {
+            m_dueCascades.push_back(c);
+        } else {
+            ++cascade.stepsSinceUpdate;
+        }
+    }
+    // 840 is a multiple of every period up to MAX_UPDATE_PERIOD
+    m_step = (m_step + 1) % 840;
 }
 
 void OceanFFT::setWindSpeed(float speed) {
-    if (std::abs(m_windSpeed - speed) > 0.01f) {
-        m_windSpeed = speed;
-        generateH0();
+    if (std::abs(m_components[0].windSpeed - speed) > 0.01f) {
+        m_components[0].windSpeed = speed;
+        regenerateComponent(0);
     }
 }
 
 void OceanFFT::setWindDirection(const glm::vec2& direction) {
     glm::vec2 normalized = glm::normalize(direction);
-    if (glm::length(m_windDirection - normalized) > 0.01f) {
-        m_windDirection = normalized;
-        generateH0();
+    if (glm::length(m_components[0].windDirection - normalized) > 0.01f) {
+        m_components[0].windDirection = normalized;
+        regenerateComponent(0);
     }
 }
 
 void OceanFFT::setAmplitude(float amplitude) {
-    if (std::abs(m_amplitude - amplitude) > 0.00001f) {
-        m_amplitude = amplitude;
+    if (std::abs(m_components[0].amplitude - amplitude) > 0.00001f) {
+        m_components[0].amplitude = amplitude;
+        regenerateComponent(0);
+    }
+}
+
+void OceanFFT::setSpectrum(const SpectrumDesc& spectrum) {
+    if (m_components[0].spectrum == spectrum) return;
+    m_components[0].spectrum = spectrum;
+    regenerateComponent(0);
+}
+
+int OceanFFT::addSpectrumComponent(const SpectrumComponent& component) {
+    if (getSpectrumComponentCount() >= MAX_SPECTRUM_COMPONENTS) {
+        std::cerr << "ERROR: At most " << MAX_SPECTRUM_COMPONENTS << " spectrum components\n";
+        return -1;
+    }
+    m_components.push_back(component);
+    m_components.back().windDirection = glm::normalize(component.windDirection);
+    int index = getSpectrumComponentCount() - 1;
+    regenerateComponent(index);
+    return index;
+}
+
+bool OceanFFT::setSpectrumComponent(int index, const SpectrumComponent& component) {
+    if (index < 0 || index >= getSpectrumComponentCount()) {
+        std::cerr << "ERROR: No spectrum component " << index << "\n";
+        return false;
+    }
+    SpectrumComponent normalized = component;
+    normalized.windDirection = glm::normalize(component.windDirection);
+    if (m_components[index] == normalized) return true;
+    m_components[index] = normalized;
+    regenerateComponent(index);
+    return true;
+}
+
+bool OceanFFT::removeSpectrumComponent(int index) {
+    if (index < 1 || index >= getSpectrumComponentCount()) {
+        std::cerr << "ERROR: Cannot remove spectrum component " << index << "\n";
+        return false;
+    }
+    m_components.erase(m_components.begin() + index);
+
+    // The other contributions are unchanged, only their sum is rebuilt
+    bool evaluated = true;
+    for (Cascade& cascade : m_cascades) {
+        if (cascade.variance.size() != m_components.size() + 1) {
+            evaluated = false;
+            break;
+        }
+    }
+    if (!evaluated) {
         generateH0();
+        return true;
     }
+    for (Cascade& cascade : m_cascades) {
+        cascade.variance.erase(cascade.variance.begin() + index);
+        combineComponents(cascade);
+    }
+    clearLoopCache();
+    compactSpectrum();
+    return true;
 }
 
 void OceanFFT::setChoppy(float choppy) {
+    if (m_choppy == choppy) return;
     m_choppy = choppy;
+    clearLoopCache();
 }
 
-void OceanFFT::generateH0() {
-    std::cout << "Generating h0 spectrum (wind: " << m_windSpeed 
-              << "m/s, amplitude: " << m_amplitude << ")...\n";
+void OceanFFT::setMipMode(MipMode mode) {
+    if (m_mipMode == mode) return;
+    m_mipMode = mode;
+    clearLoopCache();
+    if (m_texDisplacement) applyMipSampling();
+}
 
-    for (int z = 0; z < m_N; ++z) {
-        for (int x = 0; x < m_N; ++x) {
-            glm::vec2 k = getWaveVector(x, z);
-            int idx = getIndex(x, z);
+bool OceanFFT::setCascades(const std::vector<CascadeDesc>& cascades) {
+    if (cascades.empty() || cascades.size() > static_cast<size_t>(MAX_CASCADES)) {
+        std::cerr << "ERROR: Cascade count must be between 1 and " << MAX_CASCADES << "\n";
+        return false;
+    }
+    for (const CascadeDesc& desc : cascades) {
+        if (desc.patchSize <= 0.0f) {
+            std::cerr << "ERROR: Cascade patch size must be positive\n";
+            return false;
+        }
+        if (desc.updatePeriod < 1 || desc.updatePeriod > MAX_UPDATE_PERIOD) {
+            std::cerr << "ERROR: Cascade update period must be between 1 and " << MAX_UPDATE_PERIOD << "\n";
+            return false;
+        }
+    }
 
-            // Phillips spectrum
-            float Ph = phillipsSpectrum(k);
+    // Buffers, plans and texture layers are all sized by the cascade count
+    clearLoopCache();
+    cleanupPlans();
+    deleteTextures();
 
-            // Generate complex Gaussian random variables
-            float xi_r = gaussianRandom();
-            float xi_i = gaussianRandom();
+    m_baseCascades = cascades;
+    expandDepthRegions();
 
-            // h0(k) = 1/sqrt(2) * (xi_r + i*xi_i) * sqrt(P(k))
-            float sqrtPh = std::sqrt(Ph);
-            m_h0[idx] = std::complex<float>(xi_r, xi_i) * sqrtPh * 0.707106781f; // 1/sqrt(2)
+    if (!m_initialized) return true;
+    m_initialized = false;
+    return initialize();
+}
 
-            // h0*(-k) for conjugate symmetry
-            glm::vec2 kNeg = -k;
-            float PhNeg = phillipsSpectrum(kNeg);
-            float xi_r_neg = gaussianRandom();
-            float xi_i_neg = gaussianRandom();
-            float sqrtPhNeg = std::sqrt(PhNeg);
-            m_h0Conj[idx] = std::conj(
-                std::complex<float>(xi_r_neg, xi_i_neg) * sqrtPhNeg * 0.707106781f
-            );
+bool OceanFFT::setDepthRegions(const std::vector<float>& depths) {
+    if (depths.size() > static_cast<size_t>(MAX_DEPTH_REGIONS)) {
+        std::cerr << "ERROR: At most " << MAX_DEPTH_REGIONS << " depth regions\n";
+        return false;
+    }
+    for (size_t r = 0; r < depths.size(); ++r) {
+        if (depths[r] <= 0.0f || (r > 0 && depths[r] <= depths[r - 1])) {
+            std::cerr << "ERROR: Region depths must be positive and increasing\n";
+            return false;
         }
     }
+    if (depths == m_regionDepths) return true;
+
+    // Every region adds a copy of the cascade set to the batch
+    clearLoopCache();
+    cleanupPlans();
+    deleteTextures();
+
+    m_regionDepths = depths;
+    expandDepthRegions();
+
+    if (!m_initialized) return true;
+    m_initialized = false;
+    return initialize();
 }
 
-void OceanFFT::evaluateWaves(float t) {
-    using namespace std::complex_literals;
+void OceanFFT::expandDepthRegions() {
+    const size_t perRegion = m_baseCascades.size();
+    m_cascades.clear();
+    m_cascades.resize(perRegion * getDepthRegionCount());
+    for (size_t c = 0; c < m_cascades.size(); ++c) {
+        m_cascades[c].desc = m_baseCascades[c % perRegion];
+        m_cascades[c].depth = m_regionDepths.empty() ? 0.0f : m_regionDepths[c / perRegion];
+    }
+    allocateBuffers();
+    scheduleCascades();
 
-    for (int z = 0; z < m_N; ++z) {
-        for (int x = 0; x < m_N; ++x) {
-            int idx = getIndex(x, z);
-            glm::vec2 k = getWaveVector(x, z);
-            float kLen = glm::length(k);
-
-            // Dispersion relation: ω(k) = sqrt(g|k|)
-            float omega = dispersion(k);
-
-            // Time evolution: h(k,t) = h0(k)*exp(iωt) + h0*(-k)*exp(-iωt)
-            std::complex<float> expIwt = std::exp(1if * omega * t);
-            std::complex<float> expMinusIwt = std::conj(expIwt);
-
-            m_htilde[idx] = m_h0[idx] * expIwt + m_h0Conj[idx] * expMinusIwt;
-
-            // Choppy displacement: D(x) = -i * k/|k| * h(k,t)
-            if (kLen > 0.0001f) {
-                std::complex<float> factor = -1if * m_htilde[idx] / kLen;
-                m_htildeChoppyX[idx] = factor * k.x;
-                m_htildeChoppyZ[idx] = factor * k.y;
-            } else {
-                m_htildeChoppyX[idx] = 0.0f;
-                m_htildeChoppyZ[idx] = 0.0f;
-            }
+    // ω depends only on the cascade, its depth and the loop period, so the
+    // spectrum regenerations reuse the tables
+    for (Cascade& cascade : m_cascades) buildDispersionTable(cascade);
+}
+
+bool OceanFFT::setBathymetry(const std::vector<float>& depths, int size, const glm::vec2& origin, float extent) {
+    if (!depths.empty() && (size < 1 || depths.size() != static_cast<size_t>(size) * size || extent <= 0.0f)) {
+        std::cerr << "ERROR: Bathymetry needs size x size depths over a positive extent\n";
+        return false;
+    }
+    m_bathymetry = depths;
+    m_bathymetrySize = depths.empty() ? 0 : size;
+    m_bathymetryOrigin = origin;
+    m_bathymetryExtent = extent;
+    if (m_initialized) uploadBathymetry();
+    return true;
+}
+
+void OceanFFT::getRegionWeights(float x, float z, float* weights) const {
+    const int regionCount = getDepthRegionCount();
+    float u = (x - m_bathymetryOrigin.x) / m_bathymetryExtent;
+    float v = (z - m_bathymetryOrigin.y) / m_bathymetryExtent;
+    if (regionCount == 1 || m_bathymetry.empty() || !(u >= 0.0f && u <= 1.0f && v >= 0.0f && v <= 1.0f)) {
+        std::fill(weights, weights + regionCount, 0.0f);
+        weights[regionCount - 1] = 1.0f;
+        return;
+    }
+
+    // Bilinear between texel centres, clamped at the edges like the texture
+    const int last = m_bathymetrySize - 1;
+    float fx = std::clamp(u * m_bathymetrySize - 0.5f, 0.0f, static_cast<float>(last));
+    float fz = std::clamp(v * m_bathymetrySize - 0.5f, 0.0f, static_cast<float>(last));
+    int x0 = std::min(static_cast<int>(fx), last);
+    int z0 = std::min(static_cast<int>(fz), last);
+    int x1 = std::min(x0 + 1, last);
+    int z1 = std::min(z0 + 1, last);
+    float tx = fx - x0;
+    float tz = fz - z0;
+    auto depthAt = [&](int i, int j) { return m_bathymetry[static_cast<size_t>(j) * m_bathymetrySize + i]; };
+    float depth = (1.0f - tz) * ((1.0f - tx) * depthAt(x0, z0) + tx * depthAt(x1, z0))
+                + tz * ((1.0f - tx) * depthAt(x0, z1) + tx * depthAt(x1, z1));
+    regionWeights(depth, weights);
+}
+
+void OceanFFT::regionWeights(float depth, float* weights) const {
+    const int regionCount = getDepthRegionCount();
+    std::fill(weights, weights + regionCount, 0.0f);
+    if (regionCount == 1) {
+        weights[0] = 1.0f;
+        return;
+    }
 
-            // Normal calculation: N = (-∂h/∂x, 1, -∂h/∂z)
-            // In frequency domain: ∂h/∂x ↔ i*kx*h(k), ∂h/∂z ↔ i*kz*h(k)
-            m_htildeNormalX[idx] = 1if * k.x * m_htilde[idx];
-            m_htildeNormalZ[idx] = 1if * k.y * m_htilde[idx];
+    // Linear in log depth between the regions around it, land counts as shallowest
+    float d = std::log(std::max(depth, 0.001f));
+    if (d <= std::log(m_regionDepths[0])) {
+        weights[0] = 1.0f;
+        return;
+    }
+    for (int r = 0; r + 1 < regionCount; ++r) {
+        float lower = std::log(m_regionDepths[r]);
+        float upper = std::log(m_regionDepths[r + 1]);
+        if (d < upper) {
+            float t = (d - lower) / (upper - lower);
+            weights[r] = 1.0f - t;
+            weights[r + 1] = t;
+            return;
         }
     }
+    weights[regionCount - 1] = 1.0f;
 }
 
-void OceanFFT::executeFFT() {
-    // Execute inverse FFT transforms
-    fftwf_execute(m_planHeight);
-    fftwf_execute(m_planChoppyX);
-    fftwf_execute(m_planChoppyZ);
-    fftwf_execute(m_planNormalX);
-    fftwf_execute(m_planNormalZ);
-
-    // Normalize (FFTW doesn't normalize inverse transforms)
-    float norm = 1.0f / (m_N * m_N);
-    for (int i = 0; i < m_N * m_N; ++i) {
-        m_heightField[i] *= norm;
-        m_choppyX[i] *= norm * m_choppy;
-        m_choppyZ[i] *= norm * m_choppy;
-        m_normalX[i] *= norm;
-        m_normalZ[i] *= norm;
+void OceanFFT::uploadBathymetry() {
+    if (m_bathymetry.empty()) {
+        if (m_texBathymetry) glDeleteTextures(1, &m_texBathymetry);
+        m_texBathymetry = 0;
+        return;
     }
+    if (!m_texBathymetry) glGenTextures(1, &m_texBathymetry);
+    glBindTexture(GL_TEXTURE_2D, m_texBathymetry);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_bathymetrySize, m_bathymetrySize, 0, GL_RED, GL_FLOAT,
+                 m_bathymetry.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void OceanFFT::updateTextures() {
-    // Prepare displacement texture data (RGB = dx, dy, dz)
-    std::vector<float> displacementData(m_N * m_N * 3);
-    std::vector<float> normalData(m_N * m_N * 3);
+std::vector<OceanFFT::CascadeDesc> OceanFFT::makeCascades(float L, int count, bool multiRate) {
+    const float PI = 3.14159265358979323846f;
+    count = std::clamp(count, 1, MAX_CASCADES);
 
-    for (int z = 0; z < m_N; ++z) {
-        for (int x = 0; x < m_N; ++x) {
-            int idx = getIndex(x, z);
-            int texIdx = (z * m_N + x) * 3;
+    std::vector<CascadeDesc> cascades(count);
+    float patchSize = L;
+    for (int c = 0; c < count; ++c) {
+        cascades[c] = { patchSize, 0.0f, 0.0f };
+        if (multiRate) cascades[c].updatePeriod = std::min(1 << (count - 1 - c), 4);
+        patchSize *= 0.25f;
+    }
+
+    // Hand over to the smaller patch once it resolves a few of its own
+    // fundamental wavelengths (well below the larger patch's Nyquist)
+    for (int c = 1; c < count; ++c) {
+        float boundary = 6.0f * 2.0f * PI / cascades[c].patchSize;
+        cascades[c - 1].kMax = boundary;
+        cascades[c].kMin = boundary;
+    }
+    return cascades;
+}
 
-            // Displacement (x, y, z)
-            displacementData[texIdx + 0] = m_choppyX[idx];
-            displacementData[texIdx + 1] = m_heightField[idx];
-            displacementData[texIdx + 2] = m_choppyZ[idx];
+float OceanFFT::getCascadeBlend(int cascade) const {
+    if (m_playing) return m_playBlend;
 
-            // Normal (-∂h/∂x, 1, -∂h/∂z) normalized
-            glm::vec3 normal(-m_normalX[idx], 1.0f, -m_normalZ[idx]);
-            normal = glm::normalize(normal);
-            normalData[texIdx + 0] = normal.x;
-            normalData[texIdx + 1] = normal.y;
-            normalData[texIdx + 2] = normal.z;
+    // Step s after a refresh shows the frame s + 1 steps past the previous
+    // one, so the blend reaches the newest frame just before the next refresh
+    const Cascade& state = m_cascades[cascade];
+    float blend = static_cast<float>(state.stepsSinceUpdate + 1) / state.desc.updatePeriod;
+    return std::min(blend, 1.0f);
+}
+
+void OceanFFT::scheduleCascades() {
+    // Step cost is the number of cascades refreshed; place the shortest
+    // periods first, then give each cascade the phase with the lowest peak
+    const int hyperperiod = 840;
+    std::vector<int> load(hyperperiod, 0);
+
+    std::vector<int> order(m_cascades.size());
+    for (size_t c = 0; c < order.size(); ++c) order[c] = static_cast<int>(c);
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return m_cascades[a].desc.updatePeriod < m_cascades[b].desc.updatePeriod;
+    });
+
+    for (int c : order) {
+        Cascade& cascade = m_cascades[c];
+        int period = cascade.desc.updatePeriod;
+
+        int bestPeak = hyperperiod;
+        for (int phase = 0; phase < period; ++phase) {
+            int peak = 0;
+            for (int step = phase; step < hyperperiod; step += period) peak = std::max(peak, load[step]);
+            if (peak < bestPeak) {
+                bestPeak = peak;
+                cascade.phase = phase;
+            }
         }
+        for (int step = cascade.phase; step < hyperperiod; step += period) ++load[step];
+
+        cascade.stepsSinceUpdate = 0;
+        cascade.newestSlot = 0;
+        cascade.valid = false;
+    }
+    m_step = 0;
+}
+
+void OceanFFT::setVelocityEnabled(bool enabled, bool uploadTexture) {
+    uploadTexture = enabled && uploadTexture;
+    if (m_velocityEnabled != enabled) {
+        m_velocityEnabled = enabled;
+        if (m_initialized) updateFieldLayout();
     }
 
-    // Upload to GPU
-    glBindTexture(GL_TEXTURE_2D, m_texDisplacement);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_N, m_N, 
-                    GL_RGB, GL_FLOAT, displacementData.data());
+    if (uploadTexture && m_initialized && !m_texVelocity) {
+        // Single level: velocities are consumed point-wise, not minified
+        m_texVelocity = createArrayTexture(GL_RGB32F, 1, getCascadeCount());
+    }
+    m_velocityTexture = uploadTexture;
+}
 
-    glBindTexture(GL_TEXTURE_2D, m_texNormal);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_N, m_N, 
-                    GL_RGB, GL_FLOAT, normalData.data());
+void OceanFFT::setJacobianEnabled(bool enabled) {
+    if (m_jacobianEnabled == enabled) return;
+    m_jacobianEnabled = enabled;
+    clearLoopCache();
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if (enabled) {
+        for (Cascade& cascade : m_cascades) {
+            std::fill(cascade.jacobian.begin(), cascade.jacobian.end(), 1.0f);
+            std::fill(cascade.foam.begin(), cascade.foam.end(), 0.0f);
+        }
+        if (m_initialized && !m_texFoam) {
+            // Small single-channel format, mip-mapped like the other maps
+            m_texFoam = createArrayTexture(GL_R8, m_mipLevels, getCascadeCount());
+            applyMipSampling();
+        }
+    }
+
+    if (m_initialized) updateFieldLayout();
 }
 
-float OceanFFT::phillipsSpectrum(const glm::vec2& k) const {
-    float kLen = glm::length(k);
-    if (kLen < 0.0001f) return 0.0f;
+void OceanFFT::setFoamParameters(float bias, float decayTime) {
+    decayTime = std::max(decayTime, 0.01f);
+    if (m_foamBias == bias && m_foamDecayTime == decayTime) return;
+    m_foamBias = bias;
+    m_foamDecayTime = decayTime;
+    clearLoopCache();
+}
 
-    // L = V² / g (largest possible wave from wind speed V)
-    float L = (m_windSpeed * m_windSpeed) / GRAVITY;
+void OceanFFT::setSparseFraction(float fraction) {
+    fraction = std::clamp(fraction, 0.0f, 0.5f);
+    if (m_sparseFraction == fraction) return;
+    m_sparseFraction = fraction;
+    clearLoopCache();
+    compactSpectrum();
+}
+
+void OceanFFT::setPrunedEnabled(bool enabled, float lossFraction) {
+    lossFraction = std::clamp(lossFraction, 0.0f, 0.5f);
+    if (m_prunedEnabled == enabled && m_prunedLoss == lossFraction) return;
+    m_prunedEnabled = enabled;
+    m_prunedLoss = lossFraction;
+    choosePrunedBands();
+}
 
-    // Alignment with wind direction
-    glm::vec2 kNorm = k / kLen;
-    float kDotW = glm::dot(kNorm, m_windDirection);
-    float kDotW2 = kDotW * kDotW;
+void OceanFFT::setLoopPeriod(float period) {
+    period = std::max(period, 0.0f);
+    if (m_loopPeriod == period) return;
+    m_loopPeriod = period;
+    for (Cascade& cascade : m_cascades) {
+        buildDispersionTable(cascade);
+        buildProbeBins(cascade);
+    }
+    m_computeSpectrumDirty = true;
+    clearLoopCache();
+}
 
-    // Suppress waves smaller than cutoff
-    float l = L / 1000.0f;  // Small wave cutoff
+bool OceanFFT::buildLoopCache(int frameCount) {
+    if (m_loopPeriod <= 0.0f || !m_initialized) {
+        std::cerr << "ERROR: Loop cache requires an initialized ocean in looping mode\n";
+        return false;
+    }
+    if (frameCount < 2) {
+        std::cerr << "ERROR: Loop cache needs at least 2 frames\n";
+        return false;
+    }
+    clearLoopCache();
 
-    // Phillips spectrum formula:
-    // P(k) = A * exp(-1/(kL)²) / k⁴ * (k̂·ŵ)² * exp(-k²l²)
-    float kLen2 = kLen * kLen;
-    float kLen4 = kLen2 * kLen2;
+    auto cache = std::make_unique<LoopCache>();
+    cache->simulator = createOfflineCopy();
+    if (!cache->simulator) return false;
+    cache->frameCount = frameCount;
+    cache->texels.resize(frameCount);
+    cache->foam.resize(frameCount);
 
-    float Ph = m_amplitude 
-             * std::exp(-1.0f / (kLen2 * L * L))
-             / kLen4
-             * kDotW2
-             * std::exp(-kLen2 * l * l);
+    size_t frameBytes = getPackedTexelCount() * sizeof(float) + getPackedFoamCount();
+    std::cout << "Building loop cache (" << frameCount << " frames over " << m_loopPeriod << "s, "
+              << (frameBytes * frameCount >> 20) << " MB)...\n";
 
-    return Ph;
+    // Foam depends on its history: run one period ahead so that the cached
+    // loop starts from the foam left by its own end
+    LoopCache* target = cache.get();
+    cache->worker = std::thread([target] {
+        OceanFFT& simulator = *target->simulator;
+        int warmup = simulator.m_jacobianEnabled ? target->frameCount : 0;
+        float dt = simulator.m_loopPeriod / target->frameCount;
+        size_t texelCount = simulator.getPackedTexelCount();
+        size_t foamCount = simulator.getPackedFoamCount();
+        runOffline(simulator, warmup, target->frameCount, dt,
+                   [=](int frame, const float* texels, const unsigned char* foam) {
+            if (target->cancel.load(std::memory_order_relaxed)) return false;
+            target->texels[frame].assign(texels, texels + texelCount);
+            target->foam[frame].assign(foam, foam + foamCount);
+            target->framesDone.fetch_add(1, std::memory_order_release);
+            return true;
+        });
+    });
+    m_loopCache = std::move(cache);
+    return true;
 }
 
-float OceanFFT::dispersion(const glm::vec2& k) const {
-    float kLen = glm::length(k);
-    return std::sqrt(GRAVITY * kLen);
+void OceanFFT::clearLoopCache() {
+    if (!m_loopCache) return;
+
+    m_loopCache->cancel.store(true);
+    if (m_loopCache->worker.joinable()) m_loopCache->worker.join();
+    deleteLoopTextures();
+    m_loopCache.reset();
+
+    // The layers hold cached frames; refill both of every pair
+    if (m_playing) stopPlayback();
 }
 
-float OceanFFT::gaussianRandom() const {
-    // Thread-local random generator
-    static thread_local std::mt19937 generator(std::random_device{}());
-    static thread_local std::normal_distribution<float> distribution(0.0f, 1.0f);
-    return distribution(generator);
+void OceanFFT::setLoopTexturesEnabled(bool enabled, bool compact) {
+    compact = enabled && compact;
+    if (m_loopTextures == enabled && m_loopTexturesCompact == compact) return;
+    m_loopTextures = enabled;
+    m_loopTexturesCompact = compact;
+
+    // The CPU copy of resident frames is gone
+    if (isLoopResident()) clearLoopCache();
 }
 
-glm::vec2 OceanFFT::getWaveVector(int x, int z) const {
-    // k = 2π * (n - N/2) / L, where n ∈ [0, N)
-    const float PI = 3.14159265358979323846f;
-    float kx = (2.0f * PI * (x - m_N / 2.0f)) / m_L;
-    float kz = (2.0f * PI * (z - m_N / 2.0f)) / m_L;
-    return glm::vec2(kx, kz);
+void OceanFFT::setHeightBoundsEnabled(bool enabled) {
+    if (enabled == m_heightBounds) return;
+    m_heightBounds = enabled;
+
+    // Pyramids of earlier frames would not match the layers any more
+    for (Cascade& cascade : m_cascades) {
+        cascade.heightBounds[0] = cascade.heightBounds[1] = HeightPyramid();
+    }
 }
 
-int OceanFFT::getIndex(int x, int z) const {
-    return z * m_N + x;
+bool OceanFFT::setFFTBackend(FFTBackend::Type type) {
+    if (type == m_fftBackendType) return true;
+    std::unique_ptr<FFTBackend> backend = FFTBackend::create(type);
+    if (!backend) {
+        std::cerr << "ERROR: FFT backend is not available in this build\n";
+        return false;
+    }
+
+    FFTBackend::Type previousType = m_fftBackendType;
+    std::unique_ptr<FFTBackend> previous = std::move(m_fftBackend);
+    m_fftBackendType = type;
+    m_fftBackend = std::move(backend);
+    if (!m_initialized) return true;
+
+    cleanupPlans();
+    if (createPlans()) return true;
+
+    // Keep simulating with the previous plans
+    m_fftBackendType = previousType;
+    m_fftBackend = std::move(previous);
+    cleanupPlans();
+    createPlans();
+    return false;
 }
 
-void OceanFFT::createTextures() {
-    // Displacement texture (RGB32F)
-    glGenTextures(1, &m_texDisplacement);
-    glBindTexture(GL_TEXTURE_2D, m_texDisplacement);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, m_N, m_N, 0, 
-                 GL_RGB, GL_FLOAT, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    // Normal texture (RGB32F)
-    glGenTextures(1, &m_texNormal);
-    glBindTexture(GL_TEXTURE_2D, m_texNormal);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, m_N, m_N, 0, 
-                 GL_RGB, GL_FLOAT, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+bool OceanFFT::usesFusedEvaluation() const {
+    return m_fusedEvaluation && m_plan && m_plan->getColumnBlockCount() > 0;
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+bool OceanFFT::hasHeightBounds() const {
+    if (!m_heightBounds || m_playing || isLoopResident() || m_compute) return false;
+    for (const Cascade& cascade : m_cascades) {
+        if (cascade.heightBounds[0].levels.empty() || cascade.heightBounds[1].levels.empty()) return false;
+    }
+    return true;
+}
+
+float OceanFFT::getLoopCacheProgress() const {
+    if (!m_loopCache) return 0.0f;
+    return static_cast<float>(m_loopCache->framesDone.load()) / m_loopCache->frameCount;
+}
+
+bool OceanFFT::simulateOffline(int frameCount, float dt, const FrameSink& sink) const {
+    std::unique_ptr<OceanFFT> simulator = createOfflineCopy();
+    if (!simulator) return false;
+    return runOffline(*simulator, 0, frameCount, dt, sink);
+}
+
+std::unique_ptr<OceanFFT> OceanFFT::createOfflineCopy(int workerThreads) const {
+    auto simulator = std::make_unique<OceanFFT>(m_N, getPatchSize(), workerThreads);
+    simulator->m_components = m_components;
+    simulator->m_choppy = m_choppy;
+    simulator->m_mipMode = m_mipMode;
+    simulator->m_jacobianEnabled = m_jacobianEnabled;
+    simulator->m_foamBias = m_foamBias;
+    simulator->m_foamDecayTime = m_foamDecayTime;
+    simulator->m_sparseFraction = m_sparseFraction;
+    simulator->m_loopPeriod = m_loopPeriod;
+    simulator->setFFTBackend(m_fftBackendType);
+    simulator->m_fusedEvaluation = m_fusedEvaluation;
+
+    std::vector<CascadeDesc> cascades = m_baseCascades;
+    for (CascadeDesc& desc : cascades) desc.updatePeriod = 1;
+    simulator->m_regionDepths = m_regionDepths;
+    simulator->setCascades(cascades);
+    for (int c = 0; c < getCascadeCount(); ++c) {
+        simulator->m_cascades[c].h0 = m_cascades[c].h0;
+        simulator->m_cascades[c].h0Conj = m_cascades[c].h0Conj;
+    }
+    simulator->compactSpectrum();
+
+    // FFT planners are not thread-safe, so plan here rather than on a worker
+    if (!simulator->createPlans()) return nullptr;
+    return simulator;
+}
+
+bool OceanFFT::runOffline(OceanFFT& simulator, int warmup, int frameCount, float dt, const FrameSink& sink) {
+    std::vector<float> texels;
+    std::vector<unsigned char> foam;
+    for (int i = -warmup; i < frameCount; ++i) {
+        simulator.simulate(dt * static_cast<float>(i + warmup));
+        if (i < 0) continue;
+
+        simulator.packFrame(texels, foam);
+        if (!sink(i, texels.data(), foam.data())) return false;
+    }
+    return true;
+}
+
+size_t OceanFFT::getPackedTexelCount() const {
+    int levels = m_mipMode == MipMode::None ? 1 : m_mipLevels;
+    size_t texels = 0;
+    for (int level = 0; level < levels; ++level) texels += static_cast<size_t>(m_N >> level) * (m_N >> level);
+    return texels * 6 * m_cascades.size();
+}
+
+size_t OceanFFT::getPackedFoamCount() const {
+    return m_jacobianEnabled ? getPackedTexelCount() / 6 : 0;
+}
+
+void OceanFFT::packFrame(std::vector<float>& texels, std::vector<unsigned char>& foam) const {
+    int levels = m_mipMode == MipMode::None ? 1 : m_mipLevels;
+    texels.clear();
+    foam.clear();
+    for (const Cascade& cascade : m_cascades) {
+        for (int level = 0; level < levels; ++level) {
+            const std::vector<float>& data = cascade.mips[level].displacementData;
+            texels.insert(texels.end(), data.begin(), data.end());
+        }
+        for (int level = 0; level < levels; ++level) {
+            const std::vector<float>& data = cascade.mips[level].normalData;
+            texels.insert(texels.end(), data.begin(), data.end());
+        }
+        if (!m_jacobianEnabled) continue;
+        for (int level = 0; level < levels; ++level) {
+            const std::vector<unsigned char>& data = cascade.mips[level].foamData;
+            foam.insert(foam.end(), data.begin(), data.end());
+        }
+    }
+}
+
+void OceanFFT::playLoop(double time) {
+    const LoopCache& cache = *m_loopCache;
+    const int frameCount = cache.frameCount;
+
+    // Frames frame and frame + 1 bracket the time
+    float position = static_cast<float>(std::fmod(time, static_cast<double>(m_loopPeriod)) / m_loopPeriod * frameCount);
+    if (position < 0.0f) position += frameCount;
+    int frame = std::min(static_cast<int>(position), frameCount - 1);
+    int next = (frame + 1) % frameCount;
+
+    PackedFrame previous{ frame, cache.texels[frame].data(), cache.foam[frame].data() };
+    PackedFrame upcoming{ next, cache.texels[next].data(), cache.foam[next].data() };
+    playFrames(previous, upcoming, position - frame);
+}
+
+void OceanFFT::playFrames(const PackedFrame& previous, const PackedFrame& next, float blend) {
+    m_playBlend = std::clamp(blend, 0.0f, 1.0f);
+    m_playing = true;
+    m_dueCascades.clear();
+
+    // Keep whichever of the two frames is already resident, so steady
+    // playback uploads at most one frame per step
+    int newest;
+    if (m_playSlotFrame[0] == next.id) newest = 0;
+    else if (m_playSlotFrame[1] == next.id) newest = 1;
+    else newest = m_playSlotFrame[0] == previous.id ? 1 : 0;
+
+    if (m_playSlotFrame[newest] != next.id) {
+        uploadFrame(next.texels, newest);
+        m_playSlotFrame[newest] = next.id;
+    }
+    if (m_playSlotFrame[newest ^ 1] != previous.id) {
+        uploadFrame(previous.texels, newest ^ 1);
+        m_playSlotFrame[newest ^ 1] = previous.id;
+    }
+
+    for (Cascade& cascade : m_cascades) {
+        cascade.newestSlot = newest;
+        cascade.stepsSinceUpdate = 0;
+        cascade.valid = true;
+    }
+
+    // Foam has a single layer per cascade: show the nearer frame
+    const PackedFrame& nearer = m_playBlend < 0.5f ? previous : next;
+    if (m_jacobianEnabled && m_texFoam && nearer.foam && m_playFoamFrame != nearer.id) {
+        int levels = m_mipMode == MipMode::None ? 1 : m_mipLevels;
+        const unsigned char* data = nearer.foam;
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_texFoam);
+        for (int c = 0; c < getCascadeCount(); ++c) {
+            for (int level = 0; level < levels; ++level) {
+                int size = m_N >> level;
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, c, size, size, 1,
+                                GL_RED, GL_UNSIGNED_BYTE, data);
+                data += static_cast<size_t>(size) * size;
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        m_playFoamFrame = nearer.id;
+    }
+}
+
+void OceanFFT::stopPlayback() {
+    m_playing = false;
+    m_playSlotFrame[0] = m_playSlotFrame[1] = -1;
+    m_playFoamFrame = -1;
+    scheduleCascades();
+}
+
+void OceanFFT::uploadFrame(const float* texels, int slot) {
+    int levels = m_mipMode == MipMode::None ? 1 : m_mipLevels;
+    for (int c = 0; c < getCascadeCount(); ++c) {
+        for (GLuint tex : { m_texDisplacement, m_texNormal }) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+            for (int level = 0; level < levels; ++level) {
+                int size = m_N >> level;
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 2 * c + slot, size, size, 1,
+                                GL_RGB, GL_FLOAT, texels);
+                texels += static_cast<size_t>(size) * size * 3;
+            }
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+bool OceanFFT::uploadLoopTextures() {
+    LoopCache& cache = *m_loopCache;
+    const int cascadeCount = getCascadeCount();
+    const int layers = cache.frameCount * cascadeCount;
+    const int levels = m_mipMode == MipMode::None ? 1 : m_mipLevels;
+
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (layers > maxLayers) {
+        std::cerr << "ERROR: Resident loop needs " << layers << " texture layers (limit " << maxLayers << ")\n";
+        cache.residentFailed = true;
+        return false;
+    }
+
+    // Frame-major layers: frame f of cascade c is layer f * cascadeCount + c
+    while (glGetError() != GL_NO_ERROR) {}
+    GLenum format = m_loopTexturesCompact ? GL_RGB16F : GL_RGB32F;
+    cache.texDisplacement = createArrayTexture(format, levels, layers);
+    cache.texNormal = createArrayTexture(format, levels, layers);
+    if (m_jacobianEnabled) cache.texFoam = createArrayTexture(GL_R8, levels, layers);
+    if (glGetError() != GL_NO_ERROR) {
+        std::cerr << "ERROR: Failed to allocate the resident loop textures\n";
+        deleteLoopTextures();
+        cache.residentFailed = true;
+        return false;
+    }
+
+    for (int frame = 0; frame < cache.frameCount; ++frame) {
+        const float* texels = cache.texels[frame].data();
+        const unsigned char* foam = cache.foam[frame].data();
+        for (int c = 0; c < cascadeCount; ++c) {
+            int layer = frame * cascadeCount + c;
+            for (GLuint tex : { cache.texDisplacement, cache.texNormal }) {
+                glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+                for (int level = 0; level < levels; ++level) {
+                    int size = m_N >> level;
+                    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size, size, 1,
+                                    GL_RGB, GL_FLOAT, texels);
+                    texels += static_cast<size_t>(size) * size * 3;
+                }
+            }
+            if (!cache.texFoam) continue;
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, cache.texFoam);
+            for (int level = 0; level < levels; ++level) {
+                int size = m_N >> level;
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size, size, 1,
+                                GL_RED, GL_UNSIGNED_BYTE, foam);
+                foam += static_cast<size_t>(size) * size;
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+
+        // Release each frame once it lives on the GPU
+        std::vector<float>().swap(cache.texels[frame]);
+        std::vector<unsigned char>().swap(cache.foam[frame]);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    size_t texelBytes = getPackedTexelCount() * (m_loopTexturesCompact ? 2 : 4);
+    std::cout << "Loop resident on the GPU (" << layers << " layers, "
+              << ((texelBytes + getPackedFoamCount()) * cache.frameCount >> 20) << " MB)\n";
+
+    // The live layers are refilled when simulation resumes
+    if (m_playing) stopPlayback();
+    cache.resident = true;
+    return true;
+}
+
+void OceanFFT::deleteLoopTextures() {
+    if (!m_loopCache) return;
+    for (GLuint* tex : { &m_loopCache->texDisplacement, &m_loopCache->texNormal, &m_loopCache->texFoam }) {
+        if (*tex) glDeleteTextures(1, tex);
+        *tex = 0;
+    }
+    m_loopCache->resident = false;
+}
+
+int OceanFFT::getActiveBinCount() const {
+    size_t count = 0;
+    for (const Cascade& cascade : m_cascades) count += cascade.activeBins.size();
+    return static_cast<int>(count);
+}
+
+float OceanFFT::getRetainedEnergy() const {
+    double total = 0.0;
+    double retained = 0.0;
+    for (const Cascade& cascade : m_cascades) {
+        total += cascade.totalEnergy;
+        retained += cascade.retainedEnergy;
+    }
+    return total > 0.0 ? static_cast<float>(retained / total) : 1.0f;
+}
+
+void OceanFFT::regenerateComponent(int component) {
+    // Until every cascade holds its per-component variances (first
+    // generation, new cascades or regions), everything is evaluated
+    for (const Cascade& cascade : m_cascades) {
+        if (cascade.variance.size() != m_components.size() ||
+            cascade.noise.size() != static_cast<size_t>(m_N) * m_N) {
+            generateH0();
+            return;
+        }
+    }
+    if (m_cascades.empty()) return;
+
+    std::cout << "Regenerating spectrum component " << component << " (wind: "
+              << m_components[component].windSpeed << "m/s)...\n";
+    for (Cascade& cascade : m_cascades) {
+        evaluateComponent(cascade, component);
+        combineComponents(cascade);
+    }
+
+    clearLoopCache();
+    compactSpectrum();
+}
+
+void OceanFFT::evaluateComponent(Cascade& cascade, int component) {
+    const float PI = 3.14159265358979323846f;
+    const float L0 = getPatchSize();
+    const size_t planeSize = static_cast<size_t>(m_N) * m_N;
+    const CascadeDesc& desc = cascade.desc;
+    float dk = 2.0f * PI / desc.patchSize;
+
+    // TMA takes the depth of the cascade's region
+    SpectrumComponent spectrumComponent = m_components[component];
+    if (cascade.depth > 0.0f) spectrumComponent.spectrum.depth = cascade.depth;
+    WaveSpectrum spectrum(spectrumComponent);
+
+    // Variance per bin. Phillips: same A for every cascade, a smaller
+    // patch has fewer, wider bins, so each carries (L0/L)² times the
+    // variance. Empirical models: ½ F(k) Δk² for ½(h0² + h0*²), times
+    // N⁴ for the unnormalized inverse FFT.
+    float binScale = spectrum.isPhillips()
+        ? (L0 / desc.patchSize) * (L0 / desc.patchSize)
+        : 0.5f * dk * dk * static_cast<float>(planeSize) * static_cast<float>(planeSize);
+
+    std::vector<float>& variance = cascade.variance[component];
+    variance.resize(planeSize);
+    m_threadPool->parallelFor(m_N, [&](int z) {
+        size_t row = static_cast<size_t>(z) * m_N;
+        spectrum.evaluate(m_gridRadius.data() + row, m_gridAngle.data() + row, m_N, dk, variance.data() + row);
+
+        for (int x = 0; x < m_N; ++x) {
+            // Restricted to this cascade's band
+            float kLen = m_gridRadius[row + x] * dk;
+            bool inBand = kLen >= desc.kMin && (desc.kMax <= 0.0f || kLen < desc.kMax);
+            variance[row + x] = inBand ? variance[row + x] * binScale : 0.0f;
+        }
+    });
+}
+
+void OceanFFT::combineComponents(Cascade& cascade) {
+    const size_t planeSize = static_cast<size_t>(m_N) * m_N;
+
+    // h0(k) over the full FFT-ordered grid, so that h0*(-k) is the conjugate
+    // of the same random draw mirrored through the origin. Independent
+    // systems add their variances under one set of random phases.
+    std::vector<std::complex<float>> h0Full(planeSize);
+    m_threadPool->parallelFor(m_N, [&](int z) {
+        size_t row = static_cast<size_t>(z) * m_N;
+        for (int x = 0; x < m_N; ++x) {
+            float P = 0.0f;
+            for (const std::vector<float>& variance : cascade.variance) {
+                P += variance[row + x];
+            }
+            // h0(k) = 1/sqrt(2) * (xi_r + i*xi_i) * sqrt(P(k))
+            h0Full[row + x] = cascade.noise[row + x] * (std::sqrt(P) * 0.707106781f);
+        }
+    });
+
+    // Keep only the half plane needed by the c2r transform
+    m_threadPool->parallelFor(m_N, [&](int z) {
+        int negZ = (m_N - z) % m_N;
+        for (int x = 0; x <= m_N / 2; ++x) {
+            int idx = getSpectrumIndex(x, z);
+            int negX = x == 0 ? 0 : m_N - x;
+            cascade.h0[idx] = h0Full[getIndex(x, z)];
+            cascade.h0Conj[idx] = std::conj(h0Full[getIndex(negX, negZ)]);
+        }
+    });
+}
+
+void OceanFFT::generateH0() {
+    std::cout << "Generating h0 spectrum (" << m_components.size() << " component(s), wind: "
+              << m_components[0].windSpeed << "m/s, amplitude: " << m_components[0].amplitude << ")...\n";
+
+    const size_t planeSize = static_cast<size_t>(m_N) * m_N;
+    const int perRegion = getCascadesPerRegion();
+
+    for (int c = 0; c < getCascadeCount(); ++c) {
+        Cascade& cascade = m_cascades[c];
+
+        // Complex Gaussian draws, kept so that parameter changes reshape the
+        // same waves instead of replacing them. Deeper regions reuse the
+        // draws of the first, so that blended regions match.
+        if (c >= perRegion) {
+            cascade.noise = m_cascades[c % perRegion].noise;
+        } else if (cascade.noise.size() != planeSize) {
+            cascade.noise.resize(planeSize);
+            for (std::complex<float>& xi : cascade.noise) {
+                float xi_r = gaussianRandom();
+                float xi_i = gaussianRandom();
+                xi = std::complex<float>(xi_r, xi_i);
+            }
+        }
+
+        cascade.variance.resize(m_components.size());
+        for (int i = 0; i < getSpectrumComponentCount(); ++i) {
+            evaluateComponent(cascade, i);
+        }
+        combineComponents(cascade);
+    }
+
+    clearLoopCache();
+    compactSpectrum();
+}
+
+void OceanFFT::compactSpectrum() {
+    const int halfN = m_N / 2 + 1;
+
+    for (Cascade& cascade : m_cascades) {
+        // Energy per stored bin; columns 1..N/2-1 also stand for their
+        // conjugate half, which the c2r layout leaves implicit. Positive
+        // floats order like their bits, so the leading bits bucket them.
+        // Each thread sums a block of rows into its own buckets (only
+        // needed to prune); the blocks are merged in order.
+        const int BUCKET_SHIFT = 16;
+        const size_t bucketCount = size_t(1) << (31 - BUCKET_SHIFT);
+        const bool prune = m_sparseFraction > 0.0f;
+        const int blocks = std::min(m_threadPool->getThreadCount(), m_N);
+        std::vector<float> energies(m_spectrumSize);
+        std::vector<std::vector<double>> blockBuckets(blocks);
+        std::vector<double> blockEnergy(blocks, 0.0);
+        m_threadPool->parallelFor(blocks, [&](int block) {
+            std::vector<double>& buckets = blockBuckets[block];
+            if (prune) buckets.assign(bucketCount, 0.0);
+            double total = 0.0;
+            for (int z = block * m_N / blocks; z < (block + 1) * m_N / blocks; ++z) {
+                for (int x = 0; x < halfN; ++x) {
+                    int idx = z * halfN + x;
+                    float weight = (x == 0 || x == m_N / 2) ? 1.0f : 2.0f;
+                    float energy = weight * (std::norm(cascade.h0[idx]) + std::norm(cascade.h0Conj[idx]));
+                    energies[idx] = energy;
+                    if (energy <= 0.0f) continue;
+                    total += energy;
+                    if (!prune) continue;
+                    uint32_t bits;
+                    std::memcpy(&bits, &energy, sizeof(bits));
+                    buckets[bits >> BUCKET_SHIFT] += energy;
+                }
+            }
+            blockEnergy[block] = total;
+        });
+        cascade.totalEnergy = 0.0;
+        for (double energy : blockEnergy) cascade.totalEnergy += energy;
+
+        // Keep the strongest bins until at most m_sparseFraction is left out:
+        // whole buckets from the top, then the sorted bins of the bucket that
+        // crosses the requirement. Kept are the bins above threshold and the
+        // first tiesKept bins equal to it.
+        float threshold = 0.0f;
+        int tiesKept = 0;
+        if (prune) {
+            std::vector<double>& bucketEnergy = blockBuckets[0];
+            for (int block = 1; block < blocks; ++block) {
+                for (size_t b = 0; b < bucketCount; ++b) bucketEnergy[b] += blockBuckets[block][b];
+            }
+
+            double required = cascade.totalEnergy * (1.0 - m_sparseFraction);
+            double above = 0.0;
+            int bucket = static_cast<int>(bucketCount) - 1;
+            while (bucket >= 0 && above + bucketEnergy[bucket] < required) above += bucketEnergy[bucket--];
+
+            if (bucket >= 0) threshold = FLT_MAX;
+            if (bucket >= 0 && above < required) {
+                std::vector<float> boundary;
+                for (float energy : energies) {
+                    uint32_t bits;
+                    std::memcpy(&bits, &energy, sizeof(bits));
+                    if (energy > 0.0f && static_cast<int>(bits >> BUCKET_SHIFT) == bucket) boundary.push_back(energy);
+                }
+                std::sort(boundary.begin(), boundary.end(), std::greater<float>());
+                for (size_t i = 0; i < boundary.size() && above < required; ++i) {
+                    above += boundary[i];
+                    tiesKept = boundary[i] == threshold ? tiesKept + 1 : 1;
+                    threshold = boundary[i];
+                }
+            }
+        }
+        blockBuckets.clear();
+
+        // Kept bins per row, the ties going to the first rows holding them
+        std::vector<int> rowTies(m_N, 0);
+        cascade.rowStart.assign(m_N + 1, 0);
+        m_threadPool->parallelFor(m_N, [&](int z) {
+            int count = 0;
+            for (int idx = z * halfN; idx < (z + 1) * halfN; ++idx) {
+                count += energies[idx] > threshold;
+                rowTies[z] += energies[idx] == threshold && energies[idx] > 0.0f;
+            }
+            cascade.rowStart[z + 1] = count;
+        });
+        for (int z = 0; z < m_N; ++z) {
+            rowTies[z] = std::min(rowTies[z], tiesKept);
+            tiesKept -= rowTies[z];
+            cascade.rowStart[z + 1] += cascade.rowStart[z] + rowTies[z];
+        }
+
+        // Row-major order so each row is a contiguous range; each row also
+        // counts into its columns for the column-major copy
+        const size_t kept = cascade.rowStart[m_N];
+        cascade.activeBins.resize(kept);
+        std::vector<uint8_t> active(m_spectrumSize);
+        std::vector<double> rowEnergy(m_N, 0.0);
+        m_threadPool->parallelFor(m_N, [&](int z) {
+            int next = cascade.rowStart[z];
+            int ties = rowTies[z];
+            for (int idx = z * halfN; idx < (z + 1) * halfN; ++idx) {
+                float energy = energies[idx];
+                if (energy > threshold || (energy == threshold && energy > 0.0f && ties-- > 0)) {
+                    cascade.activeBins[next++] = idx;
+                    active[idx] = 1;
+                    rowEnergy[z] += energy;
+                }
+            }
+        });
+        cascade.retainedEnergy = 0.0;
+        for (double energy : rowEnergy) cascade.retainedEnergy += energy;
+
+        // Column-major copy for the fused evaluation, which works on column blocks
+        cascade.columnStart.assign(halfN + 1, 0);
+        m_threadPool->parallelFor(halfN, [&](int x) {
+            int count = 0;
+            for (int z = 0; z < m_N; ++z) count += active[z * halfN + x];
+            cascade.columnStart[x + 1] = count;
+        });
+        for (int x = 0; x < halfN; ++x) cascade.columnStart[x + 1] += cascade.columnStart[x];
+        cascade.columnBins.resize(kept);
+        m_threadPool->parallelFor(halfN, [&](int x) {
+            int next = cascade.columnStart[x];
+            for (int z = 0; z < m_N; ++z) {
+                if (active[z * halfN + x]) cascade.columnBins[next++] = z * halfN + x;
+            }
+        });
+
+        // bfloat16 copy of h0 for compact cascades
+        cascade.h0Compact.clear();
+        if (cascade.desc.precision == Precision::Compact) {
+            cascade.h0Compact.resize(4 * static_cast<size_t>(m_spectrumSize));
+            m_threadPool->parallelFor(m_N, [&](int z) {
+                for (int idx = z * halfN; idx < (z + 1) * halfN; ++idx) {
+                    uint16_t* packed = cascade.h0Compact.data() + 4 * static_cast<size_t>(idx);
+                    packed[0] = toBfloat16(cascade.h0[idx].real());
+                    packed[1] = toBfloat16(cascade.h0[idx].imag());
+                    packed[2] = toBfloat16(cascade.h0Conj[idx].real());
+                    packed[3] = toBfloat16(cascade.h0Conj[idx].imag());
+                }
+            });
+        }
+
+        buildProbeBins(cascade);
+    }
+
+    choosePrunedBands();
+    m_computeSpectrumDirty = true;
+}
+
+void OceanFFT::choosePrunedBands() {
+    const int halfN = m_N / 2 + 1;
+
+    for (Cascade& cascade : m_cascades) {
+        // Energy by "radius" max(|nx|, |nz|), so the band |n| < M/2 holds
+        // the cumulative energy of radii below M/2
+        std::vector<double> radial(m_N / 2 + 1, 0.0);
+        double total = 0.0;
+        for (int idx = 0; idx < m_spectrumSize; ++idx) {
+            int x = idx % halfN;
+            int z = idx / halfN;
+            int nz = z < m_N / 2 ? z : m_N - z;
+            double weight = (x == 0 || x == m_N / 2) ? 1.0 : 2.0;
+            double energy = weight * (std::norm(cascade.h0[idx]) + std::norm(cascade.h0Conj[idx]));
+            radial[std::max(x, nz)] += energy;
+            total += energy;
+        }
+
+        // Smallest power-of-two grid whose band keeps enough energy
+        int level = 0;
+        if (m_prunedEnabled && total > 0.0) {
+            double required = total * (1.0 - m_prunedLoss);
+            for (int l = m_mipLevels - 1; l > 0; --l) {
+                int M = m_N >> l;
+                if (M < MIN_PRUNED_SIZE) continue;
+                double inBand = 0.0;
+                for (int r = 0; r < M / 2; ++r) inBand += radial[r];
+                if (inBand >= required) {
+                    level = l;
+                    break;
+                }
+            }
+        }
+
+        // Level 0 reuses the full-resolution FFT output
+        MipLevel& pruned = cascade.pruned;
+        cascade.prunedLevel = level;
+        pruned.size = m_N >> level;
+        size_t texels = static_cast<size_t>(pruned.size) * pruned.size;
+        pruned.spectrum.resize(level > 0 ? static_cast<size_t>(RENDER_FIELD_COUNT) * pruned.size * (pruned.size / 2 + 1) : 0);
+        pruned.fields.resize(level > 0 ? RENDER_FIELD_COUNT * texels : 0);
+        pruned.displacementData.assign(m_prunedEnabled ? texels * 3 : 0, 0.0f);
+        pruned.normalData.assign(m_prunedEnabled ? texels * 3 : 0, 0.0f);
+    }
+}
+
+void OceanFFT::evaluateWaves(double t) {
+    // Rows of all due cascades are independent work items
+    m_threadPool->parallelFor(getUpdatedCascadeCount() * m_N, [&](int item) {
+        evaluateRow(m_dueCascades[item / m_N], item % m_N, t);
+    });
+}
+
+void OceanFFT::evaluateRow(int cascade, int z, double t) {
+    const Cascade& state = m_cascades[cascade];
+
+    // The transform overwrites its input, so clear the row of every active
+    // plane before scattering the evolved bins into it
+    const int halfN = m_N / 2 + 1;
+    for (int slot = 0; slot < m_activeFields; ++slot) {
+        std::complex<float>* row = m_spectrum.data()
+            + (static_cast<size_t>(cascade) * FIELD_COUNT + slot) * m_spectrumSize
+            + static_cast<size_t>(z) * halfN;
+        std::fill(row, row + halfN, std::complex<float>(0.0f));
+    }
+
+    std::complex<float>* planes[FIELD_COUNT];
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        planes[f] = m_fieldSlot[f] >= 0 ? spectrum(cascade, static_cast<Field>(f)) : nullptr;
+    }
+
+    visitPrecision(state.desc.precision, [&](auto policy) {
+        using Policy = decltype(policy);
+        for (int i = state.rowStart[z]; i < state.rowStart[z + 1]; ++i) {
+            int idx = state.activeBins[i];
+            evolveBin<Policy>(state, idx - z * halfN, z, idx, t, [&](Field f, std::complex<float> value) {
+                planes[f][idx] = value;
+            });
+        }
+    });
+}
+
+template <typename Policy, typename Store>
+void OceanFFT::evolveBin(const Cascade& state, int x, int z, int idx, double t, const Store& store) const {
+    using namespace std::complex_literals;
+    using Real = typename Policy::Real;
+
+    glm::vec2 k = getWaveVector(x, z, state.desc.patchSize);
+    float kLen = glm::length(k);
+
+    // Dispersion relation, tabulated for the cascade's depth
+    float omega = state.omega[idx];
+
+    // Time evolution: h(k,t) = h0(k)*exp(iωt) + h0*(-k)*exp(-iωt)
+    std::complex<Real> expIwt;
+    if constexpr (std::is_same_v<Real, double>) {
+        // Reduced in double, as float ω and t would shift the phase by ~ωt * 1e-7
+        const double TWO_PI = 6.28318530717958647692;
+        expIwt = std::polar(1.0, std::fmod(state.omegaDouble[idx] * t, TWO_PI));
+    } else {
+        expIwt = std::exp(1if * omega * static_cast<float>(t));
+    }
+    std::complex<Real> expMinusIwt = std::conj(expIwt);
+
+    std::complex<Real> h0;
+    std::complex<Real> h0Conj;
+    if constexpr (Policy::COMPACT) {
+        const uint16_t* packed = state.h0Compact.data() + 4 * static_cast<size_t>(idx);
+        h0 = std::complex<Real>(fromBfloat16(packed[0]), fromBfloat16(packed[1]));
+        h0Conj = std::complex<Real>(fromBfloat16(packed[2]), fromBfloat16(packed[3]));
+    } else {
+        h0 = std::complex<Real>(state.h0[idx]);
+        h0Conj = std::complex<Real>(state.h0Conj[idx]);
+    }
+
+    std::complex<float> htilde(h0 * expIwt + h0Conj * expMinusIwt);
+    store(FIELD_HEIGHT, htilde);
+
+    // Choppy displacement: D(x) = -i * k/|k| * h(k,t)
+    if (kLen > 0.0001f) {
+        std::complex<float> factor = -1if * htilde / kLen;
+        store(FIELD_CHOPPY_X, factor * k.x);
+        store(FIELD_CHOPPY_Z, factor * k.y);
+    } else {
+        store(FIELD_CHOPPY_X, std::complex<float>(0.0f));
+        store(FIELD_CHOPPY_Z, std::complex<float>(0.0f));
+    }
+
+    // Surface velocity: ∂h/∂t = iω * (h0(k)*exp(iωt) - h0*(-k)*exp(-iωt)),
+    // horizontal components follow the choppy operator
+    if (m_velocityEnabled) {
+        std::complex<float> dhdt = 1if * omega * std::complex<float>(h0 * expIwt - h0Conj * expMinusIwt);
+        store(FIELD_VELOCITY_Y, dhdt);
+        if (kLen > 0.0001f) {
+            std::complex<float> factor = -1if * dhdt / kLen;
+            store(FIELD_VELOCITY_X, factor * k.x);
+            store(FIELD_VELOCITY_Z, factor * k.y);
+        } else {
+            store(FIELD_VELOCITY_X, std::complex<float>(0.0f));
+            store(FIELD_VELOCITY_Z, std::complex<float>(0.0f));
+        }
+    }
+
+    // Jacobian terms: ∂/∂x of D ↔ i*kx * (-i*k/|k|) = kx*k/|k|
+    if (m_jacobianEnabled) {
+        float invLen = kLen > 0.0001f ? 1.0f / kLen : 0.0f;
+        store(FIELD_JACOBIAN_XX, htilde * (k.x * k.x * invLen));
+        store(FIELD_JACOBIAN_ZZ, htilde * (k.y * k.y * invLen));
+        store(FIELD_JACOBIAN_XZ, htilde * (k.x * k.y * invLen));
+    }
+
+    // Normal calculation: N = (-∂h/∂x, 1, -∂h/∂z)
+    // In frequency domain: ∂h/∂x ↔ i*kx*h(k), ∂h/∂z ↔ i*kz*h(k)
+    if (!m_normalPass) {
+        store(FIELD_NORMAL_X, 1if * k.x * htilde);
+        store(FIELD_NORMAL_Z, 1if * k.y * htilde);
+    }
+}
+
+void OceanFFT::transformFused(double t) {
+    const FFTPlan& plan = *m_plan;
+
+    // First pass: each column block is evolved straight into the plan's lanes
+    const int columnBlocks = plan.getColumnBlockCount();
+    m_threadPool->parallelFor(getUpdatedCascadeCount() * columnBlocks, [&](int item) {
+        int cascade = m_dueCascades[item / columnBlocks];
+        plan.transformColumns(item % columnBlocks, [&](int x0, int count, int lanes, float* re, float* im) {
+            evaluateColumns(cascade, x0, count, lanes, re, im, t);
+        }, spectrum(cascade, FIELD_HEIGHT));
+    });
+
+    // Second pass: rows are scaled and packed while cached. The planes stay
+    // complete for sampling, box-filtered mips, height bounds and foam.
+    const int rowBlocks = plan.getRowBlockCount();
+    const int rowsPerBlock = plan.getRowsPerBlock();
+    m_threadPool->parallelFor(getUpdatedCascadeCount() * rowBlocks, [&](int item) {
+        int cascade = m_dueCascades[item / rowBlocks];
+        int block = item % rowBlocks;
+        plan.transformRows(block, spectrum(cascade, FIELD_HEIGHT), field(cascade, FIELD_HEIGHT));
+
+        int rowBegin = block * rowsPerBlock;
+        int rowEnd = std::min(rowBegin + rowsPerBlock, m_N);
+        for (int f = 0; f < FIELD_COUNT; ++f) {
+            if (m_fieldSlot[f] < 0) continue;
+            Field id = static_cast<Field>(f);
+            scalePlane(field(cascade, id) + static_cast<size_t>(rowBegin) * m_N,
+                       static_cast<size_t>(rowEnd - rowBegin) * m_N, fieldScale(id));
+        }
+        packRows(field(cascade, FIELD_HEIGHT), m_N, rowBegin, rowEnd, m_cascades[cascade].mips[0]);
+    });
+}
+
+void OceanFFT::evaluateColumns(int cascade, int x0, int count, int lanes, float* re, float* im, double t) {
+    Cascade& state = m_cascades[cascade];
+    const int halfN = m_N / 2 + 1;
+    auto laneIndex = [&](Field f, int x, int z) {
+        return (static_cast<size_t>(m_fieldSlot[f]) * m_N + z) * lanes + (x - x0);
+    };
+
+    visitPrecision(state.desc.precision, [&](auto policy) {
+        using Policy = decltype(policy);
+        for (int x = x0; x < x0 + count; ++x) {
+            for (int i = state.columnStart[x]; i < state.columnStart[x + 1]; ++i) {
+                int idx = state.columnBins[i];
+                int z = idx / halfN;
+                evolveBin<Policy>(state, x, z, idx, t, [&](Field f, std::complex<float> value) {
+                    size_t at = laneIndex(f, x, z);
+                    re[at] = value.real();
+                    im[at] = value.imag();
+                });
+            }
+        }
+    });
+
+    // This block's columns of the band-limited mip and pruned inputs
+    auto fetch = [&](Field f, int x, int z) {
+        size_t at = laneIndex(f, x, z);
+        return std::complex<float>(re[at], im[at]);
+    };
+    if (m_mipMode == MipMode::Spectral) gatherMipSpectra(cascade, x0, x0 + count, fetch);
+    if (m_prunedEnabled && state.prunedLevel > 0) {
+        gatherSubSpectrum(state.prunedLevel, 0.0f, state.pruned, x0, x0 + count, fetch);
+    }
+}
+
+void OceanFFT::executeFFT() {
+    // One batched transform per cascade, cascades in parallel (new-array
+    // execution is thread-safe as long as the arrays are distinct)
+    m_threadPool->parallelFor(getUpdatedCascadeCount(), [&](int item) {
+        int cascade = m_dueCascades[item];
+        m_plan->execute(spectrum(cascade, FIELD_HEIGHT), field(cascade, FIELD_HEIGHT));
+
+        // Normalize (inverse transforms are not normalized)
+        for (int f = 0; f < FIELD_COUNT; ++f) {
+            if (m_fieldSlot[f] < 0) continue;
+            Field id = static_cast<Field>(f);
+            scalePlane(field(cascade, id), static_cast<size_t>(m_N) * m_N, fieldScale(id));
+        }
+    });
+}
+
+bool OceanFFT::updateFieldLayout() {
+    // Render fields first, then the optional groups in enum order
+    m_activeFields = 0;
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        bool active = f < getRenderFieldCount()
+                   || (m_velocityEnabled && f >= FIELD_VELOCITY_X && f <= FIELD_VELOCITY_Z)
+                   || (m_jacobianEnabled && f >= FIELD_JACOBIAN_XX && f <= FIELD_JACOBIAN_XZ);
+        m_fieldSlot[f] = active ? m_activeFields++ : -1;
+    }
+
+    // Planned on cascade 0; the other cascades sit at plane-sized offsets
+    // of the same arrays and so keep the same alignment
+    m_plan = m_fftBackend->planInverse2D(m_N, m_activeFields, m_spectrum.data(), m_fields.data(), false);
+    return m_plan != nullptr;
+}
+
+float OceanFFT::fieldScale(Field f) const {
+    float norm = 1.0f / (m_N * m_N);
+    switch (f) {
+        case FIELD_CHOPPY_X:
+        case FIELD_CHOPPY_Z:
+        case FIELD_VELOCITY_X:
+        case FIELD_VELOCITY_Z:
+        case FIELD_JACOBIAN_XX:
+        case FIELD_JACOBIAN_ZZ:
+        case FIELD_JACOBIAN_XZ:
+            return norm * m_choppy;
+        default:
+            return norm;
+    }
+}
+
+template <typename Fetch>
+void OceanFFT::gatherMipSpectra(int cascade, int xBegin, int xEnd, const Fetch& fetch) {
+    // Each level is the inverse transform of the band |k| < M/2 of the
+    // full spectrum, so it is band-limited instead of merely averaged.
+    const float PI = 3.14159265358979323846f;
+    for (int level = 1; level < m_mipLevels; ++level) {
+        // A level-m texel centre sits (2^m - 1)/2 base texels past the
+        // sample point of the M-point transform; shift by that phase
+        float shift = PI * static_cast<float>((1 << level) - 1) / m_N;
+        gatherSubSpectrum(level, shift, m_cascades[cascade].mips[level], xBegin, xEnd, fetch);
+    }
+}
+
+template <typename Fetch>
+void OceanFFT::gatherSubSpectrum(int level, float shift, MipLevel& dst, int xBegin, int xEnd,
+                                 const Fetch& fetch) const {
+    // Coefficients keep the full-resolution scale (norm stays 1/N²)
+    int M = m_N >> level;
+    int halfM = M / 2 + 1;
+    size_t planeSize = static_cast<size_t>(M) * halfM;
+    xEnd = std::min(xEnd, halfM);
+
+    for (int z = 0; z < M; ++z) {
+        int fz = z < M / 2 ? z : z - M;
+        int srcZ = fz >= 0 ? fz : fz + m_N;
+        bool nyquistRow = M > 1 && z == M / 2;
+        for (int x = xBegin; x < xEnd; ++x) {
+            bool nyquist = nyquistRow || (M > 1 && x == M / 2);
+            std::complex<float> phase = std::polar(1.0f, shift * (x + fz));
+            for (int f = 0; f < getRenderFieldCount(); ++f) {
+                std::complex<float>* out = dst.spectrum.data() + f * planeSize;
+                out[z * halfM + x] = nyquist ? std::complex<float>(0.0f)
+                                             : fetch(static_cast<Field>(f), x, srcZ) * phase;
+            }
+        }
+    }
+}
+
+void OceanFFT::generatePruned(int cascade) {
+    Cascade& state = m_cascades[cascade];
+    MipLevel& pruned = state.pruned;
+    if (state.prunedLevel == 0) {
+        packLevel(field(cascade, FIELD_HEIGHT), m_N, pruned);
+        return;
+    }
+
+    // The M-point transform of the band equals the pruned N-point inverse
+    // FFT sampled every N/M texels; same plans as the spectral mip chain
+    int M = pruned.size;
+    size_t planeSize = static_cast<size_t>(M) * M;
+    m_mipPlans[state.prunedLevel]->execute(pruned.spectrum.data(), pruned.fields.data());
+    for (int f = 0; f < getRenderFieldCount(); ++f) {
+        scalePlane(pruned.fields.data() + f * planeSize, planeSize, fieldScale(static_cast<Field>(f)));
+    }
+    packLevel(pruned.fields.data(), M, pruned);
+}
+
+void OceanFFT::generateMips(int cascade) {
+    std::vector<MipLevel>& mips = m_cascades[cascade].mips;
+    const float* baseFields = field(cascade, FIELD_HEIGHT);
+
+    if (m_mipMode == MipMode::BoxFilter) {
+        // Each level is the 2x2 average of the previous one
+        for (int level = 1; level < m_mipLevels; ++level) {
+            MipLevel& mip = mips[level];
+            const MipLevel& parent = mips[level - 1];
+            const float* src = level == 1 ? baseFields : parent.fields.data();
+            size_t srcPlane = static_cast<size_t>(parent.size) * parent.size;
+            size_t dstPlane = static_cast<size_t>(mip.size) * mip.size;
+            for (int f = 0; f < getRenderFieldCount(); ++f) {
+                boxFilterPlane(src + f * srcPlane, parent.size, mip.fields.data() + f * dstPlane);
+            }
+            packLevel(mip.fields.data(), mip.size, mip);
+        }
+    } else if (m_mipMode == MipMode::Spectral) {
+        // Sub-spectra were gathered by gatherMipSpectra before the main FFT
+        for (int level = 1; level < m_mipLevels; ++level) {
+            MipLevel& mip = mips[level];
+            int M = mip.size;
+
+            m_mipPlans[level]->execute(mip.spectrum.data(), mip.fields.data());
+            for (int f = 0; f < getRenderFieldCount(); ++f) {
+                scalePlane(mip.fields.data() + f * static_cast<size_t>(M) * M,
+                           static_cast<size_t>(M) * M, fieldScale(static_cast<Field>(f)));
+            }
+            packLevel(mip.fields.data(), M, mip);
+        }
+    }
+}
+
+void OceanFFT::packLevel(const float* fields, int size, MipLevel& level) const {
+    packRows(fields, size, 0, size, level);
+}
+
+void OceanFFT::packRows(const float* fields, int size, int rowBegin, int rowEnd, MipLevel& level) const {
+    size_t planeSize = static_cast<size_t>(size) * size;
+    const float* height = fields + FIELD_HEIGHT * planeSize;
+    const float* choppyX = fields + FIELD_CHOPPY_X * planeSize;
+    const float* choppyZ = fields + FIELD_CHOPPY_Z * planeSize;
+    const float* normalX = fields + FIELD_NORMAL_X * planeSize;
+    const float* normalZ = fields + FIELD_NORMAL_Z * planeSize;
+
+    float* displacementData = level.displacementData.data();
+    float* normalData = level.normalData.data();
+
+    for (size_t idx = static_cast<size_t>(rowBegin) * size; idx < static_cast<size_t>(rowEnd) * size; ++idx) {
+        size_t texIdx = idx * 3;
+
+        // Displacement (x, y, z)
+        displacementData[texIdx + 0] = choppyX[idx];
+        displacementData[texIdx + 1] = height[idx];
+        displacementData[texIdx + 2] = choppyZ[idx];
+        if (m_normalPass) continue;     // Derived on the GPU (setGPUNormals)
+
+        // Normal (-∂h/∂x, 1, -∂h/∂z) normalized
+        glm::vec3 normal(-normalX[idx], 1.0f, -normalZ[idx]);
+        normal = glm::normalize(normal);
+        normalData[texIdx + 0] = normal.x;
+        normalData[texIdx + 1] = normal.y;
+        normalData[texIdx + 2] = normal.z;
+    }
+}
+
+void OceanFFT::updateTextures() {
+    int levels = m_mipMode == MipMode::None ? 1 : m_mipLevels;
+
+    // Upload to GPU (storage is immutable, only the contents change).
+    // A cascade's first frame fills both layers of its pair.
+    for (int c : m_dueCascades) {
+        Cascade& cascade = m_cascades[c];
+        int firstLayer = cascade.valid ? getCascadeLayer(c) : 2 * c;
+        int layerCount = cascade.valid ? 1 : 2;
+
+        for (int layer = firstLayer; layer < firstLayer + layerCount; ++layer) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_texDisplacement);
+            for (int level = 0; level < levels; ++level) {
+                const MipLevel& mip = cascade.mips[level];
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, mip.size, mip.size, 1,
+                                GL_RGB, GL_FLOAT, mip.displacementData.data());
+            }
+
+            if (m_normalPass) {
+                m_normalPass->derive(m_texDisplacement, m_texNormal, layer, levels, m_N, cascade.desc.patchSize);
+                continue;
+            }
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_texNormal);
+            for (int level = 0; level < levels; ++level) {
+                const MipLevel& mip = cascade.mips[level];
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, mip.size, mip.size, 1,
+                                GL_RGB, GL_FLOAT, mip.normalData.data());
+            }
+        }
+        cascade.valid = true;
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void OceanFFT::updateVelocityTexture() {
+    size_t planeSize = static_cast<size_t>(m_N) * m_N;
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texVelocity);
+    for (int c : m_dueCascades) {
+        const float* velocityX = field(c, FIELD_VELOCITY_X);
+        const float* velocityY = field(c, FIELD_VELOCITY_Y);
+        const float* velocityZ = field(c, FIELD_VELOCITY_Z);
+        std::vector<float>& velocityData = m_cascades[c].velocityData;
+
+        for (size_t idx = 0; idx < planeSize; ++idx) {
+            velocityData[idx * 3 + 0] = velocityX[idx];
+            velocityData[idx * 3 + 1] = velocityY[idx];
+            velocityData[idx * 3 + 2] = velocityZ[idx];
+        }
+
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, c, m_N, m_N, 1,
+                        GL_RGB, GL_FLOAT, velocityData.data());
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void OceanFFT::updateFoam(int cascade, float dt) {
+    const float* jxx = field(cascade, FIELD_JACOBIAN_XX);
+    const float* jzz = field(cascade, FIELD_JACOBIAN_ZZ);
+    const float* jxz = field(cascade, FIELD_JACOBIAN_XZ);
+    float* jacobian = m_cascades[cascade].jacobian.data();
+    float* foam = m_cascades[cascade].foam.data();
+
+    // Exponential decay of existing foam, new foam where the surface folds
+    float decay = std::exp(-dt / m_foamDecayTime);
+    size_t planeSize = static_cast<size_t>(m_N) * m_N;
+    for (size_t idx = 0; idx < planeSize; ++idx) {
+        // J = (1 + ∂Dx/∂x)(1 + ∂Dz/∂z) - (∂Dx/∂z)²
+        float J = (1.0f + jxx[idx]) * (1.0f + jzz[idx]) - jxz[idx] * jxz[idx];
+        jacobian[idx] = J;
+
+        float injected = std::clamp((m_foamBias - J) * 2.0f, 0.0f, 1.0f);
+        foam[idx] = std::max(foam[idx] * decay, injected);
+    }
+}
+
+void OceanFFT::packFoam(int cascade) {
+    // Level 0 quantized to 8 bits, lower levels averaged (cheap at 1 byte/texel)
+    std::vector<MipLevel>& mips = m_cascades[cascade].mips;
+    const float* foam = m_cascades[cascade].foam.data();
+    size_t planeSize = static_cast<size_t>(m_N) * m_N;
+    for (size_t idx = 0; idx < planeSize; ++idx) {
+        mips[0].foamData[idx] = static_cast<unsigned char>(foam[idx] * 255.0f + 0.5f);
+    }
+
+    int levels = m_mipMode == MipMode::None ? 1 : m_mipLevels;
+    for (int level = 1; level < levels; ++level) {
+        const MipLevel& parent = mips[level - 1];
+        MipLevel& mip = mips[level];
+        for (int z = 0; z < mip.size; ++z) {
+            const unsigned char* r0 = parent.foamData.data() + static_cast<size_t>(2 * z) * parent.size;
+            const unsigned char* r1 = r0 + parent.size;
+            for (int x = 0; x < mip.size; ++x) {
+                int sum = r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1];
+                mip.foamData[static_cast<size_t>(z) * mip.size + x] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+void OceanFFT::updateFoamTexture() {
+    int levels = m_mipMode == MipMode::None ? 1 : m_mipLevels;
+
+    // Rows of 1-byte texels are not 4-byte aligned at the small levels
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texFoam);
+    for (int c : m_dueCascades) {
+        for (int level = 0; level < levels; ++level) {
+            const MipLevel& mip = m_cascades[c].mips[level];
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, c, mip.size, mip.size, 1,
+                            GL_RED, GL_UNSIGNED_BYTE, mip.foamData.data());
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+float OceanFFT::dispersion(float kLen, float depth) const {
+    // Finite depth: ω² = g|k| tanh(|k|d), deep water beyond |k|d ≈ π
+    float omega = std::sqrt(GRAVITY * kLen * (depth > 0.0f ? std::tanh(kLen * depth) : 1.0f));
+
+    // Looping: round down to a multiple of the loop's fundamental frequency
+    // so every component completes whole cycles per period
+    if (m_loopPeriod > 0.0f) {
+        const float PI = 3.14159265358979323846f;
+        float omega0 = 2.0f * PI / m_loopPeriod;
+        omega = std::floor(omega / omega0) * omega0;
+    }
+    return omega;
+}
+
+double OceanFFT::preciseDispersion(int nx, int nz, float L, float depth) const {
+    // Same as dispersion() but without rounding k and ω to float, which
+    // would shift the phase by ~ωt * 1e-7
+    const double TWO_PI = 6.28318530717958647692;
+    double kLen = TWO_PI / L * std::sqrt(static_cast<double>(nx) * nx + static_cast<double>(nz) * nz);
+    double omega = std::sqrt(static_cast<double>(GRAVITY) * kLen * (depth > 0.0f ? std::tanh(kLen * depth) : 1.0));
+    if (m_loopPeriod > 0.0f) {
+        double omega0 = TWO_PI / m_loopPeriod;
+        omega = std::floor(omega / omega0) * omega0;
+    }
+    return omega;
+}
+
+void OceanFFT::buildDispersionTable(Cascade& cascade) const {
+    const int halfN = m_N / 2 + 1;
+    const bool precise = cascade.desc.precision == Precision::Double;
+    cascade.omega.resize(m_spectrumSize);
+    cascade.omegaDouble.clear();
+    if (precise) cascade.omegaDouble.resize(m_spectrumSize);
+    m_threadPool->parallelFor(m_N, [&](int z) {
+        int nz = z < m_N / 2 ? z : z - m_N;
+        for (int x = 0; x < halfN; ++x) {
+            int idx = z * halfN + x;
+            glm::vec2 k = getWaveVector(x, z, cascade.desc.patchSize);
+            cascade.omega[idx] = dispersion(glm::length(k), cascade.depth);
+            if (precise) cascade.omegaDouble[idx] = preciseDispersion(x, nz, cascade.desc.patchSize, cascade.depth);
+        }
+    });
+}
+
+float OceanFFT::gaussianRandom() const {
+    // Thread-local random generator
+    static thread_local std::mt19937 generator(std::random_device{}());
+    static thread_local std::normal_distribution<float> distribution(0.0f, 1.0f);
+    return distribution(generator);
+}
+
+glm::vec2 OceanFFT::getWaveVector(int x, int z, float L) const {
+    // k = 2π * n / L, with n the signed FFT frequency of index x (or z):
+    // [0, N/2) map to themselves, [N/2, N) to negative frequencies
+    const float PI = 3.14159265358979323846f;
+    int nx = x < m_N / 2 ? x : x - m_N;
+    int nz = z < m_N / 2 ? z : z - m_N;
+    float kx = (2.0f * PI * nx) / L;
+    float kz = (2.0f * PI * nz) / L;
+    return glm::vec2(kx, kz);
+}
+
+int OceanFFT::getIndex(int x, int z) const {
+    return z * m_N + x;
+}
+
+int OceanFFT::getSpectrumIndex(int x, int z) const {
+    return z * (m_N / 2 + 1) + x;
+}
+
+void OceanFFT::allocateBuffers() {
+    size_t cascadeCount = m_cascades.size();
+    size_t planeSize = static_cast<size_t>(m_N) * m_N;
+
+    // Room for every field, the batch uses the first slots of each cascade
+    m_spectrum.assign(cascadeCount * FIELD_COUNT * m_spectrumSize, std::complex<float>(0.0f));
+    m_fields.assign(cascadeCount * FIELD_COUNT * planeSize, 0.0f);
+
+    for (Cascade& cascade : m_cascades) {
+        cascade.h0.assign(m_spectrumSize, std::complex<float>(0.0f));
+        cascade.h0Conj.assign(m_spectrumSize, std::complex<float>(0.0f));
+        cascade.velocityData.assign(planeSize * 3, 0.0f);
+        cascade.jacobian.assign(planeSize, 1.0f);
+        cascade.foam.assign(planeSize, 0.0f);
+        cascade.heightBounds[0] = cascade.heightBounds[1] = HeightPyramid();
+        cascade.activeBins.clear();
+        cascade.rowStart.assign(m_N + 1, 0);
+
+        cascade.mips.resize(m_mipLevels);
+        for (int level = 0; level < m_mipLevels; ++level) {
+            MipLevel& mip = cascade.mips[level];
+            mip.size = m_N >> level;
+            size_t texels = static_cast<size_t>(mip.size) * mip.size;
+            if (level > 0) {
+                mip.spectrum.resize(static_cast<size_t>(RENDER_FIELD_COUNT) * mip.size * (mip.size / 2 + 1));
+                mip.fields.resize(RENDER_FIELD_COUNT * texels);
+            }
+            mip.displacementData.resize(texels * 3);
+            mip.normalData.resize(texels * 3);
+            mip.foamData.resize(texels);
+        }
+    }
+}
+
+void OceanFFT::createTextures() {
+    // Immutable storage with a full mip chain; levels are filled by
+    // generateMips() rather than glGenerateMipmap
+    // Newest and previous frame of every cascade; image stores need RGBA
+    m_texDisplacement = createArrayTexture(m_compute ? GL_RGBA32F : GL_RGB32F, m_mipLevels, 2 * getCascadeCount());
+    m_texNormal = createArrayTexture(m_compute || m_normalPass ? GL_RGBA32F : GL_RGB32F, m_mipLevels,
+                                     2 * getCascadeCount());
+
+    // Optional outputs enabled before initialization (not interpolated)
+    if (m_velocityTexture) m_texVelocity = createArrayTexture(GL_RGB32F, 1, getCascadeCount());
+    if (m_jacobianEnabled) m_texFoam = createArrayTexture(GL_R8, m_mipLevels, getCascadeCount());
+
+    applyMipSampling();
+
+    std::cout << "Created displacement and normal textures (" << 2 * getCascadeCount()
+              << " layers, " << m_mipLevels << " mip levels)\n";
+}
+
+void OceanFFT::deleteTextures() {
+    for (GLuint* tex : { &m_texDisplacement, &m_texNormal, &m_texVelocity, &m_texFoam }) {
+        if (*tex) glDeleteTextures(1, tex);
+        *tex = 0;
+    }
+}
+
+GLuint OceanFFT::createArrayTexture(GLenum internalFormat, int levels, int layers) const {
+    GLuint tex = 0;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalFormat, m_N, m_N, layers);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return tex;
+}
+
+void OceanFFT::applyMipSampling() {
+    // Without a mip chain, clamp sampling to the base level
+    GLint maxLevel = m_mipMode == MipMode::None ? 0 : m_mipLevels - 1;
+    GLint minFilter = m_mipMode == MipMode::None ? GL_LINEAR : GL_LINEAR_MIPMAP_LINEAR;
+
+    for (GLuint tex : { m_texDisplacement, m_texNormal, m_texFoam }) {
+        if (!tex) continue;
+        glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, maxLevel);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, minFilter);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
 
-    std::cout << "Created displacement and normal textures\n";
-}
-
-void OceanFFT::cleanupFFTW() {
-    if (m_planHeight) fftwf_destroy_plan(m_planHeight);
-    if (m_planChoppyX) fftwf_destroy_plan(m_planChoppyX);
-    if (m_planChoppyZ) fftwf_destroy_plan(m_planChoppyZ);
-    if (m_planNormalX) fftwf_destroy_plan(m_planNormalX);
-    if (m_planNormalZ) fftwf_destroy_plan(m_planNormalZ);
-    
-    m_planHeight = nullptr;
-    m_planChoppyX = nullptr;
-    m_planChoppyZ = nullptr;
-    m_planNormalX = nullptr;
-    m_planNormalZ = nullptr;
+void OceanFFT::cleanupPlans() {
+    m_plan.reset();
+    m_mipPlans.clear();
 }
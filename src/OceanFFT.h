@@ -1,29 +1,127 @@
 #pragma once
 
+#include "FFTBackend.h"
+#include "ThreadPool.h"
+#include "WaveSpectrum.h"
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <atomic>
 #include <complex>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
 #include <vector>
-#include <fftw3.h>
+
+class ComputeSimulation;
+class NormalDerivation;
+class SurfaceReadback;
 
 /**
- * @brief FFT-based ocean wave simulation using Phillips spectrum
- * 
+ * @brief FFT-based ocean wave simulation
+ *
  * Implements Tessendorf's FFT ocean simulation:
- * 1. Generates initial spectrum h0(k) using Phillips spectrum
+ * 1. Generates initial spectrum h0(k) from a wave spectrum (Phillips or an
+ *    empirical model, see setSpectrum), optionally the sum of several wave
+ *    systems such as a wind sea and a swell (addSpectrumComponent)
  * 2. Evolves spectrum over time: h(k,t) = h0(k)*exp(iωt) + h0*(-k)*exp(-iωt)
  * 3. Performs inverse FFT to get spatial domain (height field)
  * 4. Calculates normals and choppy displacement
- * 5. Uploads to GPU as textures
+ * 5. Uploads to GPU as textures (with a full mip chain)
+ *
+ * Spectra are stored in FFTW's half-complex layout (N x (N/2+1)) and all
+ * fields go through a single batched c2r plan from the selected FFT
+ * backend (FFTW or the built-in FFT, see setFFTBackend). Only non-zero bins
+ * are evolved, optionally only those holding a significant share of the h0
+ * energy (see setSparseFraction).
+ * An optional pruned output transforms just the occupied low-frequency
+ * band into a coarse grid for far-field LOD and physics (setPrunedEnabled).
+ *
+ * Up to MAX_CASCADES cascades (patches of decreasing size, each owning a
+ * band of the spectrum) share that plan and the thread pool, and are
+ * uploaded as layers of 2D array textures that the shaders sum.
+ *
+ * A cascade may be refreshed only every few steps (updatePeriod). Refreshes
+ * are staggered so the per-step cost stays flat, and each cascade keeps its
+ * two newest frames in a pair of displacement/normal layers which the
+ * shaders blend in between (getCascadeBlend).
+ *
+ * In looping mode (setLoopPeriod) ω(k) is quantized so the surface repeats
+ * exactly; one period can then be precomputed in the background and played
+ * back from memory (buildLoopCache), leaving only the texture uploads, or
+ * kept on the GPU in full (setLoopTexturesEnabled), leaving nothing.
+ *
+ * Optional min/max height pyramids (setHeightBoundsEnabled) bound regions
+ * of the surface for view culling and accelerate ray casts (intersectRay).
+ * The surface queries (probe, sampleSurface, height bounds and ray casts)
+ * only read the simulation state and live in OceanQueries.cpp.
+ *
+ * Depth regions (setDepthRegions) simulate the cascade set once per water
+ * depth, with finite-depth dispersion ω = √(g|k| tanh(|k|d)) tabulated per
+ * cascade. All regions share the batched plan; the shaders and the CPU
+ * sampling blend them by a bathymetry map (setBathymetry), so the cost
+ * grows with the number of regions, not with the size of the map.
+ *
+ * With setGPUSimulation, evolution, FFT and packing of the displacement
+ * and normal maps run in compute shaders instead (see ComputeSimulation).
+ * With setGPUNormals only the normals move to the GPU, derived from the
+ * uploaded displacement (see NormalDerivation).
  */
 class OceanFFT {
 public:
+    /**
+     * @brief How the texture mip chain is produced each update
+     */
+    enum class MipMode {
+        None,       // Level 0 only (sampling clamped to the base level)
+        BoxFilter,  // 2x2 box filter of the spatial fields, level by level
+        Spectral    // Inverse FFT of the truncated (N/2, N/4, ...) sub-spectrum
+    };
+
+    /**
+     * @brief Reconstruction filter of sampleSurface
+     */
+    enum class SampleFilter {
+        Bilinear,
+        Bicubic     // Catmull-Rom, 4x4 texels
+    };
+
+    /**
+     * @brief Arithmetic and h0 storage of a cascade's spectrum evolution
+     *
+     * The FFT and the outputs are float in every case.
+     */
+    enum class Precision {
+        Double,     // Phase ω(k)t and evolution in double: no drift over long sessions
+        Single,     // Float: the phase error grows like ulp(ωt), ~0.01 rad after an hour
+        Compact     // Float over bfloat16 h0 (half the reads, ~0.4% amplitude error)
+    };
+
+    /**
+     * @brief One simulated patch and the spectrum band it is responsible for
+     */
+    struct CascadeDesc {
+        float patchSize;    // Physical patch size in meters
+        float kMin;         // Lowest |k| simulated by this cascade (rad/m)
+        float kMax;         // Highest |k| (exclusive), <= 0 for unbounded
+        int updatePeriod = 1;   // Simulation steps between refreshes (1 = every step)
+        Precision precision = Precision::Single;
+    };
+
+    static constexpr int MAX_CASCADES = 4;
+    static constexpr int MAX_DEPTH_REGIONS = 4;
+    static constexpr int MAX_SIMULATED_CASCADES = MAX_CASCADES * MAX_DEPTH_REGIONS;
+    static constexpr int MAX_SPECTRUM_COMPONENTS = 4;
+    static constexpr int MAX_UPDATE_PERIOD = 8;
+    static constexpr int MIN_PRUNED_SIZE = 8;
+
     /**
      * @brief Create ocean simulation
      * @param N Resolution (power of 2, e.g., 256 or 512)
      * @param L Physical patch size in meters (e.g., 1000.0)
+     * @param workerThreads Extra simulation threads (-1 = hardware threads - 1)
      */
-    OceanFFT(int N, float L);
+    OceanFFT(int N, float L, int workerThreads = -1);
     ~OceanFFT();
 
     // Non-copyable
@@ -39,99 +137,979 @@ public:
      * @brief Update simulation for given time
      * @param time Simulation time in seconds
      */
-    void update(float time);
+    void update(double time);
 
-    // Parameter setters (regenerate h0 on change)
+    // Parameter setters of the first spectrum component (regenerate its h0 contribution on change)
     void setWindSpeed(float speed);
     void setWindDirection(const glm::vec2& direction);
     void setAmplitude(float amplitude);
+
+    /**
+     * @brief Select the spectrum model and directional spreading
+     *
+     * Phillips is scaled by the amplitude; the empirical models give wave
+     * heights in metres for the wind speed (amplitude unused). The random
+     * phases are kept, so switching models reshapes the same waves.
+     */
+    void setSpectrum(const SpectrumDesc& spectrum);
+
+    /**
+     * @brief Add a wave system (e.g. a swell) to the sea state
+     *
+     * Component densities are summed per bin before the random phases are
+     * applied, so any number of systems still costs one set of FFTs per
+     * step. Each component keeps its density per cascade, so changing one
+     * re-evaluates only that component. Component 0 is the one set by
+     * setWindSpeed, setWindDirection, setAmplitude and setSpectrum.
+     * @return Index of the new component, -1 when MAX_SPECTRUM_COMPONENTS are in use
+     */
+    int addSpectrumComponent(const SpectrumComponent& component);
+
+    /**
+     * @brief Replace a component (regenerates only its contribution if changed)
+     */
+    bool setSpectrumComponent(int index, const SpectrumComponent& component);
+
+    /**
+     * @brief Remove a component (index >= 1, the first one always exists)
+     */
+    bool removeSpectrumComponent(int index);
+
     void setChoppy(float choppy);
+    void setMipMode(MipMode mode);
+
+    /**
+     * @brief Replace the cascade set (1 to MAX_CASCADES, largest patch first)
+     *
+     * The first patch size becomes the tiling period of the rendered mesh.
+     * The set is simulated once per depth region (setDepthRegions).
+     * Buffers, plans and textures are rebuilt if already initialized.
+     */
+    bool setCascades(const std::vector<CascadeDesc>& cascades);
+
+    /**
+     * @brief Build a cascade set with patch sizes L, L/4, L/16, ...
+     *
+     * Band boundaries are placed a few fundamental wavelengths above the
+     * next cascade's lowest frequency so every k is simulated exactly once.
+     * With multiRate, larger patches are refreshed less often (the smallest
+     * every step, each larger one at twice the period, up to 4 steps).
+     */
+    static std::vector<CascadeDesc> makeCascades(float L, int count, bool multiRate = false);
 
-    // Getters
+    /**
+     * @brief Simulate the cascade set once per water depth
+     *
+     * Simulated cascade r * getCascadesPerRegion() + c is cascade c of the
+     * set in region r, with ω = √(g|k| tanh(|k|d)) and, for TMA, the depth
+     * factor of that region. Regions share the random phases, so blended
+     * regions show the same waves, only refracted in time.
+     * @param depths Region depths in metres, increasing (empty: one deep-water region)
+     */
+    bool setDepthRegions(const std::vector<float>& depths);
+
+    /**
+     * @brief Water depth map that selects the regions
+     *
+     * Weights are linear in log depth between the two regions around the
+     * local depth, and clamped to the shallowest and deepest region. Without
+     * a map (or outside it) the deepest region is used.
+     * @param depths size x size depths in metres, row-major along z (empty: remove the map)
+     * @param origin World (x, z) of the first texel's corner
+     * @param extent World size covered by the map
+     */
+    bool setBathymetry(const std::vector<float>& depths, int size, const glm::vec2& origin, float extent);
+
+    /**
+     * @brief Weight of each depth region at world (x, z), summing to 1
+     * @param weights Receives getDepthRegionCount() values
+     */
+    void getRegionWeights(float x, float z, float* weights) const;
+
+    /**
+     * @brief Also produce the surface velocity ∂D/∂t (from iω·h(k,t) spectra)
+     * @param enabled Add the three velocity fields to the batched transform
+     * @param uploadTexture Additionally upload them as an RGB32F texture
+     */
+    void setVelocityEnabled(bool enabled, bool uploadTexture = false);
+
+    /**
+     * @brief Also produce the folding Jacobian and a decaying foam map
+     *
+     * Adds ∂Dx/∂x, ∂Dz/∂z and ∂Dx/∂z to the batched transform and maintains
+     * a foam coverage map uploaded as an R8 texture (getFoamTexture).
+     */
+    void setJacobianEnabled(bool enabled);
+
+    /**
+     * @brief Foam response to folding
+     * @param bias Jacobian below which foam is injected (1 = flat surface)
+     * @param decayTime Time in seconds for foam to fade to ~37%
+     */
+    void setFoamParameters(float bias, float decayTime);
+
+    /**
+     * @brief Skip spectrum bins that carry a negligible share of the energy
+     * @param fraction Largest share of the total h0 energy that may be
+     *                 dropped, weakest bins first (0, the default, keeps
+     *                 every non-zero bin)
+     */
+    void setSparseFraction(float fraction);
+
+    /**
+     * @brief Also produce a coarse, band-limited copy of the surface
+     *
+     * Per cascade, the smallest band |n| < M/2 (M a power of two, at least
+     * MIN_PRUNED_SIZE) holding all but lossFraction of the h0 energy is
+     * transformed on its own into an M x M grid covering the whole patch.
+     * @param lossFraction Largest share of the energy left out of the band
+     */
+    void setPrunedEnabled(bool enabled, float lossFraction = 0.01f);
+
+    /**
+     * @brief Looping mode: quantize ω(k) down to multiples of 2π/period
+     * @param period Loop period in seconds (0 = continuous dispersion)
+     */
+    void setLoopPeriod(float period);
+
+    /**
+     * @brief Precompute one loop period on a background thread
+     *
+     * frameCount frames evenly spaced over the period are simulated from a
+     * private copy of the current spectrum. Once all are done, update() plays
+     * them back instead of simulating, blending consecutive frames through
+     * the cascade layer pairs. Any parameter change discards the cache.
+     * Velocity and the CPU field getters are not refreshed during playback.
+     * @return false if looping mode is off or the ocean is not initialized
+     */
+    bool buildLoopCache(int frameCount);
+
+    /**
+     * @brief Stop building / playing the loop cache and resume simulating
+     */
+    void clearLoopCache();
+
+    /**
+     * @brief Keep the complete loop cache resident on the GPU
+     *
+     * Once the cache is built, every frame is uploaded once into its own
+     * texture array layers (frame * cascadeCount + c, see getLoopDisplacementTexture)
+     * and the CPU copy is released. update() then does nothing and the
+     * renderer interpolates between the frames by time. Disabling it while
+     * resident discards the cache.
+     * @param compact Store displacement and normals as RGB16F instead of RGB32F
+     */
+    void setLoopTexturesEnabled(bool enabled, bool compact = false);
+
+    /**
+     * @brief One packed frame stored outside the simulation
+     *
+     * texels holds, per cascade, every displacement level then every normal
+     * level (RGB floats, getPackedTexelCount in all); foam, if not null,
+     * every foam level per cascade (R8, getPackedFoamCount bytes). id names
+     * the frame so that layers already holding it are not uploaded again.
+     */
+    struct PackedFrame {
+        int id = -1;
+        const float* texels = nullptr;
+        const unsigned char* foam = nullptr;
+    };
+
+    /**
+     * @brief Receives simulated frames in PackedFrame layout (false stops)
+     */
+    using FrameSink = std::function<bool(int frame, const float* texels, const unsigned char* foam)>;
+
+    /**
+     * @brief Show two stored frames instead of simulating
+     *
+     * They are uploaded into the cascade layer pairs (unless resident) and
+     * blended by the shaders; foam comes from the nearer one. The frames must
+     * match the current resolution, cascade count and mip mode.
+     * @param blend Weight of next
+     */
+    void playFrames(const PackedFrame& previous, const PackedFrame& next, float blend);
+
+    /**
+     * @brief Leave frame playback; the next update() refreshes every cascade
+     */
+    void stopPlayback();
+
+    /**
+     * @brief Simulate frames at t = i * dt on a private copy of the ocean
+     *
+     * Runs on the calling thread, refreshes every cascade for every frame
+     * and leaves this ocean untouched.
+     * @return false if planning failed or the sink stopped early
+     */
+    bool simulateOffline(int frameCount, float dt, const FrameSink& sink) const;
+
+    /**
+     * @brief GL-free copy with the same spectrum that refreshes every
+     *        cascade each step (planned on this thread)
+     *
+     * The copy may then be simulated on another thread with runOffline.
+     * @param workerThreads Extra simulation threads of the copy
+     * @return nullptr if planning failed
+     */
+    std::unique_ptr<OceanFFT> createOfflineCopy(int workerThreads = 0) const;
+
+    /**
+     * @brief Simulate and pack frames at t = (i + warmup) * dt on an offline copy
+     * @param warmup Frames simulated before the first one passed to the sink
+     */
+    static bool runOffline(OceanFFT& simulator, int warmup, int frameCount, float dt, const FrameSink& sink);
+
+    /**
+     * @brief Exact surface at arbitrary points, summed directly over the evolved bins
+     *
+     * Evaluates every cascade's active spectrum bins (see setSparseFraction)
+     * at (x[i], z[i]) and time t, without the FFT grid and independently of
+     * update(). Positions are in the simulation frame, where texel (i, j) of
+     * a cascade lies at (i, j) * patchSize / N; there the results match the
+     * FFT output. Must not run concurrently with parameter changes.
+     * @param displacement Receives (dx, dy, dz) per point
+     * @param gradient If not null, receives (∂h/∂x, ∂h/∂z) per point
+     */
+    void probe(int count, const float* x, const float* z, double time,
+               glm::vec3* displacement, glm::vec2* gradient = nullptr) const;
+
+    /**
+     * @brief Per-query outputs of sampleSurface (SoA, null arrays are skipped)
+     */
+    struct SurfaceSamples {
+        float* height = nullptr;
+        float* normalX = nullptr;
+        float* normalY = nullptr;
+        float* normalZ = nullptr;
+        float* velocityX = nullptr;     // Surface velocity, needs setVelocityEnabled
+        float* velocityY = nullptr;
+        float* velocityZ = nullptr;
+    };
+
+    /**
+     * @brief Sample the surface of the last update() under a batch of points
+     *
+     * Sums the newest CPU frame of every cascade, wrapping like GL_REPEAT
+     * (same frame as probe: texel (i, j) at (i, j) * patchSize / N). Choppy
+     * waves move the surface horizontally, so the grid point that ends up at
+     * (x, z) is first found by a fixed number of iterations of
+     * p = (x, z) - D(p); heights, normals and velocities are those of that
+     * point. Batches are split over the thread pool. The fields are not
+     * refreshed while frames are played back. On the GPU path the latest
+     * readback is sampled instead (setGPUReadback; normals derived from its
+     * displacement, velocities zero); getSurfaceTime() tells its time.
+     * @param inversionIterations 0 samples at (x, z) directly
+     */
+    void sampleSurface(int count, const float* x, const float* z, const SurfaceSamples& out,
+                       SampleFilter filter = SampleFilter::Bilinear, int inversionIterations = 3) const;
+
+    /**
+     * @brief Maintain min/max height pyramids of both frames of every cascade
+     *
+     * Built from the level-0 displacement of each refreshed cascade; they
+     * back getHeightBounds and intersectRay. They do not follow frames that
+     * are played back (hasHeightBounds is false meanwhile).
+     */
+    void setHeightBoundsEnabled(bool enabled);
+
+    /**
+     * @brief Select the FFT implementation (re-plans when initialized)
+     *
+     * The built-in FFT needs no library and supports power-of-two sizes up
+     * to BuiltinFFTBackend::MAX_SIZE. Results agree to float precision.
+     * @return false if the backend is not part of this build or cannot
+     *         plan this resolution (the current one is kept)
+     */
+    bool setFFTBackend(FFTBackend::Type type);
+
+    /**
+     * @brief Evolve the spectrum inside the first FFT pass
+     *
+     * With a backend that can fuse (the built-in one), each block of
+     * spectrum columns is evaluated right before it is transformed, and
+     * each block of output rows is scaled and packed into level-0 texels
+     * right after, while both are cached. This saves several full-field
+     * passes per step; the results are the same.
+     */
+    void setFusedEvaluation(bool enabled) { m_fusedEvaluation = enabled; }
+
+    /**
+     * @brief Simulate the displacement and normal maps on the GPU (GL 4.3)
+     *
+     * h0 and ω(k) are uploaded once per spectrum change; update() then only
+     * dispatches compute shaders per due cascade, which write the texture
+     * layers directly (mips by glGenerateMipmap, also for MipMode::Spectral).
+     * The maps become RGBA32F. The CPU outputs are not produced meanwhile:
+     * fields, velocity, foam, pruned output and height bounds stay as they
+     * were (foam and height bounds report as unavailable), and evolution is
+     * float whatever the cascade precision. probe() is unaffected.
+     * @return false if compute shaders are unavailable (the CPU path is kept)
+     */
+    bool setGPUSimulation(bool enabled);
+
+    /**
+     * @brief Derive the normal maps on the GPU from the displacement maps (GL 4.3)
+     *
+     * Drops the two slope fields from the CPU transforms (5 to 3 render
+     * planes) and the normal uploads; a compute pass fills every level of
+     * the refreshed layers from the displacement instead, including the
+     * tilt from choppy displacement. The normal map becomes RGBA32F.
+     * sampleSurface derives its normals the same way, getPrunedNormals
+     * returns nullptr. Loop caches and offline runs keep spectral normals.
+     * @return false if compute shaders are unavailable (CPU normals are kept)
+     */
+    bool setGPUNormals(bool enabled);
+
+    /**
+     * @brief Read the GPU-simulated displacement back for sampleSurface
+     *
+     * After each GPU step the newest layer of every cascade is copied into
+     * a ring of pixel-pack buffers (see SurfaceReadback); finished copies
+     * are picked up by later steps without waiting, so sampleSurface and
+     * intersectRay answer from a frame one or two steps old. Its time is
+     * getSurfaceTime(), for callers that extrapolate. No effect on the CPU
+     * path, whose fields are current.
+     * @param level Mip level read back (coarser is cheaper; clamped, 0 when
+     *        mips are off)
+     */
+    void setGPUReadback(bool enabled, int level = 0);
+
+    /**
+     * @brief Simulation time of the frame sampleSurface answers from
+     *
+     * The last update() on the CPU path; on the GPU path the time of the
+     * latest readback, or -1 before one has arrived.
+     */
+    double getSurfaceTime() const;
+
+    /**
+     * @brief Conservative height range of the surface points starting in a region
+     *
+     * Sums over the cascades the range of every bilinear cell the region
+     * touches (simulation frame, as for probe), in both frames of each pair.
+     * Choppy waves move those points horizontally within
+     * getHorizontalDisplacementRange().
+     * @return (min, max), unbounded without height bounds
+     */
+    glm::vec2 getHeightBounds(float xMin, float zMin, float xMax, float zMax) const;
+
+    /**
+     * @brief (min dx, max dx, min dz, max dz) over the surface, zero without height bounds
+     */
+    glm::vec4 getHorizontalDisplacementRange() const;
+
+    /**
+     * @brief First point where a ray meets the surface of the last update()
+     *
+     * Descends the height pyramids from whole patches down to the finest
+     * texel, skipping the nodes the ray passes above, then refines inside
+     * the remaining cells against the bilinear surface of sampleSurface.
+     * Rays starting below the surface hit at distance 0.
+     * @param direction Any length
+     * @param distance Receives the distance to the hit along the normalized direction
+     * @return false on a miss within maxDistance or without height bounds
+     */
+    bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                      float& distance) const;
+
+    // Getters (textures are GL_TEXTURE_2D_ARRAY, see getCascadeLayer)
     GLuint getDisplacementTexture() const { return m_texDisplacement; }
     GLuint getNormalTexture() const { return m_texNormal; }
+    GLuint getVelocityTexture() const { return m_texVelocity; }
+    GLuint getFoamTexture() const { return usesGPUSimulation() ? 0 : m_texFoam; }   // 0 when not refreshed
     int getResolution() const { return m_N; }
-    float getPatchSize() const { return m_L; }
-    float getWindSpeed() const { return m_windSpeed; }
-    glm::vec2 getWindDirection() const { return m_windDirection; }
-    float getAmplitude() const { return m_amplitude; }
+    float getPatchSize() const { return m_cascades[0].desc.patchSize; }
+    int getCascadeCount() const { return static_cast<int>(m_cascades.size()); }
+    const CascadeDesc& getCascade(int cascade) const { return m_cascades[cascade].desc; }
+    int getDepthRegionCount() const { return m_regionDepths.empty() ? 1 : static_cast<int>(m_regionDepths.size()); }
+    const std::vector<float>& getDepthRegions() const { return m_regionDepths; }
+    int getCascadesPerRegion() const { return static_cast<int>(m_baseCascades.size()); }
+    int getCascadeRegion(int cascade) const { return cascade / getCascadesPerRegion(); }
+    float getCascadeDepth(int cascade) const { return m_cascades[cascade].depth; }    // 0 = deep water
+    GLuint getBathymetryTexture() const { return m_texBathymetry; }  // R = depth, 0 without a map
+    glm::vec2 getBathymetryOrigin() const { return m_bathymetryOrigin; }
+    float getBathymetryExtent() const { return m_bathymetryExtent; }
+    float getWindSpeed() const { return m_components[0].windSpeed; }
+    glm::vec2 getWindDirection() const { return m_components[0].windDirection; }
+    float getAmplitude() const { return m_components[0].amplitude; }
+    const SpectrumDesc& getSpectrum() const { return m_components[0].spectrum; }
+    int getSpectrumComponentCount() const { return static_cast<int>(m_components.size()); }
+    const SpectrumComponent& getSpectrumComponent(int index) const { return m_components[index]; }
     float getChoppy() const { return m_choppy; }
+    MipMode getMipMode() const { return m_mipMode; }
+    int getMipLevelCount() const { return m_mipLevels; }
+    bool isVelocityEnabled() const { return m_velocityEnabled; }
+    bool isJacobianEnabled() const { return m_jacobianEnabled; }
+    float getFoamBias() const { return m_foamBias; }
+    float getFoamDecayTime() const { return m_foamDecayTime; }
+    float getSparseFraction() const { return m_sparseFraction; }
+    float getLoopPeriod() const { return m_loopPeriod; }
+    float getLoopCacheProgress() const;             // Share of the cached frames computed
+    bool isPlayingLoop() const { return (m_playing || isLoopResident()) && m_loopCache; }
+    bool isLoopTexturesEnabled() const { return m_loopTextures; }
+    bool isLoopTexturesCompact() const { return m_loopTexturesCompact; }
+    bool isLoopResident() const { return m_loopCache && m_loopCache->resident; }
+    int getLoopFrameCount() const { return m_loopCache ? m_loopCache->frameCount : 0; }
+    bool isPlayingBack() const { return m_playing; }
+    bool isHeightBoundsEnabled() const { return m_heightBounds; }
+    bool hasHeightBounds() const;                   // Pyramids match the frames shown
+    FFTBackend::Type getFFTBackend() const { return m_fftBackendType; }
+    bool isFusedEvaluationEnabled() const { return m_fusedEvaluation; }
+    bool usesFusedEvaluation() const;               // Enabled and supported by the plan
+    bool isGPUSimulationEnabled() const { return m_gpuSimulation; }
+    bool usesGPUSimulation() const { return m_compute != nullptr; }    // Enabled and initialized
+    bool isGPUNormalsEnabled() const { return m_gpuNormals; }
+    bool usesGPUNormals() const { return m_normalPass != nullptr; }     // Enabled and initialized
+    bool isGPUReadbackEnabled() const { return m_readbackEnabled; }
+    int getGPUReadbackLevel() const { return m_readbackLevel; }
+    size_t getPackedTexelCount() const;             // Floats per PackedFrame
+    size_t getPackedFoamCount() const;              // Foam bytes per PackedFrame (0 without foam)
+    int getActiveBinCount() const;                  // Evolved bins over all cascades
+    int getTotalBinCount() const { return getCascadeCount() * m_spectrumSize; }
+    float getRetainedEnergy() const;                // Share of h0 energy in evolved bins
+    ThreadPool& getThreadPool() { return *m_threadPool; }
+
+    /**
+     * @brief Texture layer holding the newest frame of a cascade
+     *
+     * Displacement and normal arrays have two layers per cascade (2c, 2c+1);
+     * the other one of the pair holds the previous frame.
+     */
+    int getCascadeLayer(int cascade) const { return 2 * cascade + m_cascades[cascade].newestSlot; }
+
+    /**
+     * @brief Resident loop frames (0 unless isLoopResident)
+     *
+     * Layer frame * getCascadeCount() + c holds cascade c of a frame; frame
+     * i shows t = i * getLoopPeriod() / getLoopFrameCount().
+     */
+    GLuint getLoopDisplacementTexture() const { return isLoopResident() ? m_loopCache->texDisplacement : 0; }
+    GLuint getLoopNormalTexture() const { return isLoopResident() ? m_loopCache->texNormal : 0; }
+    GLuint getLoopFoamTexture() const { return isLoopResident() ? m_loopCache->texFoam : 0; }
+
+    /**
+     * @brief Weight of the newest frame when blending with the previous one
+     */
+    float getCascadeBlend(int cascade) const;
+
+    /**
+     * @brief Number of cascades refreshed by the last update()
+     */
+    int getUpdatedCascadeCount() const { return static_cast<int>(m_dueCascades.size()); }
+
+    /**
+     * @brief CPU velocity fields (N*N, row-major, same grid as the textures)
+     * @return nullptr while velocity output is disabled
+     */
+    const float* getVelocityX(int cascade = 0) const { return fieldData(cascade, FIELD_VELOCITY_X); }
+    const float* getVelocityY(int cascade = 0) const { return fieldData(cascade, FIELD_VELOCITY_Y); }
+    const float* getVelocityZ(int cascade = 0) const { return fieldData(cascade, FIELD_VELOCITY_Z); }
+
+    /**
+     * @brief Jacobian determinant and foam coverage [0,1] (N*N, row-major)
+     * @return nullptr while the Jacobian output is disabled
+     */
+    const float* getJacobian(int cascade = 0) const {
+        return m_jacobianEnabled ? m_cascades[cascade].jacobian.data() : nullptr;
+    }
+    /**
+     * @brief Pruned output of a cascade (M*M, row-major, texel i at i*L/M)
+     * @return nullptr while the pruned output is disabled
+     */
+    int getPrunedResolution(int cascade = 0) const { return m_cascades[cascade].pruned.size; }
+    const float* getPrunedDisplacement(int cascade = 0) const {
+        return m_prunedEnabled ? m_cascades[cascade].pruned.displacementData.data() : nullptr;
+    }
+    const float* getPrunedNormals(int cascade = 0) const {
+        return m_prunedEnabled && !usesGPUNormals() ? m_cascades[cascade].pruned.normalData.data() : nullptr;
+    }
+    bool isPrunedEnabled() const { return m_prunedEnabled; }
+
+    const float* getFoamCoverage(int cascade = 0) const {
+        return m_jacobianEnabled ? m_cascades[cascade].foam.data() : nullptr;
+    }
 
 private:
+    /**
+     * @brief Spectral/spatial fields transformed together by the batched plan
+     *
+     * The render fields always occupy the first batch slots; optional
+     * fields are appended behind them only while enabled.
+     */
+    enum Field {
+        FIELD_HEIGHT = 0,   // Y displacement
+        FIELD_CHOPPY_X,     // X displacement
+        FIELD_CHOPPY_Z,     // Z displacement
+        FIELD_NORMAL_X,     // ∂h/∂x
+        FIELD_NORMAL_Z,     // ∂h/∂z
+        RENDER_FIELD_COUNT,
+        FIELD_VELOCITY_X = RENDER_FIELD_COUNT,  // ∂Dx/∂t
+        FIELD_VELOCITY_Y,   // ∂h/∂t
+        FIELD_VELOCITY_Z,   // ∂Dz/∂t
+        FIELD_JACOBIAN_XX,  // ∂Dx/∂x
+        FIELD_JACOBIAN_ZZ,  // ∂Dz/∂z
+        FIELD_JACOBIAN_XZ,  // ∂Dx/∂z (= ∂Dz/∂x)
+        FIELD_COUNT
+    };
+
+    /**
+     * @brief Per-level buffers of the mip chain (level 0 uses the main buffers)
+     */
+    struct MipLevel {
+        int size = 0;                                   // Texels per side
+        std::vector<std::complex<float>> spectrum;      // Truncated half-complex spectra
+        std::vector<float> fields;                      // RENDER_FIELD_COUNT planes of size²
+        std::vector<float> displacementData;            // Packed RGB texels
+        std::vector<float> normalData;                  // Packed RGB texels
+        std::vector<unsigned char> foamData;            // R8 foam coverage
+    };
+
+    /**
+     * @brief Active bins of a cascade laid out for probe() (SoA, row-major)
+     *
+     * Amplitudes include the inverse FFT normalization and the weight of
+     * the conjugate half that the c2r layout leaves implicit.
+     */
+    struct ProbeBins {
+        std::vector<int> column;                    // nx + N/2
+        std::vector<int> row;                       // nz + N/2
+        std::vector<float> unitX;                   // kx / |k| (0 at k = 0)
+        std::vector<float> unitZ;
+        std::vector<float> kx;
+        std::vector<float> kz;
+        std::vector<float> omega;                   // ω(k)
+        std::vector<double> omegaDouble;            // ω(k) in double (Precision::Double)
+        std::vector<std::complex<float>> h0;        // Weighted h0(k)
+        std::vector<std::complex<float>> h0Conj;    // Weighted h0*(-k)
+    };
+
+    /**
+     * @brief Min/max pyramid over the heights of one frame
+     *
+     * Level 0 holds the (min, max) of each bilinear cell (texels i..i+1,
+     * wrapping), every further level that of 2x2 cells below, down to a
+     * single cell covering the patch.
+     */
+    struct HeightPyramid {
+        std::vector<std::vector<glm::vec2>> levels;
+        glm::vec4 horizontal{ 0.0f };   // (min dx, max dx, min dz, max dz)
+    };
+
+    /**
+     * @brief Per-cascade spectrum and CPU-side outputs
+     */
+    struct Cascade {
+        CascadeDesc desc;
+        float depth = 0.0f;                         // Water depth of its region, 0 = deep
+        std::vector<float> omega;                   // ω(k) per spectrum bin, depth and loop quantization applied
+        std::vector<double> omegaDouble;            // The same in double (Precision::Double only)
+        std::vector<std::complex<float>> h0;        // Initial spectrum h0(k)
+        std::vector<std::complex<float>> h0Conj;    // Conjugate h0*(-k)
+        std::vector<std::complex<float>> noise;     // Gaussian draw per FFT-ordered bin, kept across regenerations
+        std::vector<std::vector<float>> variance;   // Per spectrum component: h0 variance per FFT-ordered bin
+        std::vector<uint16_t> h0Compact;            // bfloat16 (h0, h0Conj) per bin (Precision::Compact)
+        std::vector<MipLevel> mips;                 // Packed texels per level
+        MipLevel pruned;                            // Band-limited coarse output
+        int prunedLevel = 0;                        // Its size as a level (N >> level)
+        std::vector<float> velocityData;            // Packed RGB texels for m_texVelocity
+        std::vector<float> jacobian;                // Jacobian determinant J
+        std::vector<float> foam;                    // Foam coverage, accumulated and decayed
+        HeightPyramid heightBounds[2];              // Per layer of the pair (setHeightBoundsEnabled)
+
+        // Sparse evaluation (rebuilt with h0)
+        std::vector<int> activeBins;    // Spectrum indices of the evolved bins, row-major
+        std::vector<int> rowStart;      // First activeBins entry of each row (N + 1 entries)
+        std::vector<int> columnBins;    // The same bins column-major (fused evaluation)
+        std::vector<int> columnStart;   // First columnBins entry of each column (N/2 + 2 entries)
+        ProbeBins probeBins;            // Active bins for probe()
+        double totalEnergy = 0.0;       // Σ|h0|² over all bins
+        double retainedEnergy = 0.0;    // Σ|h0|² over the active bins
+
+        // Refresh schedule
+        int phase = 0;              // Step offset of the refreshes within the period
+        int stepsSinceUpdate = 0;   // Steps since the newest frame was computed
+        int newestSlot = 0;         // Layer of the pair holding the newest frame
+        bool valid = false;         // Both layers hold a frame
+        double lastTime = 0.0;      // Time of the newest frame (foam decay)
+    };
+
+    /**
+     * @brief Precomputed loop frames and the thread producing them
+     *
+     * The worker only touches the simulator and frames; frames become
+     * readable once framesDone reaches frameCount.
+     */
+    struct LoopCache {
+        int frameCount = 0;
+        std::vector<std::vector<float>> texels;         // Per frame, PackedFrame layout
+        std::vector<std::vector<unsigned char>> foam;
+        std::unique_ptr<OceanFFT> simulator;            // GL-free copy of the ocean
+        std::atomic<int> framesDone{0};
+        std::atomic<bool> cancel{false};
+        std::thread worker;
+
+        // GPU-resident frames (setLoopTexturesEnabled)
+        bool resident = false;
+        bool residentFailed = false;    // Upload failed, play from memory
+        GLuint texDisplacement = 0;
+        GLuint texNormal = 0;
+        GLuint texFoam = 0;
+    };
+
     // Simulation parameters
     int m_N;                    // Resolution (e.g., 256)
-    float m_L;                  // Patch size in meters
-    float m_windSpeed;          // Wind speed in m/s
-    glm::vec2 m_windDirection;  // Normalized wind direction
-    float m_amplitude;          // Wave amplitude multiplier (A)
+    std::vector<SpectrumComponent> m_components;   // Wave systems of the sea state, [0] the local wind sea
+    std::vector<float> m_regionDepths;      // Depth per region, increasing (empty: one deep region)
+    std::vector<float> m_bathymetry;        // Depth map, m_bathymetrySize² texels
+    int m_bathymetrySize;
+    glm::vec2 m_bathymetryOrigin;
+    float m_bathymetryExtent;
+    std::vector<float> m_gridRadius;        // |n| per FFT-ordered bin, |k| = 2π|n|/L
+    std::vector<float> m_gridAngle;         // atan2(nz, nx) per FFT-ordered bin
     float m_choppy;             // Choppiness factor
+    MipMode m_mipMode;          // Mip chain generation method
+    int m_mipLevels;            // log2(N) + 1
+    bool m_velocityEnabled;     // Velocity fields are part of the batch
+    bool m_velocityTexture;     // ... and are uploaded to m_texVelocity
+    bool m_jacobianEnabled;     // Jacobian fields are part of the batch
+    float m_foamBias;           // Foam appears where J < bias
+    float m_foamDecayTime;      // Foam e-folding time in seconds
+    float m_sparseFraction;     // Share of h0 energy that compaction may drop
+    bool m_prunedEnabled;       // Coarse band-limited output is produced
+    float m_prunedLoss;         // Share of h0 energy the pruned band may leave out
+    float m_loopPeriod;         // Looping period in seconds, 0 when not looping
+    bool m_loopTextures;        // Complete loop caches move to the GPU
+    bool m_loopTexturesCompact; // ... as RGB16F
+    bool m_heightBounds;        // Height pyramids are built with each refresh
+    bool m_fusedEvaluation;     // Spectrum evolved inside the FFT when the plan can fuse
+    bool m_gpuSimulation;       // Maps simulated by compute shaders (when supported)
+    bool m_computeSpectrumDirty;    // h0 or ω(k) changed since the last upload
+    bool m_gpuNormals;          // Normal maps derived from displacement on the GPU (when supported)
+    bool m_readbackEnabled;     // GPU-path displacement copied back for sampleSurface
+    int m_readbackLevel;        // ... at this mip level
+    bool m_playing;             // Layers hold stored frames instead of simulated ones
+    float m_playBlend;          // Weight of the later of the two shown frames
+    int m_playSlotFrame[2];     // Frame id held by each layer of the pairs
+    int m_playFoamFrame;        // Frame id held by the foam layers
+    int m_step;                 // Simulation steps since the cascade set changed
+    bool m_initialized;
 
     // Physics constants
     static constexpr float GRAVITY = 9.81f;  // m/s²
 
-    // FFTW data structures
-    fftwf_plan m_planHeight;     // FFT plan for height displacement
-    fftwf_plan m_planChoppyX;    // FFT plan for X choppy displacement
-    fftwf_plan m_planChoppyZ;    // FFT plan for Z choppy displacement
-    fftwf_plan m_planNormalX;    // FFT plan for normal X component
-    fftwf_plan m_planNormalZ;    // FFT plan for normal Z component
-
-    // Spectrum data (frequency domain)
-    std::vector<std::complex<float>> m_h0;          // Initial spectrum h0(k)
-    std::vector<std::complex<float>> m_h0Conj;      // Conjugate h0*(-k)
-    std::vector<std::complex<float>> m_htilde;      // Time-evolved h(k,t)
-    std::vector<std::complex<float>> m_htildeChoppyX;
-    std::vector<std::complex<float>> m_htildeChoppyZ;
-    std::vector<std::complex<float>> m_htildeNormalX;
-    std::vector<std::complex<float>> m_htildeNormalZ;
-
-    // Spatial domain data (output of FFT)
-    std::vector<float> m_heightField;    // Y displacement
-    std::vector<float> m_choppyX;        // X displacement
-    std::vector<float> m_choppyZ;        // Z displacement
-    std::vector<float> m_normalX;        // Normal X component
-    std::vector<float> m_normalZ;        // Normal Z component
-
-    // OpenGL textures
-    GLuint m_texDisplacement;    // RGB = (dx, dy, dz)
-    GLuint m_texNormal;          // RGB = (nx, ny, nz)
+    // Shared by all cascades
+    std::unique_ptr<ThreadPool> m_threadPool;
+
+    // FFT plans (planned on cascade 0, executed on every cascade's buffers)
+    FFTBackend::Type m_fftBackendType;
+    std::unique_ptr<FFTBackend> m_fftBackend;
+    std::unique_ptr<FFTPlan> m_plan;                    // Batched c2r plan over the active fields
+    std::vector<std::unique_ptr<FFTPlan>> m_mipPlans;   // Per mip level, batch of getRenderFieldCount()
+    int m_fieldSlot[FIELD_COUNT];       // Batch slot per field, -1 when inactive
+    int m_activeFields;                 // Number of slots in the batch
+
+    // Spectrum data (frequency domain, half-complex layout)
+    int m_spectrumSize;                             // N * (N/2 + 1)
+    std::vector<Cascade> m_cascades;                // Region-major, getCascadesPerRegion() per region
+    std::vector<CascadeDesc> m_baseCascades;        // The set given to setCascades
+    std::vector<int> m_dueCascades;                 // Cascades refreshed by the current step
+    std::unique_ptr<LoopCache> m_loopCache;
+
+    // Time-evolved spectra and FFT output of every cascade, each cascade
+    // owning FIELD_COUNT consecutive planes (the batch uses the first slots)
+    std::vector<std::complex<float>> m_spectrum;
+    std::vector<float> m_fields;
+
+    // GPU simulation (setGPUSimulation), null on the CPU path
+    std::unique_ptr<ComputeSimulation> m_compute;
+
+    // GPU normals (setGPUNormals), null while the CPU transforms the slopes
+    std::unique_ptr<NormalDerivation> m_normalPass;
+
+    // Readback ring of the GPU path (setGPUReadback), created on first use
+    std::unique_ptr<SurfaceReadback> m_readback;
+
+    // OpenGL textures (2D arrays)
+    GLuint m_texDisplacement;    // RGB = (dx, dy, dz), newest/previous layer pair per cascade (RGBA on the GPU path)
+    GLuint m_texNormal;          // RGB = (nx, ny, nz), newest/previous layer pair per cascade (RGBA when written on the GPU)
+    GLuint m_texVelocity;        // RGB = ∂D/∂t (optional), one layer per cascade
+    GLuint m_texFoam;            // R = foam coverage (optional, mip-mapped), one layer per cascade
+    GLuint m_texBathymetry;      // R = water depth (setBathymetry)
 
     // Helper methods
 
     /**
-     * @brief Generate initial spectrum h0(k) using Phillips spectrum
+     * @brief Create the batched and spectral mip FFT plans
+     */
+    bool createPlans();
+
+    /**
+     * @brief CPU part of update(): evaluate, transform, mips and foam
+     */
+    void simulate(double time);
+
+    /**
+     * @brief Pick the cascades refreshed by this step into m_dueCascades
+     */
+    void selectDueCascades();
+
+    /**
+     * @brief update() on the GPU path: dispatch the due cascades into their layers
+     */
+    void simulateCompute(double time);
+
+    /**
+     * @brief (Re)create the compute simulation for the cascade set
+     * @return false if it is unavailable (m_compute stays null)
+     */
+    bool createComputeSimulation();
+
+    /**
+     * @brief Create the normal derivation pass
+     * @return false if it is unavailable (m_normalPass stays null)
+     */
+    bool createNormalPass();
+
+    /**
+     * @brief Collect finished readbacks and queue this step's frame
+     */
+    void readBackSurface(double time);
+
+    /**
+     * @brief The latest readback, when the GPU path has one to sample
+     */
+    const SurfaceReadback* getSampledReadback() const;
+
+    /**
+     * @brief Upload the active h0 bins and ω(k) of every cascade
+     */
+    void uploadComputeSpectrum();
+
+    /**
+     * @brief Render fields the CPU transforms: all, or the displacement with GPU normals
+     */
+    int getRenderFieldCount() const { return m_normalPass ? FIELD_NORMAL_X : RENDER_FIELD_COUNT; }
+
+    /**
+     * @brief Pack the newest mip data of every cascade in PackedFrame layout
+     */
+    void packFrame(std::vector<float>& texels, std::vector<unsigned char>& foam) const;
+
+    /**
+     * @brief Show the cached frames around a time
+     */
+    void playLoop(double time);
+
+    /**
+     * @brief Upload one packed frame into one layer of every cascade pair
+     */
+    void uploadFrame(const float* texels, int slot);
+
+    /**
+     * @brief Upload every cached frame into the loop textures, then free the CPU copy
+     * @return false if the textures could not be created (the cache is kept)
+     */
+    bool uploadLoopTextures();
+
+    /**
+     * @brief Delete the loop textures of the cache
+     */
+    void deleteLoopTextures();
+
+    /**
+     * @brief Re-evaluate one spectrum component and rebuild h0 (all of it
+     *        when the per-component variances do not exist yet)
+     */
+    void regenerateComponent(int component);
+
+    /**
+     * @brief Variance of one spectrum component over the full grid of a cascade
+     */
+    void evaluateComponent(Cascade& cascade, int component);
+
+    /**
+     * @brief h0 from the noise and the summed component variances
+     */
+    void combineComponents(Cascade& cascade);
+
+    /**
+     * @brief Generate initial spectrum h0(k) from every spectrum component
      */
     void generateH0();
 
     /**
-     * @brief Evaluate wave spectrum at given time
+     * @brief Rebuild each cascade's active bin list from h0
+     */
+    void compactSpectrum();
+
+    /**
+     * @brief Lay out a cascade's active bins for probe()
+     */
+    void buildProbeBins(Cascade& cascade) const;
+
+    /**
+     * @brief sampleSurface for queries [begin, end) with a Taps x Taps filter
+     */
+    template <int Taps>
+    void sampleSurfaceRange(int begin, int end, const float* x, const float* z,
+                            const SurfaceSamples& out, int inversionIterations) const;
+
+    /**
+     * @brief Build the height pyramid of a cascade's newest CPU frame into a slot
+     */
+    void buildHeightPyramid(int cascade, int slot);
+
+    /**
+     * @brief Height range of the cells of one pyramid touched by a region
+     */
+    glm::vec2 pyramidBounds(const HeightPyramid& pyramid, float patchSize,
+                            float xMin, float zMin, float xMax, float zMax) const;
+
+    /**
+     * @brief pyramidBounds summed over the cascades (newest frames, or both)
+     */
+    glm::vec2 surfaceBounds(float xMin, float zMin, float xMax, float zMax, bool bothFrames) const;
+
+    /**
+     * @brief Pick each cascade's pruned band from the h0 energy distribution
+     */
+    void choosePrunedBands();
+
+    /**
+     * @brief Spread the cascades' refresh phases to balance per-step cost
+     */
+    void scheduleCascades();
+
+    /**
+     * @brief Evaluate wave spectrum at given time (due cascades only)
      * @param t Time in seconds
      */
-    void evaluateWaves(float t);
+    void evaluateWaves(double t);
+
+    /**
+     * @brief Evaluate one spectrum row (fixed z) of one cascade
+     */
+    void evaluateRow(int cascade, int z, double t);
+
+    /**
+     * @brief Evolve one active bin; store(field, value) receives every enabled field
+     * @tparam Policy Arithmetic and h0 storage (one per Precision)
+     */
+    template <typename Policy, typename Store>
+    void evolveBin(const Cascade& state, int x, int z, int idx, double t, const Store& store) const;
+
+    /**
+     * @brief Evaluate, gather and transform the due cascades in fused blocks
+     *
+     * Replaces evaluateWaves, the sub-spectrum gathers, executeFFT and the
+     * level-0 packing (see setFusedEvaluation).
+     */
+    void transformFused(double t);
+
+    /**
+     * @brief Column source of a fused transform: evolve columns [x0, x0 + count)
+     *        into the plan's lane arrays and gather their share of the sub-spectra
+     */
+    void evaluateColumns(int cascade, int x0, int count, int lanes, float* re, float* im, double t);
 
     /**
      * @brief Execute FFT transforms
      */
     void executeFFT();
 
+    /**
+     * @brief Assign batch slots to the enabled fields and rebuild the plan
+     */
+    bool updateFieldLayout();
+
+    /**
+     * @brief Output scale of a field (FFT normalization and choppiness)
+     */
+    float fieldScale(Field f) const;
+
+    /**
+     * @brief Copy the truncated sub-spectra of the spectral mip levels
+     *
+     * Must run before executeFFT: multi-dimensional c2r transforms
+     * overwrite their input.
+     * @param fetch fetch(field, x, z) returns the evolved bin (x, z)
+     */
+    template <typename Fetch>
+    void gatherMipSpectra(int cascade, int xBegin, int xEnd, const Fetch& fetch);
+
+    /**
+     * @brief Copy the band |n| < M/2 of columns [xBegin, xEnd) into dst
+     * @param level Size of the band as a mip level (M = N >> level)
+     * @param shift Phase shift per unit frequency (texel centre offset)
+     */
+    template <typename Fetch>
+    void gatherSubSpectrum(int level, float shift, MipLevel& dst, int xBegin, int xEnd, const Fetch& fetch) const;
+
+    /**
+     * @brief Transform and pack the pruned band of one cascade
+     */
+    void generatePruned(int cascade);
+
+    /**
+     * @brief Fill mip levels 1..n of one cascade according to the mip mode
+     *
+     * Level 0 must be packed already.
+     */
+    void generateMips(int cascade);
+
     /**
      * @brief Update OpenGL textures with FFT results
      */
     void updateTextures();
 
     /**
-     * @brief Phillips spectrum function
-     * @param k Wave vector
-     * @return Spectrum amplitude
+     * @brief Pack spatial fields of one level into RGB displacement/normal texels
      */
-    float phillipsSpectrum(const glm::vec2& k) const;
+    void packLevel(const float* fields, int size, MipLevel& level) const;
 
     /**
-     * @brief Dispersion relation: ω(k) = sqrt(g|k|)
-     * @param k Wave vector
+     * @brief Pack rows [rowBegin, rowEnd) of one level
+     */
+    void packRows(const float* fields, int size, int rowBegin, int rowEnd, MipLevel& level) const;
+
+    /**
+     * @brief Dispersion relation: ω(k) = sqrt(g|k| tanh(|k|d)), quantized in looping mode
+     * @param kLen |k|
+     * @param depth Water depth d, <= 0 for deep water (tanh = 1)
      * @return Angular frequency
      */
-    float dispersion(const glm::vec2& k) const;
+    float dispersion(float kLen, float depth) const;
+
+    /**
+     * @brief dispersion() evaluated in double (Precision::Double)
+     * @param nx, nz Signed frequency indices of k
+     */
+    double preciseDispersion(int nx, int nz, float L, float depth) const;
+
+    /**
+     * @brief Tabulate ω of every stored bin of a cascade (Cascade::omega,
+     *        and Cascade::omegaDouble for double precision)
+     *
+     * Built when the cascades, their depths or the loop period change;
+     * spectrum regenerations keep the tables.
+     */
+    void buildDispersionTable(Cascade& cascade) const;
+
+    /**
+     * @brief Expand m_baseCascades over the depth regions into m_cascades
+     */
+    void expandDepthRegions();
+
+    /**
+     * @brief Region weights for a water depth (see setBathymetry)
+     */
+    void regionWeights(float depth, float* weights) const;
+
+    /**
+     * @brief Create or replace m_texBathymetry from m_bathymetry
+     */
+    void uploadBathymetry();
 
     /**
      * @brief Generate Gaussian random number (Box-Muller)
@@ -140,22 +1118,87 @@ private:
     float gaussianRandom() const;
 
     /**
-     * @brief Get wave vector k for grid position (x, z)
+     * @brief Get wave vector k for FFT-ordered grid position (x, z)
+     * @param L Patch size of the cascade
      */
-    glm::vec2 getWaveVector(int x, int z) const;
+    glm::vec2 getWaveVector(int x, int z, float L) const;
 
     /**
-     * @brief Get array index for grid position (x, z)
+     * @brief Get array index for spatial grid position (x, z)
      */
     int getIndex(int x, int z) const;
 
+    /**
+     * @brief Get half-complex spectrum index for frequency bin (x, z), x <= N/2
+     */
+    int getSpectrumIndex(int x, int z) const;
+
+    /**
+     * @brief Pointer to one spatial field plane of a cascade
+     */
+    float* field(int cascade, Field f) {
+        return m_fields.data() + (static_cast<size_t>(cascade) * FIELD_COUNT + m_fieldSlot[f]) * m_N * m_N;
+    }
+    const float* fieldData(int cascade, Field f) const {
+        if (m_fieldSlot[f] < 0) return nullptr;
+        return m_fields.data() + (static_cast<size_t>(cascade) * FIELD_COUNT + m_fieldSlot[f]) * m_N * m_N;
+    }
+
+    /**
+     * @brief Pointer to one spectrum plane of a cascade
+     */
+    std::complex<float>* spectrum(int cascade, Field f) {
+        return m_spectrum.data() + (static_cast<size_t>(cascade) * FIELD_COUNT + m_fieldSlot[f]) * m_spectrumSize;
+    }
+
+    /**
+     * @brief Allocate per-cascade and shared buffers for the cascade set
+     */
+    void allocateBuffers();
+
     /**
      * @brief Create OpenGL textures
      */
     void createTextures();
 
     /**
-     * @brief Clean up FFTW resources
+     * @brief Delete all OpenGL textures
+     */
+    void deleteTextures();
+
+    /**
+     * @brief Create one 2D array texture (a layer per cascade, or per frame and cascade)
+     */
+    GLuint createArrayTexture(GLenum internalFormat, int levels, int layers) const;
+
+    /**
+     * @brief Apply min filter / max level for the current mip mode
+     */
+    void applyMipSampling();
+
+    /**
+     * @brief Pack and upload the velocity fields to m_texVelocity
+     */
+    void updateVelocityTexture();
+
+    /**
+     * @brief Compute J from the Jacobian fields and advance the foam map
+     * @param dt Time since the previous update in seconds
+     */
+    void updateFoam(int cascade, float dt);
+
+    /**
+     * @brief Quantize and mip one cascade's foam map
+     */
+    void packFoam(int cascade);
+
+    /**
+     * @brief Upload the packed foam maps to m_texFoam
+     */
+    void updateFoamTexture();
+
+    /**
+     * @brief Release the FFT plans
      */
-    void cleanupFFTW();
+    void cleanupPlans();
 };
@@ -0,0 +1,597 @@
+#include "OceanFFT.h"
+#include "SurfaceReadback.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OCEANFFT_HAS_SSE 1
+#endif
+
+// Surface queries of OceanFFT: point probes, batched sampling of the
+// displacement maps and the height pyramids with their ray casts
+
+namespace {
+
+/**
+ * @brief Filter taps and weights along one axis of a periodic grid
+ *
+ * u is in texels (texel i at u = i); Taps is 2 (linear) or 4 (Catmull-Rom).
+ */
+template <int Taps>
+void filterTaps(float u, int mask, int* index, float* weight) {
+    // Truncate and fix up negatives (std::floor is a library call without SSE4.1)
+    int cell = static_cast<int>(u);
+    cell -= u < static_cast<float>(cell) ? 1 : 0;
+    float f = u - static_cast<float>(cell);
+    int first = cell - (Taps == 4 ? 1 : 0);
+    for (int t = 0; t < Taps; ++t) index[t] = (first + t) & mask;
+    if (Taps == 2) {
+        weight[0] = 1.0f - f;
+        weight[1] = f;
+    } else {
+        float f2 = f * f;
+        float f3 = f2 * f;
+        weight[0] = 0.5f * (-f3 + 2.0f * f2 - f);
+        weight[1] = 0.5f * (3.0f * f3 - 5.0f * f2 + 2.0f);
+        weight[2] = 0.5f * (-3.0f * f3 + 4.0f * f2 + f);
+        weight[3] = 0.5f * (f3 - f2);
+    }
+}
+
+/**
+ * @brief Accumulate a filtered sample of Channels (1 or 3) floats per texel, stride floats apart
+ */
+template <int Taps, int Channels>
+void accumulateSample(const float* texels, int stride, int size, const int* columns, const float* wu,
+                      const int* rows, const float* wv, float* out) {
+    // Channels written out so -O2 keeps the sums in registers
+    for (int j = 0; j < Taps; ++j) {
+        const float* row = texels + static_cast<size_t>(rows[j]) * size * stride;
+        for (int i = 0; i < Taps; ++i) {
+            const float* texel = row + static_cast<size_t>(columns[i]) * stride;
+            float w = wu[i] * wv[j];
+            out[0] += w * texel[0];
+            if constexpr (Channels == 3) {
+                out[1] += w * texel[1];
+                out[2] += w * texel[2];
+            }
+        }
+    }
+}
+
+} // namespace
+
+void OceanFFT::buildProbeBins(Cascade& cascade) const {
+    const int halfN = m_N / 2 + 1;
+    const float norm = 1.0f / (static_cast<float>(m_N) * m_N);
+    const size_t binCount = cascade.activeBins.size();
+    ProbeBins& bins = cascade.probeBins;
+    bins.column.resize(binCount);
+    bins.row.resize(binCount);
+    bins.unitX.resize(binCount);
+    bins.unitZ.resize(binCount);
+    bins.kx.resize(binCount);
+    bins.kz.resize(binCount);
+    bins.omega.resize(binCount);
+    bins.omegaDouble.resize(cascade.omegaDouble.empty() ? 0 : binCount);
+    bins.h0.resize(binCount);
+    bins.h0Conj.resize(binCount);
+
+    // Row by row, over the row ranges of activeBins
+    m_threadPool->parallelFor(m_N, [&](int row) {
+        for (int b = cascade.rowStart[row]; b < cascade.rowStart[row + 1]; ++b) {
+            int idx = cascade.activeBins[b];
+            int x = idx % halfN;
+            int z = idx / halfN;
+            glm::vec2 k = getWaveVector(x, z, cascade.desc.patchSize);
+            float kLen = glm::length(k);
+
+            // Columns 1..N/2-1 also stand for their conjugate mirror image
+            float weight = (x == 0 || x == m_N / 2 ? 1.0f : 2.0f) * norm;
+            int nx = x < m_N / 2 ? x : x - m_N;
+            int nz = z < m_N / 2 ? z : z - m_N;
+            bins.column[b] = nx + m_N / 2;
+            bins.row[b] = nz + m_N / 2;
+            bins.unitX[b] = kLen > 0.0001f ? k.x / kLen : 0.0f;
+            bins.unitZ[b] = kLen > 0.0001f ? k.y / kLen : 0.0f;
+            bins.kx[b] = k.x;
+            bins.kz[b] = k.y;
+            bins.omega[b] = cascade.omega[idx];
+            if (!cascade.omegaDouble.empty()) bins.omegaDouble[b] = cascade.omegaDouble[idx];
+            bins.h0[b] = cascade.h0[idx] * weight;
+            bins.h0Conj[b] = cascade.h0Conj[idx] * weight;
+        }
+    });
+}
+
+void OceanFFT::probe(int count, const float* x, const float* z, double time,
+                     glm::vec3* displacement, glm::vec2* gradient) const {
+    using namespace std::complex_literals;
+
+    for (int i = 0; i < count; ++i) {
+        displacement[i] = glm::vec3(0.0f);
+        if (gradient) gradient[i] = glm::vec2(0.0f);
+    }
+
+    // Depth region weights per point
+    const int regionCount = getDepthRegionCount();
+    std::vector<float> regionWeight(static_cast<size_t>(count) * regionCount);
+    for (int p = 0; p < count; ++p) getRegionWeights(x[p], z[p], &regionWeight[static_cast<size_t>(p) * regionCount]);
+
+    // Per bin: h(k,t) (shared by all points), then e^{ik·p} (per point)
+    std::vector<float> hr, hi, er, ei;
+    std::vector<std::complex<float>> powersX(m_N), powersZ(m_N);
+    for (int c = 0; c < getCascadeCount(); ++c) {
+        const Cascade& cascade = m_cascades[c];
+        const ProbeBins& bins = cascade.probeBins;
+        const size_t binCount = bins.column.size();
+        hr.resize(binCount);
+        hi.resize(binCount);
+        er.resize(binCount);
+        ei.resize(binCount);
+        const bool precisePhase = !bins.omegaDouble.empty();
+        const double TWO_PI = 6.28318530717958647692;
+        for (size_t b = 0; b < binCount; ++b) {
+            std::complex<float> expIwt = precisePhase
+                ? std::complex<float>(std::polar(1.0, std::fmod(bins.omegaDouble[b] * time, TWO_PI)))
+                : std::exp(1if * bins.omega[b] * static_cast<float>(time));
+            std::complex<float> h = bins.h0[b] * expIwt + bins.h0Conj[b] * std::conj(expIwt);
+            hr[b] = h.real();
+            hi[b] = h.imag();
+        }
+
+        const double PI = 3.14159265358979323846;
+        const double fundamental = 2.0 * PI / cascade.desc.patchSize;
+        for (int p = 0; p < count; ++p) {
+            float weight = regionWeight[static_cast<size_t>(p) * regionCount + getCascadeRegion(c)];
+            if (weight <= 0.0f) continue;
+
+            // k lies on the lattice 2π n / L: e^{ik·p} = ax^nx * az^nz, with the
+            // powers n in [-N/2, N/2) built by recurrence in double precision
+            for (int axis = 0; axis < 2; ++axis) {
+                double theta = fundamental * (axis == 0 ? x[p] : z[p]);
+                std::complex<double> step(std::cos(theta), std::sin(theta));
+                std::complex<double> power = std::polar(1.0, -theta * (m_N / 2));
+                std::vector<std::complex<float>>& powers = axis == 0 ? powersX : powersZ;
+                for (int n = 0; n < m_N; ++n) {
+                    powers[n] = std::complex<float>(power);
+                    power *= step;
+                }
+            }
+            for (size_t b = 0; b < binCount; ++b) {
+                std::complex<float> e = powersX[bins.column[b]] * powersZ[bins.row[b]];
+                er[b] = e.real();
+                ei[b] = e.imag();
+            }
+
+            // c = h * e: height Re(c); choppy Re(-i k/|k| c) = k/|k| Im(c);
+            // gradient Re(i k c) = -k Im(c)
+            float height = 0.0f, dx = 0.0f, dz = 0.0f, gx = 0.0f, gz = 0.0f;
+            size_t b = 0;
+#ifdef OCEANFFT_HAS_SSE
+            __m128 sumH = _mm_setzero_ps(), sumDx = _mm_setzero_ps(), sumDz = _mm_setzero_ps();
+            __m128 sumGx = _mm_setzero_ps(), sumGz = _mm_setzero_ps();
+            for (; b + 4 <= binCount; b += 4) {
+                __m128 vhr = _mm_loadu_ps(&hr[b]), vhi = _mm_loadu_ps(&hi[b]);
+                __m128 ver = _mm_loadu_ps(&er[b]), vei = _mm_loadu_ps(&ei[b]);
+                __m128 cr = _mm_sub_ps(_mm_mul_ps(vhr, ver), _mm_mul_ps(vhi, vei));
+                __m128 ci = _mm_add_ps(_mm_mul_ps(vhr, vei), _mm_mul_ps(vhi, ver));
+                sumH = _mm_add_ps(sumH, cr);
+                sumDx = _mm_add_ps(sumDx, _mm_mul_ps(ci, _mm_loadu_ps(&bins.unitX[b])));
+                sumDz = _mm_add_ps(sumDz, _mm_mul_ps(ci, _mm_loadu_ps(&bins.unitZ[b])));
+                sumGx = _mm_sub_ps(sumGx, _mm_mul_ps(ci, _mm_loadu_ps(&bins.kx[b])));
+                sumGz = _mm_sub_ps(sumGz, _mm_mul_ps(ci, _mm_loadu_ps(&bins.kz[b])));
+            }
+            float lanes[5][4];
+            _mm_storeu_ps(lanes[0], sumH);
+            _mm_storeu_ps(lanes[1], sumDx);
+            _mm_storeu_ps(lanes[2], sumDz);
+            _mm_storeu_ps(lanes[3], sumGx);
+            _mm_storeu_ps(lanes[4], sumGz);
+            for (int lane = 0; lane < 4; ++lane) {
+                height += lanes[0][lane];
+                dx += lanes[1][lane];
+                dz += lanes[2][lane];
+                gx += lanes[3][lane];
+                gz += lanes[4][lane];
+            }
+#endif
+            for (; b < binCount; ++b) {
+                float cr = hr[b] * er[b] - hi[b] * ei[b];
+                float ci = hr[b] * ei[b] + hi[b] * er[b];
+                height += cr;
+                dx += ci * bins.unitX[b];
+                dz += ci * bins.unitZ[b];
+                gx -= ci * bins.kx[b];
+                gz -= ci * bins.kz[b];
+            }
+
+            displacement[p] += weight * glm::vec3(dx * m_choppy, height, dz * m_choppy);
+            if (gradient) gradient[p] += weight * glm::vec2(gx, gz);
+        }
+    }
+}
+
+void OceanFFT::sampleSurface(int count, const float* x, const float* z, const SurfaceSamples& out,
+                             SampleFilter filter, int inversionIterations) const {
+    // Chunks large enough to amortize the dispatch
+    const int chunk = 4096;
+    int chunks = (count + chunk - 1) / chunk;
+    inversionIterations = std::max(inversionIterations, 0);
+    m_threadPool->parallelFor(chunks, [&](int item) {
+        int begin = item * chunk;
+        int end = std::min(begin + chunk, count);
+        if (filter == SampleFilter::Bicubic) {
+            sampleSurfaceRange<4>(begin, end, x, z, out, inversionIterations);
+        } else {
+            sampleSurfaceRange<2>(begin, end, x, z, out, inversionIterations);
+        }
+    });
+}
+
+template <int Taps>
+void OceanFFT::sampleSurfaceRange(int begin, int end, const float* x, const float* z,
+                                  const SurfaceSamples& out, int inversionIterations) const {
+    // The GPU path answers from its latest readback, possibly a coarser level
+    const SurfaceReadback* readback = getSampledReadback();
+    const int size = readback ? readback->getSize() : m_N;
+    const int mask = size - 1;
+    const int cascadeCount = getCascadeCount();
+    const bool normals = out.normalX || out.normalY || out.normalZ;
+    const bool velocity = out.velocityX || out.velocityY || out.velocityZ;
+    const bool derivedNormals = m_normalPass || readback;
+
+    const int perRegion = getCascadesPerRegion();
+    float texelsPerMeter[MAX_SIMULATED_CASCADES];
+    const float* displacementTexels[MAX_SIMULATED_CASCADES];
+    for (int c = 0; c < cascadeCount; ++c) {
+        texelsPerMeter[c] = size / m_cascades[c].desc.patchSize;
+        displacementTexels[c] = readback ? readback->getTexels(c) : m_cascades[c].mips[0].displacementData.data();
+    }
+
+    int columns[MAX_SIMULATED_CASCADES][Taps], rows[MAX_SIMULATED_CASCADES][Taps];
+    float wu[MAX_SIMULATED_CASCADES][Taps], wv[MAX_SIMULATED_CASCADES][Taps];
+    float regionWeight[MAX_DEPTH_REGIONS];
+    float weight[MAX_SIMULATED_CASCADES];
+    for (int q = begin; q < end; ++q) {
+        // Fixed-point iteration towards the grid point displaced onto (x, z);
+        // the last pass also yields the height there
+        float px = x[q];
+        float pz = z[q];
+        float displacement[3];
+        for (int iteration = 0; iteration <= inversionIterations; ++iteration) {
+            // Depth regions by the grid point, as the vertex shader does;
+            // regions without weight are skipped here and below
+            getRegionWeights(px, pz, regionWeight);
+            displacement[0] = displacement[1] = displacement[2] = 0.0f;
+            for (int c = 0; c < cascadeCount; ++c) {
+                weight[c] = regionWeight[c / perRegion];
+                if (weight[c] <= 0.0f) continue;
+                filterTaps<Taps>(px * texelsPerMeter[c], mask, columns[c], wu[c]);
+                filterTaps<Taps>(pz * texelsPerMeter[c], mask, rows[c], wv[c]);
+                float sample[3] = {};
+                accumulateSample<Taps, 3>(displacementTexels[c], 3, size,
+                                          columns[c], wu[c], rows[c], wv[c], sample);
+                for (int i = 0; i < 3; ++i) displacement[i] += weight[c] * sample[i];
+            }
+            if (iteration < inversionIterations) {
+                px = x[q] - displacement[0];
+                pz = z[q] - displacement[2];
+            }
+        }
+        if (out.height) out.height[q] = displacement[1];
+
+        // Cascades add slopes, as in the shaders (taps of the final point)
+        if (normals) {
+            float slopeX = 0.0f;
+            float slopeZ = 0.0f;
+            for (int c = 0; c < cascadeCount; ++c) {
+                if (weight[c] <= 0.0f) continue;
+                float n[3] = {};
+                if (derivedNormals) {
+                    // As NormalDerivation: central differences of the displaced
+                    // grid, i.e. the same taps one texel either side
+                    const float* texels = displacementTexels[c];
+                    int nextColumns[Taps], prevColumns[Taps], nextRows[Taps], prevRows[Taps];
+                    float negWu[Taps], negWv[Taps];
+                    for (int i = 0; i < Taps; ++i) {
+                        nextColumns[i] = (columns[c][i] + 1) & mask;
+                        prevColumns[i] = (columns[c][i] - 1) & mask;
+                        nextRows[i] = (rows[c][i] + 1) & mask;
+                        prevRows[i] = (rows[c][i] - 1) & mask;
+                        negWu[i] = -wu[c][i];
+                        negWv[i] = -wv[c][i];
+                    }
+                    float spacing = 2.0f / texelsPerMeter[c];
+                    float tangentX[3] = { spacing, 0.0f, 0.0f };
+                    float tangentZ[3] = { 0.0f, 0.0f, spacing };
+                    accumulateSample<Taps, 3>(texels, 3, size, nextColumns, wu[c], rows[c], wv[c], tangentX);
+                    accumulateSample<Taps, 3>(texels, 3, size, prevColumns, negWu, rows[c], wv[c], tangentX);
+                    accumulateSample<Taps, 3>(texels, 3, size, columns[c], wu[c], nextRows, wv[c], tangentZ);
+                    accumulateSample<Taps, 3>(texels, 3, size, columns[c], wu[c], prevRows, negWv, tangentZ);
+                    glm::vec3 normal = glm::cross(glm::vec3(tangentZ[0], tangentZ[1], tangentZ[2]),
+                                                  glm::vec3(tangentX[0], tangentX[1], tangentX[2]));
+                    normal.y = std::max(normal.y, 1e-3f * glm::length(normal));
+                    n[0] = normal.x;
+                    n[1] = normal.y;
+                    n[2] = normal.z;
+                } else {
+                    accumulateSample<Taps, 3>(m_cascades[c].mips[0].normalData.data(), 3, m_N,
+                                              columns[c], wu[c], rows[c], wv[c], n);
+                }
+                slopeX += weight[c] * n[0] / n[1];
+                slopeZ += weight[c] * n[2] / n[1];
+            }
+            glm::vec3 normal = glm::normalize(glm::vec3(slopeX, 1.0f, slopeZ));
+            if (out.normalX) out.normalX[q] = normal.x;
+            if (out.normalY) out.normalY[q] = normal.y;
+            if (out.normalZ) out.normalZ[q] = normal.z;
+        }
+
+        if (!m_velocityEnabled || readback) {
+            for (float* target : { out.velocityX, out.velocityY, out.velocityZ }) {
+                if (target) target[q] = 0.0f;
+            }
+        } else if (velocity) {
+            const Field fields[3] = { FIELD_VELOCITY_X, FIELD_VELOCITY_Y, FIELD_VELOCITY_Z };
+            float* targets[3] = { out.velocityX, out.velocityY, out.velocityZ };
+            for (int axis = 0; axis < 3; ++axis) {
+                if (!targets[axis]) continue;
+                float v = 0.0f;
+                for (int c = 0; c < cascadeCount; ++c) {
+                    if (weight[c] <= 0.0f) continue;
+                    float sample = 0.0f;
+                    accumulateSample<Taps, 1>(fieldData(c, fields[axis]), 1, m_N,
+                                              columns[c], wu[c], rows[c], wv[c], &sample);
+                    v += weight[c] * sample;
+                }
+                targets[axis][q] = v;
+            }
+        }
+    }
+}
+
+void OceanFFT::buildHeightPyramid(int cascade, int slot) {
+    const float* texels = m_cascades[cascade].mips[0].displacementData.data();
+    HeightPyramid& pyramid = m_cascades[cascade].heightBounds[slot];
+    pyramid.levels.resize(m_mipLevels);
+
+    // Level 0: the four corners of each bilinear cell
+    const int mask = m_N - 1;
+    std::vector<glm::vec2>& base = pyramid.levels[0];
+    base.resize(static_cast<size_t>(m_N) * m_N);
+    glm::vec4 horizontal(FLT_MAX, -FLT_MAX, FLT_MAX, -FLT_MAX);
+    for (int z = 0; z < m_N; ++z) {
+        const float* row = texels + static_cast<size_t>(z) * m_N * 3;
+        const float* next = texels + static_cast<size_t>((z + 1) & mask) * m_N * 3;
+        glm::vec2* cells = base.data() + static_cast<size_t>(z) * m_N;
+        for (int x = 0; x < m_N; ++x) {
+            int right = ((x + 1) & mask) * 3;
+            float a = row[3 * x + 1];
+            float b = row[right + 1];
+            float c = next[3 * x + 1];
+            float d = next[right + 1];
+            cells[x] = glm::vec2(std::min(std::min(a, b), std::min(c, d)),
+                                 std::max(std::max(a, b), std::max(c, d)));
+
+            horizontal.x = std::min(horizontal.x, row[3 * x]);
+            horizontal.y = std::max(horizontal.y, row[3 * x]);
+            horizontal.z = std::min(horizontal.z, row[3 * x + 2]);
+            horizontal.w = std::max(horizontal.w, row[3 * x + 2]);
+        }
+    }
+    pyramid.horizontal = horizontal;
+
+    for (int level = 1; level < m_mipLevels; ++level) {
+        int size = m_N >> level;
+        const glm::vec2* below = pyramid.levels[level - 1].data();
+        std::vector<glm::vec2>& cells = pyramid.levels[level];
+        cells.resize(static_cast<size_t>(size) * size);
+        for (int z = 0; z < size; ++z) {
+            const glm::vec2* r0 = below + static_cast<size_t>(2 * z) * 2 * size;
+            const glm::vec2* r1 = r0 + 2 * size;
+            for (int x = 0; x < size; ++x) {
+                glm::vec2 a = r0[2 * x], b = r0[2 * x + 1], c = r1[2 * x], d = r1[2 * x + 1];
+                cells[static_cast<size_t>(z) * size + x] =
+                    glm::vec2(std::min(std::min(a.x, b.x), std::min(c.x, d.x)),
+                              std::max(std::max(a.y, b.y), std::max(c.y, d.y)));
+            }
+        }
+    }
+}
+
+glm::vec2 OceanFFT::pyramidBounds(const HeightPyramid& pyramid, float patchSize,
+                                  float xMin, float zMin, float xMax, float zMax) const {
+    const int top = m_mipLevels - 1;
+    double scale = m_N / static_cast<double>(patchSize);
+    double u0 = std::floor(xMin * scale);
+    double u1 = std::floor(xMax * scale);
+    double v0 = std::floor(zMin * scale);
+    double v1 = std::floor(zMax * scale);
+    if (u1 - u0 >= m_N || v1 - v0 >= m_N) return pyramid.levels[top][0];
+
+    // First cell wrapped into the patch, the last one past it if need be
+    int i0 = static_cast<int>(u0 - std::floor(u0 / m_N) * m_N);
+    int j0 = static_cast<int>(v0 - std::floor(v0 / m_N) * m_N);
+    int i1 = i0 + static_cast<int>(u1 - u0);
+    int j1 = j0 + static_cast<int>(v1 - v0);
+
+    // Finest level on which the region touches at most 2x2 cells
+    int level = 0;
+    while (level < top && ((i1 >> level) - (i0 >> level) > 1 || (j1 >> level) - (j0 >> level) > 1)) ++level;
+
+    int size = m_N >> level;
+    const std::vector<glm::vec2>& cells = pyramid.levels[level];
+    glm::vec2 bounds(FLT_MAX, -FLT_MAX);
+    for (int j = j0 >> level; j <= (j1 >> level); ++j) {
+        for (int i = i0 >> level; i <= (i1 >> level); ++i) {
+            const glm::vec2& cell = cells[static_cast<size_t>(j & (size - 1)) * size + (i & (size - 1))];
+            bounds.x = std::min(bounds.x, cell.x);
+            bounds.y = std::max(bounds.y, cell.y);
+        }
+    }
+    return bounds;
+}
+
+glm::vec2 OceanFFT::surfaceBounds(float xMin, float zMin, float xMax, float zMax, bool bothFrames) const {
+    // Cascades add up within a region; blended regions stay within the
+    // union of their bounds
+    glm::vec2 bounds(FLT_MAX, -FLT_MAX);
+    glm::vec2 regionBounds(0.0f);
+    for (int c = 0; c < getCascadeCount(); ++c) {
+        const Cascade& cascade = m_cascades[c];
+        float patchSize = cascade.desc.patchSize;
+        glm::vec2 range = pyramidBounds(cascade.heightBounds[cascade.newestSlot], patchSize,
+                                        xMin, zMin, xMax, zMax);
+        if (bothFrames) {
+            glm::vec2 previous = pyramidBounds(cascade.heightBounds[cascade.newestSlot ^ 1], patchSize,
+                                               xMin, zMin, xMax, zMax);
+            range = glm::vec2(std::min(range.x, previous.x), std::max(range.y, previous.y));
+        }
+        regionBounds += range;
+        if ((c + 1) % getCascadesPerRegion() == 0) {
+            bounds = glm::vec2(std::min(bounds.x, regionBounds.x), std::max(bounds.y, regionBounds.y));
+            regionBounds = glm::vec2(0.0f);
+        }
+    }
+    return bounds;
+}
+
+glm::vec2 OceanFFT::getHeightBounds(float xMin, float zMin, float xMax, float zMax) const {
+    if (!hasHeightBounds()) return glm::vec2(-FLT_MAX, FLT_MAX);
+    return surfaceBounds(xMin, zMin, xMax, zMax, true);
+}
+
+glm::vec4 OceanFFT::getHorizontalDisplacementRange() const {
+    glm::vec4 range(0.0f);
+    if (!hasHeightBounds()) return range;
+    glm::vec4 regionRange(0.0f);
+    for (int c = 0; c < getCascadeCount(); ++c) {
+        const glm::vec4& a = m_cascades[c].heightBounds[0].horizontal;
+        const glm::vec4& b = m_cascades[c].heightBounds[1].horizontal;
+        regionRange += glm::vec4(std::min(a.x, b.x), std::max(a.y, b.y), std::min(a.z, b.z), std::max(a.w, b.w));
+        if ((c + 1) % getCascadesPerRegion() == 0) {
+            range = glm::vec4(std::min(range.x, regionRange.x), std::max(range.y, regionRange.y),
+                              std::min(range.z, regionRange.z), std::max(range.w, regionRange.w));
+            regionRange = glm::vec4(0.0f);
+        }
+    }
+    return range;
+}
+
+bool OceanFFT::intersectRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                            float& distance) const {
+    float length = glm::length(direction);
+    if (!hasHeightBounds() || !(length > 0.0f)) return false;
+    const glm::vec3 dir = direction / length;
+
+    // The surface over a region comes from points up to -D away (newest frames)
+    glm::vec4 shift(0.0f);
+    glm::vec2 global(0.0f);
+    float finest = FLT_MAX;
+    for (const Cascade& cascade : m_cascades) {
+        const HeightPyramid& pyramid = cascade.heightBounds[cascade.newestSlot];
+        shift += pyramid.horizontal;
+        global += pyramid.levels.back()[0];
+        finest = std::min(finest, cascade.desc.patchSize / m_N);
+    }
+
+    // Only the slab between the lowest and highest surface point matters
+    float tStart = 0.0f;
+    float tEnd = maxDistance;
+    if (origin.y > global.y) {
+        if (dir.y >= 0.0f) return false;
+        tStart = (global.y - origin.y) / dir.y;
+    }
+    if (dir.y < 0.0f) {
+        tEnd = std::min(tEnd, (global.x - origin.y) / dir.y);
+    } else if (dir.y > 0.0f) {
+        tEnd = std::min(tEnd, (global.y - origin.y) / dir.y);
+    }
+    if (tStart > tEnd) return false;
+
+    // Height of the ray above the surface (bilinear, as sampleSurface)
+    auto clearance = [&](float t) {
+        float x = origin.x + t * dir.x;
+        float z = origin.z + t * dir.z;
+        float height = 0.0f;
+        SurfaceSamples out;
+        out.height = &height;
+        sampleSurfaceRange<2>(0, 1, &x, &z, out, 3);
+        return origin.y + t * dir.y - height;
+    };
+
+    // Nodes halve from the largest patch down to the finest texel
+    const float rootSize = getPatchSize();
+    int maxDepth = 0;
+    while (rootSize / static_cast<float>(1 << maxDepth) > finest * 1.001f && maxDepth < 30) ++maxDepth;
+
+    // Nodes are located slightly ahead of t so that boundaries make progress
+    float horizontal = std::sqrt(dir.x * dir.x + dir.z * dir.z);
+    float nudge = 1e-3f * finest / std::max(horizontal, 1e-3f);
+
+    float t = tStart;
+    float lastT = -1.0f;
+    float lastClearance = 0.0f;
+    int depth = 0;
+    for (int step = 0; step < (1 << 20) && t <= tEnd; ++step) {
+        float size = rootSize / static_cast<float>(1 << depth);
+        float locate = t + nudge;
+        float nodeX = std::floor((origin.x + locate * dir.x) / size) * size;
+        float nodeZ = std::floor((origin.z + locate * dir.z) / size) * size;
+
+        // Where the ray leaves the node
+        float tExit = tEnd;
+        if (dir.x > 0.0f) tExit = std::min(tExit, (nodeX + size - origin.x) / dir.x);
+        if (dir.x < 0.0f) tExit = std::min(tExit, (nodeX - origin.x) / dir.x);
+        if (dir.z > 0.0f) tExit = std::min(tExit, (nodeZ + size - origin.z) / dir.z);
+        if (dir.z < 0.0f) tExit = std::min(tExit, (nodeZ - origin.z) / dir.z);
+        tExit = std::max(tExit, locate);
+
+        // Skip nodes the ray passes above
+        glm::vec2 bounds = surfaceBounds(nodeX - shift.y, nodeZ - shift.w,
+                                         nodeX + size - shift.x, nodeZ + size - shift.z, false);
+        float rayLow = origin.y + std::min(t * dir.y, tExit * dir.y);
+        if (rayLow > bounds.y) {
+            t = tExit;
+            depth = std::max(depth - 1, 0);
+            continue;
+        }
+        if (depth < maxDepth) {
+            ++depth;
+            continue;
+        }
+
+        // Finest cell: look for a sign change, then regula falsi
+        float t0 = t;
+        float t1 = std::min(tExit, tEnd);
+        float f0 = t0 == lastT ? lastClearance : clearance(t0);
+        if (f0 <= 0.0f) {
+            distance = t0;
+            return true;
+        }
+        float f1 = clearance(t1);
+        if (f1 <= 0.0f) {
+            for (int iteration = 0; iteration < 6; ++iteration) {
+                float tm = t0 + (t1 - t0) * f0 / (f0 - f1);
+                float fm = clearance(tm);
+                if (fm > 0.0f) {
+                    t0 = tm;
+                    f0 = fm;
+                } else {
+                    t1 = tm;
+                    f1 = fm;
+                }
+            }
+            distance = t0 + (t1 - t0) * f0 / (f0 - f1);
+            return true;
+        }
+        lastT = t1;
+        lastClearance = f1;
+        t = tExit;
+        depth = std::max(depth - 1, 0);
+        if (t >= tEnd) break;
+    }
+    return false;
+}
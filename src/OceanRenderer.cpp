@@ -1,9 +1,43 @@
 #include "OceanRenderer.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/**
+ * @brief Frustum planes of a view-projection matrix (inside where dot(plane, (p, 1)) >= 0)
+ */
+void frustumPlanes(const glm::mat4& m, glm::vec4 planes[6]) {
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; ++r) rows[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+    for (int axis = 0; axis < 3; ++axis) {
+        planes[2 * axis] = rows[3] + rows[axis];
+        planes[2 * axis + 1] = rows[3] - rows[axis];
+    }
+}
+
+/**
+ * @brief Whether an axis-aligned box is at least partly inside all planes
+ */
+bool boxInFrustum(const glm::vec4 planes[6], const glm::vec3& lo, const glm::vec3& hi) {
+    for (int p = 0; p < 6; ++p) {
+        // Corner furthest along the plane normal
+        glm::vec3 corner(planes[p].x > 0.0f ? hi.x : lo.x,
+                         planes[p].y > 0.0f ? hi.y : lo.y,
+                         planes[p].z > 0.0f ? hi.z : lo.z);
+        if (glm::dot(planes[p], glm::vec4(corner, 1.0f)) < 0.0f) return false;
+    }
+    return true;
+}
+
+} // namespace
 
 OceanRenderer::OceanRenderer()
     : m_oceanFFT(nullptr)
     , m_wireframe(false)
+    , m_culling(true)
+    , m_visibleTileCount(0)
     , m_waterColor(0.0f, 0.3f, 0.5f)
     , m_foamThreshold(0.5f)
     , m_sunDirection(1.0f, 1.0f, 0.5f)
@@ -22,7 +56,7 @@ bool OceanRenderer::initialize(OceanFFT* oceanFFT) {
     // Create mesh with reduced resolution for better performance
     // Using half the FFT resolution (128/2 = 64) for rendering
     int meshRes = oceanFFT->getResolution() / 2;
-    m_mesh = std::make_unique<Mesh>(meshRes, oceanFFT->getPatchSize());
+    m_mesh = std::make_unique<Mesh>(meshRes, oceanFFT->getPatchSize(), TILES_PER_SIDE);
     m_mesh->generate();
 
     // Load ocean shader
@@ -41,6 +75,12 @@ void OceanRenderer::render(const Camera& camera, float time) {
         return;
     }
 
+    // The mesh spans the largest cascade's patch
+    if (m_mesh->getSize() != m_oceanFFT->getPatchSize()) {
+        m_mesh = std::make_unique<Mesh>(m_mesh->getResolution(), m_oceanFFT->getPatchSize(), TILES_PER_SIDE);
+        m_mesh->generate();
+    }
+
     // Set wireframe mode
     if (m_wireframe) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -63,15 +103,78 @@ void OceanRenderer::render(const Camera& camera, float time) {
     // Set camera position
     m_shader->setUniform("uCameraPos", camera.getPosition());
 
-    // Bind displacement and normal textures
+    // A GPU-resident loop holds every frame: the shaders pick and blend
+    // the two around the time instead of the simulated layer pairs
+    bool loopResident = m_oceanFFT->isLoopResident();
+    GLuint displacementTexture = loopResident ? m_oceanFFT->getLoopDisplacementTexture()
+                                              : m_oceanFFT->getDisplacementTexture();
+    GLuint normalTexture = loopResident ? m_oceanFFT->getLoopNormalTexture() : m_oceanFFT->getNormalTexture();
+    GLuint foamTexture = loopResident ? m_oceanFFT->getLoopFoamTexture() : m_oceanFFT->getFoamTexture();
+
+    m_shader->setUniform("uLoopPlayback", loopResident);
+    if (loopResident) {
+        float period = m_oceanFFT->getLoopPeriod();
+        float loopTime = std::fmod(time, period);
+        if (loopTime < 0.0f) loopTime += period;
+        m_shader->setUniform("uLoopFrames", m_oceanFFT->getLoopFrameCount());
+        m_shader->setUniform("uLoopPeriod", period);
+        m_shader->setUniform("uLoopTime", loopTime);
+    }
+
+    // Bind displacement and normal textures (layers per cascade)
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_oceanFFT->getDisplacementTexture());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, displacementTexture);
     m_shader->setUniform("uDisplacement", 0);
 
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, m_oceanFFT->getNormalTexture());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, normalTexture);
     m_shader->setUniform("uNormals", 1);
 
+    // Foam coverage map (only maintained while the Jacobian is enabled)
+    bool useFoamMap = m_oceanFFT->isJacobianEnabled() && foamTexture != 0;
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, useFoamMap ? foamTexture : 0);
+    m_shader->setUniform("uFoam", 2);
+    m_shader->setUniform("uUseFoamMap", useFoamMap);
+
+    // Cascade tiling and vertex-stage LOD (vertex shaders have no derivatives)
+    const int cascadeCount = m_oceanFFT->getCascadeCount();
+    float uvScale[OceanFFT::MAX_SIMULATED_CASCADES] = {};
+    float vertexLod[OceanFFT::MAX_SIMULATED_CASCADES] = {};
+    float layer[OceanFFT::MAX_SIMULATED_CASCADES] = {};
+    float blend[OceanFFT::MAX_SIMULATED_CASCADES] = {};
+    float vertexSpacing = m_mesh->getSize() / (m_mesh->getResolution() - 1);
+    for (int c = 0; c < cascadeCount; ++c) {
+        float patchSize = m_oceanFFT->getCascade(c).patchSize;
+        float texelSize = patchSize / m_oceanFFT->getResolution();
+        uvScale[c] = m_oceanFFT->getPatchSize() / patchSize;
+        vertexLod[c] = std::max(0.0f, std::log2(vertexSpacing / texelSize));
+
+        // Newest frame and its weight against the previous one (multi-rate)
+        layer[c] = static_cast<float>(m_oceanFFT->getCascadeLayer(c));
+        blend[c] = m_oceanFFT->getCascadeBlend(c);
+    }
+    m_shader->setUniform("uCascadeCount", cascadeCount);
+    m_shader->setUniform("uCascadeUVScale", uvScale, cascadeCount);
+    m_shader->setUniform("uCascadeVertexLod", vertexLod, cascadeCount);
+    m_shader->setUniform("uCascadeLayer", layer, cascadeCount);
+    m_shader->setUniform("uCascadeBlend", blend, cascadeCount);
+
+    // Depth regions, weighted by the bathymetry map (log depth, as on the CPU)
+    float regionLogDepth[OceanFFT::MAX_DEPTH_REGIONS] = {};
+    const std::vector<float>& regionDepths = m_oceanFFT->getDepthRegions();
+    for (size_t r = 0; r < regionDepths.size(); ++r) regionLogDepth[r] = std::log(regionDepths[r]);
+    GLuint bathymetryTexture = m_oceanFFT->getBathymetryTexture();
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, bathymetryTexture);
+    m_shader->setUniform("uBathymetry", 3);
+    m_shader->setUniform("uUseBathymetry", bathymetryTexture != 0);
+    m_shader->setUniform("uBathymetryOrigin", m_oceanFFT->getBathymetryOrigin());
+    m_shader->setUniform("uBathymetryExtent", m_oceanFFT->getBathymetryExtent());
+    m_shader->setUniform("uCascadesPerRegion", m_oceanFFT->getCascadesPerRegion());
+    m_shader->setUniform("uRegionCount", m_oceanFFT->getDepthRegionCount());
+    m_shader->setUniform("uRegionLogDepth", regionLogDepth, OceanFFT::MAX_DEPTH_REGIONS);
+
     // Set rendering parameters
     m_shader->setUniform("uWaterColor", m_waterColor);
     m_shader->setUniform("uFoamThreshold", m_foamThreshold);
@@ -86,11 +189,47 @@ void OceanRenderer::render(const Camera& camera, float time) {
     // Enable depth testing
     glEnable(GL_DEPTH_TEST);
 
-    // Render mesh
-    m_mesh->render();
+    // Render mesh (only the tiles in view when the ocean can bound them)
+    if (m_culling && m_oceanFFT->hasHeightBounds()) {
+        cullTiles(projection * view * model);
+        m_mesh->renderTiles(m_visibleTiles);
+    } else {
+        m_visibleTileCount = m_mesh->getTileCount();
+        m_mesh->render();
+    }
 
     // Cleanup
     glDisable(GL_BLEND);
     glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0);
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 }
+
+void OceanRenderer::cullTiles(const glm::mat4& viewProjection) {
+    glm::vec4 planes[6];
+    frustumPlanes(viewProjection, planes);
+
+    // Vertices sample texel centres: mesh x maps to x + L/2 - L_c/(2N) in
+    // each cascade's simulation frame, so widen by the largest offset
+    float patchSize = m_oceanFFT->getPatchSize();
+    float origin = 0.5f * patchSize;
+    float texelOffset = 0.5f * patchSize / m_oceanFFT->getResolution();
+    glm::vec4 shift = m_oceanFFT->getHorizontalDisplacementRange();
+
+    m_visibleTiles.clear();
+    int tiles = m_mesh->getTilesPerSide();
+    for (int tileZ = 0; tileZ < tiles; ++tileZ) {
+        for (int tileX = 0; tileX < tiles; ++tileX) {
+            glm::vec4 extent = m_mesh->getTileExtent(tileX, tileZ);
+            glm::vec2 height = m_oceanFFT->getHeightBounds(extent.x + origin - texelOffset,
+                                                           extent.y + origin - texelOffset,
+                                                           extent.z + origin, extent.w + origin);
+            glm::vec3 lo(extent.x + shift.x, height.x, extent.y + shift.z);
+            glm::vec3 hi(extent.z + shift.y, height.y, extent.w + shift.w);
+            if (boxInFrustum(planes, lo, hi)) m_visibleTiles.push_back(tileZ * tiles + tileX);
+        }
+    }
+    m_visibleTileCount = static_cast<int>(m_visibleTiles.size());
+}
@@ -5,6 +5,7 @@
 #include "ShaderProgram.h"
 #include "Camera.h"
 #include <memory>
+#include <vector>
 
 /**
  * @brief Renders the FFT ocean using OpenGL
@@ -36,6 +37,21 @@ public:
     void setWireframe(bool enabled) { m_wireframe = enabled; }
     bool isWireframe() const { return m_wireframe; }
 
+    /**
+     * @brief Skip mesh tiles outside the view frustum
+     *
+     * Tile boxes come from the ocean's height bounds (setHeightBoundsEnabled);
+     * without them every tile is drawn.
+     */
+    void setCullingEnabled(bool enabled) { m_culling = enabled; }
+    bool isCullingEnabled() const { return m_culling; }
+
+    /**
+     * @brief Tiles drawn by the last render() out of all mesh tiles
+     */
+    int getVisibleTileCount() const { return m_visibleTileCount; }
+    int getTileCount() const { return m_mesh ? m_mesh->getTileCount() : 0; }
+
     /**
      * @brief Set rendering parameters
      */
@@ -51,16 +67,26 @@ public:
     const glm::vec3& getSunDirection() const { return m_sunDirection; }
 
 private:
+    static constexpr int TILES_PER_SIDE = 8;
+
     OceanFFT* m_oceanFFT;
     std::unique_ptr<Mesh> m_mesh;
     std::unique_ptr<ShaderProgram> m_shader;
 
     // Rendering parameters
     bool m_wireframe;
+    bool m_culling;
+    int m_visibleTileCount;
+    std::vector<int> m_visibleTiles;
     glm::vec3 m_waterColor;
     float m_foamThreshold;
     glm::vec3 m_sunDirection;
 
     // Skybox (simplified - single color for now)
     glm::vec3 m_skyColor;
+
+    /**
+     * @brief Collect the tiles whose displaced bounding box meets the frustum
+     */
+    void cullTiles(const glm::mat4& viewProjection);
 };
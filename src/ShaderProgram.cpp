@@ -70,6 +70,39 @@ bool ShaderProgram::loadFromFiles(const std::string& vertexPath, const std::stri
     return true;
 }
 
+bool ShaderProgram::loadComputeFromFile(const std::string& computePath, const std::string& defines) {
+    std::string source = readFile(computePath);
+    if (source.empty()) {
+        std::cerr << "ERROR: Failed to read shader file\n";
+        return false;
+    }
+
+    // Defines must follow the #version directive
+    size_t versionEnd = source.find('\n', source.find("#version"));
+    source.insert(versionEnd == std::string::npos ? source.size() : versionEnd + 1, defines);
+
+    GLuint computeShader = compileShader(source, GL_COMPUTE_SHADER);
+    if (computeShader == 0) {
+        std::cerr << "ERROR: Failed to compile compute shader: " << computePath << "\n";
+        return false;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, computeShader);
+    glLinkProgram(program);
+    glDeleteShader(computeShader);
+    if (!checkLinkErrors(program)) {
+        glDeleteProgram(program);
+        std::cerr << "ERROR: Failed to link compute program: " << computePath << "\n";
+        return false;
+    }
+
+    if (m_programID != 0) glDeleteProgram(m_programID);
+    m_programID = program;
+    m_uniformCache.clear();
+    return true;
+}
+
 void ShaderProgram::use() const {
     if (m_programID != 0) {
         glUseProgram(m_programID);
@@ -94,7 +127,8 @@ GLuint ShaderProgram::compileShader(const std::string& source, GLenum type) {
     glShaderSource(shader, 1, &sourceCStr, nullptr);
     glCompileShader(shader);
 
-    if (!checkCompileErrors(shader, type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT")) {
+    const char* typeName = type == GL_VERTEX_SHADER ? "VERTEX" : type == GL_FRAGMENT_SHADER ? "FRAGMENT" : "COMPUTE";
+    if (!checkCompileErrors(shader, typeName)) {
         glDeleteShader(shader);
         return 0;
     }
@@ -173,6 +207,10 @@ void ShaderProgram::setUniform(const std::string& name, float value) {
     glUniform1f(getUniformLocation(name), value);
 }
 
+void ShaderProgram::setUniform(const std::string& name, double value) {
+    glUniform1d(getUniformLocation(name), value);
+}
+
 void ShaderProgram::setUniform(const std::string& name, const glm::vec2& value) {
     glUniform2fv(getUniformLocation(name), 1, glm::value_ptr(value));
 }
@@ -192,3 +230,7 @@ void ShaderProgram::setUniform(const std::string& name, const glm::mat3& value)
 void ShaderProgram::setUniform(const std::string& name, const glm::mat4& value) {
     glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
 }
+
+void ShaderProgram::setUniform(const std::string& name, const float* values, int count) {
+    glUniform1fv(getUniformLocation(name), count, values);
+}
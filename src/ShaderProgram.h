@@ -29,6 +29,13 @@ public:
      */
     bool loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath);
 
+    /**
+     * @brief Load and compile a compute shader from a file
+     * @param defines Lines inserted after the #version line (e.g. "#define N 256\n")
+     * @return true if successful, false otherwise
+     */
+    bool loadComputeFromFile(const std::string& computePath, const std::string& defines = "");
+
     /**
      * @brief Activate this shader program
      */
@@ -48,11 +55,13 @@ public:
     void setUniform(const std::string& name, bool value);
     void setUniform(const std::string& name, int value);
     void setUniform(const std::string& name, float value);
+    void setUniform(const std::string& name, double value);
     void setUniform(const std::string& name, const glm::vec2& value);
     void setUniform(const std::string& name, const glm::vec3& value);
     void setUniform(const std::string& name, const glm::vec4& value);
     void setUniform(const std::string& name, const glm::mat3& value);
     void setUniform(const std::string& name, const glm::mat4& value);
+    void setUniform(const std::string& name, const float* values, int count);   // float array
 
 private:
     GLuint m_programID;
@@ -71,7 +80,7 @@ private:
     /**
      * @brief Compile a shader
      * @param source Shader source code
-     * @param type GL_VERTEX_SHADER or GL_FRAGMENT_SHADER
+     * @param type GL_VERTEX_SHADER, GL_FRAGMENT_SHADER or GL_COMPUTE_SHADER
      * @return Shader ID or 0 on failure
      */
     GLuint compileShader(const std::string& source, GLenum type);
@@ -0,0 +1,131 @@
+#include "SurfaceReadback.h"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+SurfaceReadback::~SurfaceReadback() {
+    release();
+}
+
+bool SurfaceReadback::initialize(GLuint texture, int size, int level, int cascadeCount) {
+    release();
+    m_size = size;
+    m_level = level;
+    m_cascadeCount = cascadeCount;
+    m_texels.assign(static_cast<size_t>(cascadeCount) * size * size * 3, 0.0f);
+
+    // One buffer per slot holding every cascade's layer
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(m_texels.size() * sizeof(float));
+    for (Slot& slot : m_slots) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // The texture format must be readable through a framebuffer
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, level, 0);
+    GLenum status = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER);
+    glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR: Surface readback framebuffer incomplete (0x" << std::hex << status << std::dec << ")\n";
+        release();
+        return false;
+    }
+    return true;
+}
+
+bool SurfaceReadback::request(GLuint texture, const int* layers, double time) {
+    if (m_inFlight == RING_SIZE) return false;
+    Slot& slot = m_slots[m_next];
+
+    GLint previousFramebuffer = 0;
+    GLint previousAlignment = 4;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_PACK_ALIGNMENT, &previousAlignment);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    // The simulation writes the layers with imageStore; framebuffer reads
+    // are only guaranteed to see those writes after this barrier
+    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+
+    // Into the buffer, so glReadPixels returns at once
+    size_t layerBytes = static_cast<size_t>(m_size) * m_size * 3 * sizeof(float);
+    bool complete = true;
+    for (int c = 0; c < m_cascadeCount && complete; ++c) {
+        glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, m_level, layers[c]);
+        complete = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (complete) {
+            glReadPixels(0, 0, m_size, m_size, GL_RGB, GL_FLOAT,
+                         reinterpret_cast<void*>(static_cast<uintptr_t>(c * layerBytes)));
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, previousAlignment);
+    glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+    if (!complete) {
+        std::cerr << "ERROR: Surface readback framebuffer incomplete\n";
+        return false;
+    }
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.time = time;
+    m_next = (m_next + 1) % RING_SIZE;
+    ++m_inFlight;
+    return true;
+}
+
+bool SurfaceReadback::poll() {
+    // Fences signal in order: skip to the newest finished copy
+    int newest = -1;
+    while (m_inFlight > 0) {
+        Slot& slot = m_slots[m_oldest];
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        newest = m_oldest;
+        m_oldest = (m_oldest + 1) % RING_SIZE;
+        --m_inFlight;
+    }
+    if (newest < 0) return false;
+
+    Slot& slot = m_slots[newest];
+    size_t bytes = m_texels.size() * sizeof(float);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_READ_BIT);
+    bool mapped = data != nullptr;
+    if (mapped) {
+        std::memcpy(m_texels.data(), data, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        m_frameTime = slot.time;
+        m_hasFrame = true;
+    } else {
+        std::cerr << "ERROR: Failed to map surface readback buffer\n";
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return mapped;
+}
+
+void SurfaceReadback::release() {
+    for (Slot& slot : m_slots) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        if (slot.buffer) glDeleteBuffers(1, &slot.buffer);
+        slot = Slot();
+    }
+    if (m_framebuffer) glDeleteFramebuffers(1, &m_framebuffer);
+    m_framebuffer = 0;
+    m_next = m_oldest = m_inFlight = 0;
+    m_hasFrame = false;
+    m_frameTime = 0.0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Asynchronous copies of displacement layers back to the CPU
+ *
+ * request() queues glReadPixels of one level of the newest layer of every
+ * cascade into a pixel-pack buffer and fences it; poll() takes the newest
+ * copy whose fence has signaled, without ever waiting. With RING_SIZE
+ * buffers in flight a frame typically arrives one or two frames after it
+ * was requested; when all of them are still pending, the request is
+ * dropped rather than stalling the pipeline.
+ */
+class SurfaceReadback {
+public:
+    static constexpr int RING_SIZE = 3;
+
+    SurfaceReadback() = default;
+    ~SurfaceReadback();
+
+    SurfaceReadback(const SurfaceReadback&) = delete;
+    SurfaceReadback& operator=(const SurfaceReadback&) = delete;
+
+    /**
+     * @param texture Texture that will be read back (checked for readability)
+     * @param size Texels per side of the level read back
+     * @param level Mip level read back
+     * @return false if the texture level cannot be attached for reading
+     */
+    bool initialize(GLuint texture, int size, int level, int cascadeCount);
+
+    /**
+     * @brief Queue a copy of one layer per cascade
+     * @param texture RGB(A)32F 2D array texture
+     * @param layers Layer of each cascade
+     * @param time Simulation time of the frame, returned with it
+     * @return false if every buffer is still in flight (the frame is
+     *         skipped) or a layer cannot be attached for reading
+     */
+    bool request(GLuint texture, const int* layers, double time);
+
+    /**
+     * @brief Collect finished copies without waiting
+     * @return true if a newer frame became available
+     */
+    bool poll();
+
+    bool hasFrame() const { return m_hasFrame; }
+    double getFrameTime() const { return m_frameTime; }     // Time passed to request()
+    int getSize() const { return m_size; }
+    int getLevel() const { return m_level; }
+    int getCascadeCount() const { return m_cascadeCount; }
+
+    /**
+     * @brief RGB texels (dx, dy, dz) of a cascade in the latest frame, row-major
+     */
+    const float* getTexels(int cascade) const {
+        return m_texels.data() + static_cast<size_t>(cascade) * m_size * m_size * 3;
+    }
+
+private:
+    struct Slot {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;     // Null while the slot is free
+        double time = 0.0;
+    };
+
+    Slot m_slots[RING_SIZE];
+    int m_next = 0;                 // Slot of the next request
+    int m_oldest = 0;               // Oldest slot in flight
+    int m_inFlight = 0;
+    GLuint m_framebuffer = 0;
+    int m_size = 0;
+    int m_level = 0;
+    int m_cascadeCount = 0;
+    std::vector<float> m_texels;
+    double m_frameTime = 0.0;
+    bool m_hasFrame = false;
+
+    void release();
+};
@@ -0,0 +1,89 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int workerCount)
+    : m_task(nullptr)
+    , m_count(0)
+    , m_next(0)
+    , m_busyWorkers(0)
+    , m_generation(0)
+    , m_stop(false) {
+
+    if (workerCount < 0) {
+        int hardware = static_cast<int>(std::thread::hardware_concurrency());
+        workerCount = hardware > 1 ? hardware - 1 : 0;
+    }
+
+    m_workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& task) {
+    if (count <= 0) return;
+
+    // Nothing to share: run inline without touching the workers
+    if (m_workers.empty() || count == 1) {
+        for (int i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(m_submitMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_next.store(0);
+        m_busyWorkers = static_cast<int>(m_workers.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    // The caller works too, then waits for the workers to finish
+    drain(task, count);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::workerLoop() {
+    unsigned seenGeneration = 0;
+    for (;;) {
+        const std::function<void(int)>* task;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+            if (m_stop) return;
+            seenGeneration = m_generation;
+            task = m_task;
+            count = m_count;
+        }
+
+        drain(*task, count);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busyWorkers == 0) m_done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::drain(const std::function<void(int)>& task, int count) {
+    for (int i = m_next.fetch_add(1); i < count; i = m_next.fetch_add(1)) {
+        task(i);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size worker pool for data-parallel loops
+ *
+ * The calling thread takes part in every parallelFor, so a pool created
+ * with zero workers simply runs the loop inline.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Create the worker threads
+     * @param workerCount Number of extra threads (-1 = hardware threads - 1)
+     */
+    explicit ThreadPool(int workerCount = -1);
+    ~ThreadPool();
+
+    // Non-copyable
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Run task(i) for every i in [0, count) and wait for completion
+     * @param count Number of work items
+     * @param task Work item body, called concurrently from several threads
+     */
+    void parallelFor(int count, const std::function<void(int)>& task);
+
+    /**
+     * @brief Number of threads that execute work (workers + caller)
+     */
+    int getThreadCount() const { return static_cast<int>(m_workers.size()) + 1; }
+
+private:
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;        // Workers wait for a new job
+    std::condition_variable m_done;        // Caller waits for job completion
+    std::mutex m_submitMutex;              // Serializes parallelFor callers
+
+    // Current job (valid while m_generation is unchanged)
+    const std::function<void(int)>* m_task;
+    int m_count;
+    std::atomic<int> m_next;
+    int m_busyWorkers;
+    unsigned m_generation;
+    bool m_stop;
+
+    /**
+     * @brief Worker thread main loop
+     */
+    void workerLoop();
+
+    /**
+     * @brief Pull and execute work items until the job is exhausted
+     */
+    void drain(const std::function<void(int)>& task, int count);
+};
@@ -0,0 +1,269 @@
+#include "WaveSpectrum.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCEANFFT_HAS_SSE 1
+#endif
+
+namespace {
+
+constexpr float PI = 3.14159265358979323846f;
+constexpr float GRAVITY = 9.81f;    // m/s², as OceanFFT
+
+/**
+ * @brief exp(x) to ~2 ulp: 2^n times a degree-5 polynomial on [-ln2/2, ln2/2]
+ *
+ * Same steps as the SSE version below, so batch tails match their lanes.
+ */
+inline float fastExp(float x) {
+    x = std::min(std::max(x, -87.0f), 88.0f);
+    float n = std::floor(x * 1.44269504088896341f + 0.5f);
+    x = x - n * 0.693359375f + n * 2.12194440e-4f;
+    float y = 1.9875691500e-4f;
+    y = y * x + 1.3981999507e-3f;
+    y = y * x + 8.3334519073e-3f;
+    y = y * x + 4.1665795894e-2f;
+    y = y * x + 1.6666665459e-1f;
+    y = y * x + 5.0000001201e-1f;
+    y = y * x * x + x + 1.0f;
+    return std::ldexp(y, static_cast<int>(n));
+}
+
+// Scalar operations of the model templates
+inline float vsqrt(float x) { return std::sqrt(x); }
+inline float vexp(float x) { return fastExp(x); }
+inline float vmin(float a, float b) { return std::min(a, b); }
+inline float vmax(float a, float b) { return std::max(a, b); }
+inline float selectLess(float a, float b, float ifLess, float otherwise) { return a < b ? ifLess : otherwise; }
+
+#ifdef OCEANFFT_HAS_SSE
+/**
+ * @brief Four bins of a batch, with the operators the model templates use
+ */
+struct Lanes {
+    __m128 v;
+    Lanes(__m128 value) : v(value) {}
+    Lanes(float value) : v(_mm_set1_ps(value)) {}
+};
+
+inline Lanes operator+(Lanes a, Lanes b) { return _mm_add_ps(a.v, b.v); }
+inline Lanes operator-(Lanes a, Lanes b) { return _mm_sub_ps(a.v, b.v); }
+inline Lanes operator*(Lanes a, Lanes b) { return _mm_mul_ps(a.v, b.v); }
+inline Lanes operator/(Lanes a, Lanes b) { return _mm_div_ps(a.v, b.v); }
+inline Lanes operator-(Lanes a) { return _mm_sub_ps(_mm_setzero_ps(), a.v); }
+inline Lanes vsqrt(Lanes x) { return _mm_sqrt_ps(x.v); }
+inline Lanes vmin(Lanes a, Lanes b) { return _mm_min_ps(a.v, b.v); }
+inline Lanes vmax(Lanes a, Lanes b) { return _mm_max_ps(a.v, b.v); }
+inline Lanes selectLess(Lanes a, Lanes b, Lanes ifLess, Lanes otherwise) {
+    __m128 mask = _mm_cmplt_ps(a.v, b.v);
+    return _mm_or_ps(_mm_and_ps(mask, ifLess.v), _mm_andnot_ps(mask, otherwise.v));
+}
+
+inline Lanes vexp(Lanes value) {
+    __m128 x = _mm_min_ps(_mm_max_ps(value.v, _mm_set1_ps(-87.0f)), _mm_set1_ps(88.0f));
+
+    // n = round(x / ln2), floor by truncation and correction
+    __m128 t = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)), _mm_set1_ps(0.5f));
+    __m128 n = _mm_cvtepi32_ps(_mm_cvttps_epi32(t));
+    n = _mm_sub_ps(n, _mm_and_ps(_mm_cmpgt_ps(n, t), _mm_set1_ps(1.0f)));
+    x = _mm_add_ps(_mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(0.693359375f))),
+                   _mm_mul_ps(n, _mm_set1_ps(2.12194440e-4f)));
+
+    __m128 y = _mm_set1_ps(1.9875691500e-4f);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.3981999507e-3f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(8.3334519073e-3f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(4.1665795894e-2f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.6666665459e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(5.0000001201e-1f));
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, x), x), x), _mm_set1_ps(1.0f));
+
+    // 2^n through the exponent bits
+    __m128i exponent = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(y, _mm_castsi128_ps(exponent));
+}
+#endif
+
+/**
+ * @brief Model policies: the radial part of the spectrum at |k| (> 0)
+ *
+ * Phillips returns P(k) without its directional term; the empirical models
+ * F(k) = S(ω) dω/dk / k for ω = √(gk), the spreading being applied after.
+ */
+struct PhillipsModel {
+    float amplitude;
+    float largestWave;      // L = V²/g
+    float smallestWave;     // l, damps waves much shorter than L
+
+    template <typename T>
+    T operator()(T k) const {
+        // A exp(-1/(kL)²) exp(-k²l²) / k⁴, both exponentials in one
+        T k2 = k * k;
+        T exponent = -(T(1.0f) / (k2 * T(largestWave * largestWave))) - k2 * T(smallestWave * smallestWave);
+        return T(amplitude) * vexp(exponent) / (k2 * k2);
+    }
+};
+
+/**
+ * @brief S(ω) of Pierson-Moskowitz, optionally with the JONSWAP peak and the TMA depth factor
+ */
+template <bool PeakEnhanced, bool FiniteDepth>
+struct EmpiricalModel {
+    float alpha;
+    float peakOmega;
+    float logGamma;         // ln γ
+    float depthScale;       // √(h/g), ω_h = ω √(h/g)
+
+    template <typename T>
+    T operator()(T k) const {
+        T omega = vsqrt(T(GRAVITY) * k);
+        T ratio = T(peakOmega) / omega;
+        T ratio2 = ratio * ratio;
+        T omega2 = omega * omega;
+
+        // α g² ω⁻⁵ exp(-5/4 (ωp/ω)⁴)
+        T s = T(alpha * GRAVITY * GRAVITY) / (omega2 * omega2 * omega) * vexp(T(-1.25f) * ratio2 * ratio2);
+
+        if constexpr (PeakEnhanced) {
+            // γ^r, r = exp(-(ω - ωp)² / (2σ²ωp²)), σ = 0.07 below the peak, 0.09 above
+            T sigma = selectLess(T(peakOmega), omega, T(0.09f), T(0.07f));
+            // Far from the peak r would be tiny enough for x² in the outer
+            // exp to underflow, which is slow; r >= e⁻³⁰ changes nothing
+            T offset = (omega - T(peakOmega)) / (sigma * T(peakOmega));
+            T r = vexp(T(-0.5f) * vmin(offset * offset, T(60.0f)));
+            s = s * vexp(T(logGamma) * r);
+        }
+        if constexpr (FiniteDepth) {
+            // Kitaigorodskii depth factor Φ(ω_h)
+            T wh = vmin(omega * T(depthScale), T(2.0f));
+            T below = T(0.5f) * wh * wh;
+            T rest = T(2.0f) - wh;
+            s = s * selectLess(wh, T(1.0f), below, T(1.0f) - T(0.5f) * rest * rest);
+        }
+
+        // dω/dk = g / (2ω), and 1/k from the polar to Cartesian k
+        return s * T(GRAVITY) / (T(2.0f) * omega * k);
+    }
+};
+
+/**
+ * @brief Radial part of a batch, 4 bins at a time where SSE is available
+ */
+template <typename Model>
+void evaluateRadial(const Model& model, const float* radius, int count, float kScale, float* out) {
+    // |k| below this is the mean level, which carries no wave
+    const float MIN_K = 0.0001f;
+    int i = 0;
+#ifdef OCEANFFT_HAS_SSE
+    const __m128 scale = _mm_set1_ps(kScale);
+    for (; i + 4 <= count; i += 4) {
+        __m128 k = _mm_mul_ps(_mm_loadu_ps(radius + i), scale);
+        __m128 valid = _mm_cmpge_ps(k, _mm_set1_ps(MIN_K));
+        Lanes value = model(Lanes(_mm_max_ps(k, _mm_set1_ps(MIN_K))));
+        _mm_storeu_ps(out + i, _mm_and_ps(valid, value.v));
+    }
+#endif
+    for (; i < count; ++i) {
+        float k = radius[i] * kScale;
+        out[i] = k >= MIN_K ? model(k) : 0.0f;
+    }
+}
+
+} // namespace
+
+bool operator==(const SpectrumDesc& a, const SpectrumDesc& b) {
+    return a.model == b.model && a.spreading == b.spreading && a.fetch == b.fetch
+        && a.peakEnhancement == b.peakEnhancement && a.depth == b.depth && a.spreadExponent == b.spreadExponent;
+}
+
+bool operator==(const SpectrumComponent& a, const SpectrumComponent& b) {
+    return a.spectrum == b.spectrum && a.windSpeed == b.windSpeed && a.windDirection == b.windDirection
+        && a.amplitude == b.amplitude;
+}
+
+WaveSpectrum::WaveSpectrum(const SpectrumDesc& desc, float windSpeed, const glm::vec2& windDirection, float amplitude)
+    : m_desc(desc)
+    , m_windAngle(std::atan2(windDirection.y, windDirection.x))
+    , m_amplitude(amplitude)
+    , m_largestWave(windSpeed * windSpeed / GRAVITY)
+    , m_alpha(0.0081f)
+    , m_peakOmega(0.0f) {
+
+    // Calm seas still get finite constants
+    float wind = std::max(windSpeed, 0.1f);
+    float fetch = std::max(desc.fetch, 1.0f);
+    if (desc.model == SpectrumModel::PiersonMoskowitz) {
+        m_peakOmega = 0.855f * GRAVITY / wind;
+    } else if (desc.model != SpectrumModel::Phillips) {
+        // Fetch-limited growth (Hasselmann et al. 1973)
+        m_alpha = 0.076f * std::pow(wind * wind / (fetch * GRAVITY), 0.22f);
+        m_peakOmega = 22.0f * std::cbrt(GRAVITY * GRAVITY / (wind * fetch));
+    }
+    buildSpreadingTable();
+}
+
+void WaveSpectrum::buildSpreadingTable() {
+    m_spreading.resize(SPREADING_TABLE_SIZE + 1);
+    const float DONELAN_BANNER_BETA = 2.28f;    // β at ω = ωp
+    for (int i = 0; i <= SPREADING_TABLE_SIZE; ++i) {
+        float theta = PI * i / SPREADING_TABLE_SIZE;
+        float value = 0.0f;
+        switch (m_desc.spreading) {
+            case DirectionalSpreading::Cos2:
+                value = std::cos(theta) * std::cos(theta);
+                break;
+            case DirectionalSpreading::Cos2s:
+                value = std::pow(std::cos(0.5f * theta), 2.0f * std::max(m_desc.spreadExponent, 0.0f));
+                break;
+            case DirectionalSpreading::DonelanBanner: {
+                float sech = 1.0f / std::cosh(DONELAN_BANNER_BETA * theta);
+                value = sech * sech;
+                break;
+            }
+        }
+        m_spreading[i] = value;
+    }
+
+    // Phillips keeps the peak at 1 (A absorbs the rest); the empirical
+    // models need ∫ D dθ = 1 over the circle (trapezoids, D even in θ)
+    if (m_desc.model == SpectrumModel::Phillips) return;
+    double integral = 0.0;
+    for (int i = 0; i < SPREADING_TABLE_SIZE; ++i) integral += 0.5 * (m_spreading[i] + m_spreading[i + 1]);
+    integral *= 2.0 * PI / SPREADING_TABLE_SIZE;
+    float scale = integral > 0.0 ? static_cast<float>(1.0 / integral) : 0.0f;
+    for (float& value : m_spreading) value *= scale;
+}
+
+void WaveSpectrum::evaluate(const float* radius, const float* angle, int count, float kScale, float* out) const {
+    float depthScale = std::sqrt(std::max(m_desc.depth, 0.01f) / GRAVITY);
+    float logGamma = std::log(std::max(m_desc.peakEnhancement, 1.0f));
+    switch (m_desc.model) {
+        case SpectrumModel::Phillips:
+            evaluateRadial(PhillipsModel{ m_amplitude, m_largestWave, m_largestWave / 1000.0f },
+                           radius, count, kScale, out);
+            break;
+        case SpectrumModel::PiersonMoskowitz:
+            evaluateRadial(EmpiricalModel<false, false>{ m_alpha, m_peakOmega, 0.0f, 0.0f },
+                           radius, count, kScale, out);
+            break;
+        case SpectrumModel::JONSWAP:
+            evaluateRadial(EmpiricalModel<true, false>{ m_alpha, m_peakOmega, logGamma, 0.0f },
+                           radius, count, kScale, out);
+            break;
+        case SpectrumModel::TMA:
+            evaluateRadial(EmpiricalModel<true, true>{ m_alpha, m_peakOmega, logGamma, depthScale },
+                           radius, count, kScale, out);
+            break;
+    }
+
+    // Spreading by the angle to the wind, interpolated from the table
+    const float toIndex = SPREADING_TABLE_SIZE / PI;
+    for (int i = 0; i < count; ++i) {
+        float theta = std::abs(angle[i] - m_windAngle);
+        if (theta > PI) theta = 2.0f * PI - theta;
+        float position = theta * toIndex;
+        int index = std::min(static_cast<int>(position), SPREADING_TABLE_SIZE - 1);
+        float fraction = position - index;
+        out[i] *= m_spreading[index] + fraction * (m_spreading[index + 1] - m_spreading[index]);
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Wave spectrum models
+ *
+ * Phillips is the original Tessendorf model (arbitrary amplitude). The
+ * others are empirical frequency spectra S(ω) in m²·s for fully developed
+ * (Pierson-Moskowitz), fetch-limited (JONSWAP) and finite-depth (TMA)
+ * seas, converted to wavenumbers with deep-water dispersion.
+ */
+enum class SpectrumModel {
+    Phillips = 0,
+    PiersonMoskowitz,
+    JONSWAP,
+    TMA
+};
+
+/**
+ * @brief Directional spreading D(θ) around the wind direction
+ *
+ * Cos2 is Phillips' (k̂·ŵ)², which also feeds waves running against the
+ * wind. Cos2s is Longuet-Higgins' cos^2s(θ/2) and DonelanBanner the
+ * sech²(βθ) fit at the spectral peak (β = 2.28); both only spread forward.
+ */
+enum class DirectionalSpreading {
+    Cos2 = 0,
+    Cos2s,
+    DonelanBanner
+};
+
+/**
+ * @brief Spectrum model and its parameters (wind speed, direction and the
+ *        Phillips amplitude complete it in a SpectrumComponent)
+ */
+struct SpectrumDesc {
+    SpectrumModel model = SpectrumModel::Phillips;
+    DirectionalSpreading spreading = DirectionalSpreading::Cos2;
+    float fetch = 100000.0f;        // Distance over which the wind blows, m (JONSWAP, TMA)
+    float peakEnhancement = 3.3f;   // JONSWAP γ
+    float depth = 20.0f;            // Water depth, m (TMA)
+    float spreadExponent = 8.0f;    // s of Cos2s (larger is narrower)
+};
+
+bool operator==(const SpectrumDesc& a, const SpectrumDesc& b);
+inline bool operator!=(const SpectrumDesc& a, const SpectrumDesc& b) { return !(a == b); }
+
+/**
+ * @brief One wave system of a sea state (local wind sea, a distant swell...)
+ *
+ * Components are independent, so their spectra add: the sea state is the
+ * sum of their densities under a single set of random phases.
+ */
+struct SpectrumComponent {
+    SpectrumDesc spectrum;
+    float windSpeed = 30.0f;                // m/s (for a swell, of the wind that raised it)
+    glm::vec2 windDirection{ 1.0f, 0.0f };  // Normalized
+    float amplitude = 0.0002f;              // Phillips A
+};
+
+bool operator==(const SpectrumComponent& a, const SpectrumComponent& b);
+inline bool operator!=(const SpectrumComponent& a, const SpectrumComponent& b) { return !(a == b); }
+
+/**
+ * @brief One spectrum model with its constants, evaluated in batches
+ *
+ * evaluate() runs the radial part of the model over a batch of |k|
+ * (4 bins per SSE instruction where available) and multiplies in the
+ * spreading from a 1D table over the angle to the wind, so a full grid
+ * costs one fast exp() per model term and a table lookup per bin.
+ */
+class WaveSpectrum {
+public:
+    static constexpr int SPREADING_TABLE_SIZE = 1024;  // Entries over |θ| in [0, π]
+
+    /**
+     * @param amplitude Phillips constant A (ignored by the other models)
+     */
+    WaveSpectrum(const SpectrumDesc& desc, float windSpeed, const glm::vec2& windDirection, float amplitude);
+    explicit WaveSpectrum(const SpectrumComponent& component)
+        : WaveSpectrum(component.spectrum, component.windSpeed, component.windDirection, component.amplitude) {}
+
+    /**
+     * @brief Spectral density of a batch of bins
+     *
+     * Phillips returns P(k) with the shape of D (peak 1); the empirical
+     * models the wavenumber density F(k) = S(ω) dω/dk D(θ) / k in m⁴ with
+     * D normalized over the circle, so that the variance of the surface is
+     * ∫ F dk. Bins with |k| ≈ 0 are 0.
+     * @param radius |n| of each bin, so that |k| = radius * kScale
+     * @param angle atan2(nz, nx) of each bin
+     */
+    void evaluate(const float* radius, const float* angle, int count, float kScale, float* out) const;
+
+    /**
+     * @brief Whether the model is Phillips (arbitrary units, see evaluate)
+     */
+    bool isPhillips() const { return m_desc.model == SpectrumModel::Phillips; }
+
+private:
+    SpectrumDesc m_desc;
+    float m_windAngle;      // atan2 of the wind direction
+    float m_amplitude;
+
+    // Model constants
+    float m_largestWave;    // Phillips V²/g
+    float m_alpha;          // Phillips-Miles constant (PM, JONSWAP, TMA)
+    float m_peakOmega;      // ω at the spectral peak
+
+    std::vector<float> m_spreading;     // D(|θ|), SPREADING_TABLE_SIZE + 1 entries
+
+    void buildSpreadingTable();
+};
@@ -4,7 +4,7 @@
 int main() {
     std::cout << "===========================================\n";
     std::cout << "    Ocean FFT Real-Time Simulator\n";
-    std::cout << "    Using Phillips Spectrum + FFTW3\n";
+    std::cout << "    Using Phillips Spectrum + Inverse FFT\n";
     std::cout << "===========================================\n\n";
 
     // Create and initialize application